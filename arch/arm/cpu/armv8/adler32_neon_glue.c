@@ -0,0 +1,38 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * adler32_neon_glue.c - Adler-32 checksum using NEON
+ *
+ * Copyright (C) 2026 Rockchip Electronics Co., Ltd
+ */
+
+#include <common.h>
+#include <u-boot/zlib.h>
+
+#define ADLER32_BASE	65521
+#define ADLER32_BLOCK	32
+
+extern u32 adler32_neon_blocks(u32 adler, const u8 *buf, size_t blocks);
+
+uLong adler32(uLong adler, const Bytef *buf, uInt len)
+{
+	size_t blocks = len / ADLER32_BLOCK;
+	u32 s1, s2;
+
+	if (!buf)
+		return 1;
+
+	if (blocks) {
+		adler = adler32_neon_blocks(adler, buf, blocks);
+		buf += blocks * ADLER32_BLOCK;
+		len -= blocks * ADLER32_BLOCK;
+	}
+
+	s1 = adler & 0xffff;
+	s2 = (adler >> 16) & 0xffff;
+	while (len--) {
+		s1 += *buf++;
+		s2 += s1;
+	}
+
+	return (s1 % ADLER32_BASE) | ((s2 % ADLER32_BASE) << 16);
+}
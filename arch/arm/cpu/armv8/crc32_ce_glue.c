@@ -0,0 +1,37 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * crc32_ce_glue.c - CRC32 and CRC32C using the ARMv8 CRC32 instructions
+ *
+ * Copyright (C) 2026 Rockchip Electronics Co., Ltd
+ */
+
+#include <common.h>
+#include <u-boot/crc.h>
+
+#define CRC32C_POLY_LE	0x82f63b78
+
+extern u32 crc32_armv8_le(u32 crc, const u8 *p, size_t len);
+extern u32 crc32c_armv8_le(u32 crc, const u8 *p, size_t len);
+
+uint32_t crc32_no_comp(uint32_t crc, const unsigned char *buf, uint len)
+{
+	return crc32_armv8_le(crc, buf, len);
+}
+
+#ifdef CONFIG_CRC32C
+uint32_t crc32c_cal(uint32_t crc, const char *data, int length,
+		    uint32_t *crc32c_table)
+{
+	/*
+	 * The instructions only know the Castagnoli polynomial, which
+	 * crc32c_init() leaves in entry 128 of the table.
+	 */
+	if (crc32c_table[128] == CRC32C_POLY_LE)
+		return crc32c_armv8_le(crc, (const u8 *)data, length);
+
+	while (length--)
+		crc = crc32c_table[(u8)(crc ^ *data++)] ^ (crc >> 8);
+
+	return crc;
+}
+#endif
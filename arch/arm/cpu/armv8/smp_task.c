@@ -0,0 +1,69 @@
+/*
+ * (C) Copyright 2026 Rockchip Electronics Co., Ltd
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <smp_task.h>
+#include <asm/psci.h>
+#include <asm/system.h>
+#include <asm/armv8/mmu.h>
+#include <linux/arm-smccc.h>
+
+/*
+ * Secondary cores are started and stopped through PSCI, which every
+ * ARMv8 platform running U-Boot on top of ARM Trusted Firmware provides.
+ */
+
+extern char smp_task_entry[];
+
+static unsigned long smp_task_psci(unsigned long fn, unsigned long arg0,
+				   unsigned long arg1, unsigned long arg2)
+{
+	struct arm_smccc_res res;
+
+	arm_smccc_smc(fn, arg0, arg1, arg2, 0, 0, 0, 0, &res);
+
+	return res.a0;
+}
+
+int smp_task_arch_cpu_on(u64 mpidr, void *ctx)
+{
+	return (int)smp_task_psci(ARM_PSCI_0_2_FN64_CPU_ON, mpidr,
+				  (unsigned long)smp_task_entry,
+				  (unsigned long)ctx);
+}
+
+bool smp_task_arch_cpu_is_off(u64 mpidr)
+{
+	return smp_task_psci(ARM_PSCI_0_2_FN64_AFFINITY_INFO, mpidr, 0, 0) ==
+	       PSCI_AFFINITY_LEVEL_OFF;
+}
+
+/*
+ * Share the page tables of the boot CPU. Their address comes in the
+ * flushed per-core context, gd itself may only be up to date in the
+ * caches of the boot CPU. The firmware hands over the core with clean
+ * caches, so unlike dcache_enable() there is no set/way invalidate here,
+ * which would discard dirty lines of the boot CPU in the shared cache
+ * levels.
+ */
+void smp_task_arch_secondary_init(ulong tlb_addr)
+{
+	int el = current_el();
+
+	__asm_invalidate_tlb_all();
+	set_ttbr_tcr_mair(el, tlb_addr, get_tcr(el, NULL, NULL),
+			  MEMORY_ATTRIBUTES);
+	set_sctlr(get_sctlr() | CR_M | CR_C | CR_I);
+}
+
+void __noreturn smp_task_arch_cpu_off(void)
+{
+	/* PSCI cleans the caches of the core on its way down */
+	smp_task_psci(ARM_PSCI_0_2_FN_CPU_OFF, 0, 0, 0);
+
+	for (;;)
+		__asm__ __volatile__("wfe" : : : "memory");
+}
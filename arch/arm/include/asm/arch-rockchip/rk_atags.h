@@ -21,6 +21,7 @@
 #define ATAG_SOC_INFO		0x54410057
 #define ATAG_BOOT1_PARAM	0x54410058
 #define ATAG_PSTORE		0x54410059
+#define ATAG_MMC_TUNING		0x5441005a
 #define ATAG_MAX		0x544100ff
 
 /* Tag size and offset */
@@ -183,6 +184,20 @@ struct tag_pstore {
 	u32 hash;
 } __packed;
 
+struct tag_mmc_tuning {
+	u32 version;
+	u32 count;
+	struct {
+		u32 cid[4];
+		u32 host;
+		u32 clock;
+		u32 timing;
+		u32 phase;
+	} rec[4];
+	u32 reserved[2];
+	u32 hash;
+} __packed;
+
 struct tag_core {
 	u32 flags;
 	u32 pagesize;
@@ -209,6 +224,7 @@ struct tag {
 		struct tag_soc_info	soc;
 		struct tag_boot1p	boot1p;
 		struct tag_pstore	pstore;
+		struct tag_mmc_tuning	mmc_tuning;
 	} u;
 } __aligned(4);
 
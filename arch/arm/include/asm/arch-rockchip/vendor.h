@@ -25,6 +25,7 @@
 #define LAN_RGMII_DL_ID			16
 #define EINK_VCOM_ID			17
 #define FIRMWARE_VER_ID			18
+#define MMC_TUNING_ID			19
 
 struct vendor_item {
 	u16  id;
@@ -49,4 +50,10 @@ int vendor_handle_hdcp(struct vendor_item *vhead);
 
 void vendor_storage_fixup(void *blob);
 
+/*
+ * rockchip_mmc_tuning_sync - merge the MMC tuning results kept in the
+ * vendor storage with those of this boot, and keep both from now on.
+ */
+void rockchip_mmc_tuning_sync(void);
+
 #endif /* _ROCKCHIP_VENDOR_ */
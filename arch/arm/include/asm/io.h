@@ -320,6 +320,69 @@ out:
 	return retval;
 }
 
+#elif defined(CONFIG_ARM64)
+/*
+ * memcpy() and memset() make no promise about the width or alignment of
+ * their accesses, and unaligned ones fault on Device memory. Use naturally
+ * aligned accesses of at most 64 bits for I/O memory instead.
+ */
+static inline void __memcpy_io(unsigned long to, unsigned long from,
+			       size_t count)
+{
+	while (count && ((to | from) & 7)) {
+		__raw_writeb(__raw_readb(from), to);
+		from++;
+		to++;
+		count--;
+	}
+
+	while (count >= 8) {
+		__raw_writeq(__raw_readq(from), to);
+		from += 8;
+		to += 8;
+		count -= 8;
+	}
+
+	while (count) {
+		__raw_writeb(__raw_readb(from), to);
+		from++;
+		to++;
+		count--;
+	}
+}
+
+static inline void __memset_io(unsigned long dst, int c, size_t count)
+{
+	u64 qc = (u8)c;
+
+	qc |= qc << 8;
+	qc |= qc << 16;
+	qc |= qc << 32;
+
+	while (count && (dst & 7)) {
+		__raw_writeb(c, dst);
+		dst++;
+		count--;
+	}
+
+	while (count >= 8) {
+		__raw_writeq(qc, dst);
+		dst += 8;
+		count -= 8;
+	}
+
+	while (count) {
+		__raw_writeb(c, dst);
+		dst++;
+		count--;
+	}
+}
+
+#define memset_io(a, b, c)	__memset_io((unsigned long)(a), (b), (c))
+#define memcpy_fromio(a, b, c)	__memcpy_io((unsigned long)(a), \
+					    (unsigned long)(b), (c))
+#define memcpy_toio(a, b, c)	__memcpy_io((unsigned long)(a), \
+					    (unsigned long)(b), (c))
 #else
 #define memset_io(a, b, c)		memset((void *)(a), (b), (c))
 #define memcpy_fromio(a, b, c)		memcpy((a), (void *)(b), (c))
@@ -23,6 +23,7 @@
 #include <linux/libfdt.h>
 #include <mapmem.h>
 #include <mp_boot.h>
+#include <smp_task.h>
 #include <fdt_support.h>
 #include <asm/bootm.h>
 #include <asm/secure.h>
@@ -107,10 +108,13 @@ static void announce_and_cleanup(bootm_headers_t *images, int fake)
 	 */
 	dm_remove_devices_flags(DM_REMOVE_ACTIVE_ALL);
 
+	/* Hand the secondary cores back to the firmware for the kernel */
+	smp_task_stop_all();
+
 	cleanup_before_linux();
 
 #ifdef CONFIG_MP_BOOT
-	mpb_post(4);
+	mpb_post(MPB_POST_KERNEL);
 #endif
 	us = (get_ticks() - gd->sys_start_tick) / (COUNTER_FREQUENCY / 1000000);
 	tt_us = get_ticks() / (COUNTER_FREQUENCY / 1000000);
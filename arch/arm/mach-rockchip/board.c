@@ -487,6 +487,9 @@ int board_late_init(void)
 #endif
 #ifdef CONFIG_ROCKCHIP_SET_SN
 	rockchip_set_serialno();
+#endif
+#if defined(CONFIG_MMC_TUNING_CACHE) && defined(CONFIG_ROCKCHIP_VENDOR_PARTITION)
+	rockchip_mmc_tuning_sync();
 #endif
 	setup_download_mode();
 	scan_run_cmd();
@@ -95,7 +95,7 @@ static void boot_devtype_init(void)
 		return;
 
 #ifdef CONFIG_MP_BOOT
-	mpb_post(0);
+	mpb_post(MPB_POST_BOOTDEV);
 #endif
 
 	/* configuration */
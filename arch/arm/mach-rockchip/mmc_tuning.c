@@ -0,0 +1,104 @@
+/*
+ * Keep MMC tuning results across boot stages and boots
+ *
+ * SPL hands what it tuned to U-Boot in ATAG_MMC_TUNING, so the boot
+ * device is not tuned twice. U-Boot keeps the results in the vendor
+ * storage, which lives on the boot device itself and therefore can only
+ * be synced from board_late_init(); cards brought up after that, like
+ * SD cards and rescans, reuse what an earlier boot found.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <mmc.h>
+#include <asm/arch/rk_atags.h>
+#include <asm/arch/vendor.h>
+
+#define MMC_TUNING_VERSION	1
+
+#if !defined(CONFIG_SPL_BUILD) && defined(CONFIG_ROCKCHIP_VENDOR_PARTITION)
+/* Set once the vendor storage was read back, until then it is not written */
+static bool vendor_synced;
+#endif
+
+static void mmc_tuning_pack(struct tag_mmc_tuning *t,
+			    const struct mmc_tuning_rec *recs, int count)
+{
+	BUILD_BUG_ON(sizeof(t->rec[0]) != sizeof(*recs));
+
+	memset(t, 0, sizeof(*t));
+	t->version = MMC_TUNING_VERSION;
+	t->count = min_t(int, count, ARRAY_SIZE(t->rec));
+	memcpy(t->rec, recs, t->count * sizeof(*recs));
+}
+
+static int mmc_tuning_unpack(const struct tag_mmc_tuning *t,
+			     struct mmc_tuning_rec *recs, int max)
+{
+	int count;
+
+	if (t->version != MMC_TUNING_VERSION)
+		return 0;
+
+	count = min_t(int, t->count, ARRAY_SIZE(t->rec));
+	count = min(count, max);
+	memcpy(recs, t->rec, count * sizeof(*recs));
+
+	return count;
+}
+
+int mmc_tuning_load(struct mmc_tuning_rec *recs, int max)
+{
+#ifdef CONFIG_ROCKCHIP_PRELOADER_ATAGS
+	struct tag *t;
+
+	t = atags_get_tag(ATAG_MMC_TUNING);
+	if (t)
+		return mmc_tuning_unpack(&t->u.mmc_tuning, recs, max);
+#endif
+	return 0;
+}
+
+void mmc_tuning_save(const struct mmc_tuning_rec *recs, int count)
+{
+	struct tag_mmc_tuning t;
+
+	mmc_tuning_pack(&t, recs, count);
+#ifdef CONFIG_SPL_BUILD
+#ifdef CONFIG_ROCKCHIP_PRELOADER_ATAGS
+	if (atags_set_tag(ATAG_MMC_TUNING, &t))
+		debug("%s: no room for the tuning tag\n", __func__);
+#endif
+#elif defined(CONFIG_ROCKCHIP_VENDOR_PARTITION)
+	if (vendor_synced &&
+	    vendor_storage_write(MMC_TUNING_ID, &t, sizeof(t)) != sizeof(t))
+		debug("%s: vendor storage write failed\n", __func__);
+#endif
+}
+
+#if !defined(CONFIG_SPL_BUILD) && defined(CONFIG_ROCKCHIP_VENDOR_PARTITION)
+void rockchip_mmc_tuning_sync(void)
+{
+	struct mmc_tuning_rec recs[MMC_TUNING_RECS];
+	const struct mmc_tuning_rec *cur;
+	struct tag_mmc_tuning t, old;
+	int count = 0;
+
+	if (vendor_storage_read(MMC_TUNING_ID, &old, sizeof(old)) ==
+	    sizeof(old))
+		count = mmc_tuning_unpack(&old, recs, MMC_TUNING_RECS);
+	else
+		memset(&old, 0, sizeof(old));
+
+	mmc_tuning_merge(recs, count);
+	vendor_synced = true;
+
+	/* Write back what this boot found */
+	count = mmc_tuning_get(&cur);
+	mmc_tuning_pack(&t, cur, count);
+	if (memcmp(&t, &old, sizeof(t)) &&
+	    vendor_storage_write(MMC_TUNING_ID, &t, sizeof(t)) != sizeof(t))
+		debug("%s: vendor storage write failed\n", __func__);
+}
+#endif
@@ -181,6 +181,7 @@ int atags_set_tag(u32 magic, void *tagdata)
 {
 	u32 length, size = 0, hash;
 	struct tag *t = (struct tag *)ATAGS_PHYS_BASE;
+	bool replace;
 
 #if !defined(CONFIG_TPL_BUILD) && !defined(CONFIG_FPGA_ROCKCHIP)
 	if (!atags_is_available())
@@ -256,6 +257,9 @@ int atags_set_tag(u32 magic, void *tagdata)
 	case ATAG_PSTORE:
 		size = tag_size(tag_pstore);
 		break;
+	case ATAG_MMC_TUNING:
+		size = tag_size(tag_mmc_tuning);
+		break;
 	};
 
 	if (!size)
@@ -264,6 +268,9 @@ int atags_set_tag(u32 magic, void *tagdata)
 	if (atags_size_overflow(t, size))
 		return -ENOMEM;
 
+	/* An old tag is overridden in place, keep the tags behind it */
+	replace = (t->hdr.magic == magic && t->hdr.size == size);
+
 	/* It's okay to setup a new tag */
 	t->hdr.magic = magic;
 	t->hdr.size = size;
@@ -272,6 +279,9 @@ int atags_set_tag(u32 magic, void *tagdata)
 	hash = js_hash(t, (size << 2) - HASH_LEN);
 	memcpy((char *)&t->u + length, &hash, HASH_LEN);
 
+	if (replace)
+		return 0;
+
 	/* Next tag */
 	t = tag_next(t);
 
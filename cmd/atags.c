@@ -179,6 +179,21 @@ static void atags_print_tag(struct tag *t)
 		for (i = 0; i < ARRAY_SIZE(t->u.pstore.buf); i++)
 			printf("  table[%d] = 0x%x@0x%x\n", i, t->u.pstore.buf[i].size, t->u.pstore.buf[i].addr);
 		break;
+	case ATAG_MMC_TUNING:
+		printf("[mmc tuning]:\n");
+		printf("     magic = 0x%x\n", t->hdr.magic);
+		printf("      size = 0x%x\n\n", t->hdr.size << 2);
+		printf("   version = 0x%x\n", t->u.mmc_tuning.version);
+		printf("     count = %d\n", t->u.mmc_tuning.count);
+		for (i = 0; i < t->u.mmc_tuning.count &&
+			    i < ARRAY_SIZE(t->u.mmc_tuning.rec); i++)
+			printf("    rec[%d] = host 0x%x, timing %d, %d Hz, phase 0x%x\n",
+			       i, t->u.mmc_tuning.rec[i].host,
+			       t->u.mmc_tuning.rec[i].timing,
+			       t->u.mmc_tuning.rec[i].clock,
+			       t->u.mmc_tuning.rec[i].phase);
+		printf("      hash = 0x%x\n", t->u.mmc_tuning.hash);
+		break;
 	default:
 		printf("%s: magic(%x) is not support\n", __func__, t->hdr.magic);
 	}
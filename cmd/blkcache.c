@@ -13,15 +13,25 @@
 static int blkc_show(cmd_tbl_t *cmdtp, int flag,
 		     int argc, char * const argv[])
 {
+	struct block_cache_dev_stats dstats;
 	struct block_cache_stats stats;
+	int i;
+
+	for (i = 0; !blkcache_dev_stats(i, &dstats); i++)
+		printf("%s %d: hits %u, partial %u, misses %u, used %lu KiB of %lu MiB\n",
+		       blk_get_if_type_name(dstats.iftype), dstats.devnum,
+		       dstats.hits, dstats.partial_hits, dstats.misses,
+		       dstats.used >> 10, dstats.budget >> 20);
+
 	blkcache_stats(&stats);
 
 	printf("hits: %u\n"
+	       "partial hits: %u\n"
 	       "misses: %u\n"
 	       "entries: %u\n"
 	       "max blocks/entry: %u\n"
 	       "max cache entries: %u\n",
-	       stats.hits, stats.misses, stats.entries,
+	       stats.hits, stats.partial_hits, stats.misses, stats.entries,
 	       stats.max_blocks_per_entry, stats.max_entries);
 	return 0;
 }
@@ -29,21 +39,52 @@ static int blkc_show(cmd_tbl_t *cmdtp, int flag,
 static int blkc_configure(cmd_tbl_t *cmdtp, int flag,
 			  int argc, char * const argv[])
 {
+	struct block_cache_stats stats;
 	unsigned blocks_per_entry, max_entries;
 	if (argc != 3)
 		return CMD_RET_USAGE;
 
 	blocks_per_entry = simple_strtoul(argv[1], 0, 0);
 	max_entries = simple_strtoul(argv[2], 0, 0);
-	blkcache_configure(blocks_per_entry, max_entries);
+	if (blkcache_configure(blocks_per_entry, max_entries)) {
+		printf("blocks per entry must be a power of two up to 32\n");
+		return CMD_RET_FAILURE;
+	}
+	/* entries are rounded to whole sets, report what is in effect */
+	blkcache_stats(&stats);
 	printf("changed to max of %u entries of %u blocks each\n",
-	       max_entries, blocks_per_entry);
+	       stats.max_entries, stats.max_blocks_per_entry);
+	return 0;
+}
+
+static int blkc_budget(cmd_tbl_t *cmdtp, int flag,
+		       int argc, char * const argv[])
+{
+	enum if_type iftype;
+	unsigned mib;
+	int devnum;
+
+	if (argc != 4)
+		return CMD_RET_USAGE;
+
+	iftype = if_typename_to_iftype(argv[1]);
+	if (iftype == IF_TYPE_UNKNOWN) {
+		printf("unknown interface '%s'\n", argv[1]);
+		return CMD_RET_FAILURE;
+	}
+	devnum = simple_strtoul(argv[2], 0, 0);
+	mib = simple_strtoul(argv[3], 0, 0);
+	if (blkcache_set_budget(iftype, devnum, mib))
+		return CMD_RET_FAILURE;
+
+	printf("%s %d: budget %u MiB\n", argv[1], devnum, mib);
 	return 0;
 }
 
 static cmd_tbl_t cmd_blkc_sub[] = {
 	U_BOOT_CMD_MKENT(show, 0, 0, blkc_show, "", ""),
 	U_BOOT_CMD_MKENT(configure, 3, 0, blkc_configure, "", ""),
+	U_BOOT_CMD_MKENT(budget, 4, 0, blkc_budget, "", ""),
 };
 
 static __maybe_unused void blkc_reloc(void)
@@ -80,8 +121,9 @@ static int do_blkcache(cmd_tbl_t *cmdtp, int flag,
 }
 
 U_BOOT_CMD(
-	blkcache, 4, 0, do_blkcache,
+	blkcache, 5, 0, do_blkcache,
 	"block cache diagnostics and control",
-	"show - show and reset statistics\n"
+	"show - show and reset statistics, per device and total\n"
 	"blkcache configure blocks entries\n"
+	"blkcache budget <interface> <dev> <MiB> - limit cache held by a device\n"
 );
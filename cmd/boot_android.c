@@ -32,7 +32,7 @@ static int do_boot_android(cmd_tbl_t *cmdtp, int flag, int argc,
 		return CMD_RET_USAGE;
 
 #ifdef CONFIG_MP_BOOT_BOOTM
-	mpb_post(5);
+	mpb_post(MPB_POST_BOOTM);
 #endif
 	if (argc >= 5) {
 		load_address = simple_strtoul(argv[4], &addr_arg_endp, 16);
@@ -0,0 +1,119 @@
+/*
+ * Memory bandwidth of memcpy(), memmove() and memset()
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <console.h>
+#include <div64.h>
+#include <mapmem.h>
+
+/* Repeat each run for at least this long, to hide the timer resolution */
+#define MEMBENCH_MIN_US		200000
+/* memmove() is measured with a destination this far above the source */
+#define MEMBENCH_OVERLAP	64
+
+enum {
+	BENCH_MEMCPY,
+	BENCH_MEMMOVE,
+	BENCH_MEMSET_0,
+	BENCH_MEMSET_FF,
+
+	BENCH_COUNT,
+};
+
+static const char *const bench_name[BENCH_COUNT] = {
+	"memcpy", "memmove", "memset 0", "memset ff",
+};
+
+static void bench_once(int test, char *dst, char *src, ulong size)
+{
+	switch (test) {
+	case BENCH_MEMCPY:
+		memcpy(dst, src, size);
+		break;
+	case BENCH_MEMMOVE:
+		memmove(src + MEMBENCH_OVERLAP, src, size);
+		break;
+	case BENCH_MEMSET_0:
+		memset(dst, 0, size);
+		break;
+	case BENCH_MEMSET_FF:
+		memset(dst, 0xff, size);
+		break;
+	}
+}
+
+/* Returns the throughput in MB/s */
+static ulong bench_run(int test, char *dst, char *src, ulong size)
+{
+	ulong loops, i, start, us;
+
+	for (loops = 1;; loops *= 2) {
+		start = timer_get_us();
+		for (i = 0; i < loops; i++)
+			bench_once(test, dst, src, size);
+		us = timer_get_us() - start;
+		if (us >= MEMBENCH_MIN_US)
+			break;
+		if (ctrlc())
+			return 0;
+	}
+
+	return lldiv((u64)size * loops, us);
+}
+
+static int do_membench(cmd_tbl_t *cmdtp, int flag, int argc,
+		       char * const argv[])
+{
+	ulong addr, max, size, mbps;
+	char *src, *dst;
+	int test;
+
+	if (argc != 3)
+		return CMD_RET_USAGE;
+
+	addr = simple_strtoul(argv[1], NULL, 16);
+	max = simple_strtoul(argv[2], NULL, 16);
+	if (!max)
+		return CMD_RET_USAGE;
+
+	/* Source, then destination, each with room for the memmove() shift */
+	src = map_sysmem(addr, 2 * (max + MEMBENCH_OVERLAP));
+	dst = src + max + MEMBENCH_OVERLAP;
+	memset(src, 0x5a, max + MEMBENCH_OVERLAP);
+
+	printf("%10s", "size");
+	for (test = 0; test < BENCH_COUNT; test++)
+		printf("%12s", bench_name[test]);
+	puts("   (GB/s)\n");
+
+	for (size = min(max, 64UL);; size = min(size * 4, max)) {
+		printf("%10lu", size);
+		for (test = 0; test < BENCH_COUNT; test++) {
+			mbps = bench_run(test, dst, src, size);
+			if (!mbps) {
+				unmap_sysmem(src);
+				puts("\n");
+				return CMD_RET_FAILURE;
+			}
+			printf("%8lu.%03lu", mbps / 1000, mbps % 1000);
+		}
+		puts("\n");
+		if (size == max)
+			break;
+	}
+	unmap_sysmem(src);
+
+	return CMD_RET_SUCCESS;
+}
+
+U_BOOT_CMD(
+	membench,	3,	1,	do_membench,
+	"measure memcpy/memmove/memset bandwidth",
+	"address size\n"
+	"    - run each function on sizes from 64 bytes up to 'size',\n"
+	"      using about 2 * 'size' bytes at 'address'"
+);
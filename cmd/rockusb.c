@@ -10,43 +10,75 @@
 #include <command.h>
 #include <console.h>
 #include <g_dnl.h>
+#include <linux/math64.h>
+#include <malloc.h>
+#include <memalign.h>
 #include <part.h>
 #include <usb.h>
 #include <usb_mass_storage.h>
 #include <rockusb.h>
 
+#define RKUSB_WB_BLKS	(CONFIG_ROCKUSB_WRITE_BEHIND_SIZE * 1024 / SECTOR_SIZE)
+
+/*
+ * Write-behind buffer: sequential LBA writes of the host are collected
+ * here and written with a single blk_dwrite(), so the storage sees a few
+ * large writes instead of one per (typically 64 KiB) USB transfer.
+ */
+struct rkusb_wb {
+	struct ums *ums;
+	lbaint_t start;		/* device block of buf[0] */
+	lbaint_t cnt;		/* blocks held */
+	void *buf;
+	int err;		/* failed flush, not yet reported */
+};
+
 static struct rockusb rkusb;
 static struct rockusb *g_rkusb;
+static struct rkusb_wb rkusb_wb;
+static struct rkusb_stats rkusb_stats;
+
+static void rkusb_wb_flush(void);
 
 static int rkusb_read_sector(struct ums *ums_dev,
 			     ulong start, lbaint_t blkcnt, void *buf)
 {
 	struct blk_desc *block_dev = &ums_dev->block_dev;
 	lbaint_t blkstart = start + ums_dev->start_sector;
+	ulong us;
 	int ret;
 
 	if ((blkstart + blkcnt) > RKUSB_READ_LIMIT_ADDR) {
 		memset(buf, 0xcc, blkcnt * SECTOR_SIZE);
 		return blkcnt;
 	} else {
+		/* The host may read back what it has just written */
+		rkusb_wb_flush();
+		us = timer_get_us();
 		ret = blk_dread(block_dev, blkstart, blkcnt, buf);
+		rkusb_stats.read_us += timer_get_us() - us;
+		rkusb_stats.read_xfers++;
+		rkusb_stats.read_bytes += (u64)blkcnt * SECTOR_SIZE;
 		if (!ret)
 			ret = -EIO;
 		return ret;
 	}
 }
 
-static int rkusb_write_sector(struct ums *ums_dev,
-			      ulong start, lbaint_t blkcnt, const void *buf)
+static int rkusb_do_write(struct ums *ums_dev, lbaint_t blkstart,
+			  lbaint_t blkcnt, const void *buf)
 {
 	struct blk_desc *block_dev = &ums_dev->block_dev;
-	lbaint_t blkstart = start + ums_dev->start_sector;
+	ulong us;
 	int ret;
 
 	if (block_dev->if_type == IF_TYPE_MTD)
 		block_dev->op_flag |= BLK_MTD_CONT_WRITE;
 
+	us = timer_get_us();
 	ret = blk_dwrite(block_dev, blkstart, blkcnt, buf);
+	rkusb_stats.write_us += timer_get_us() - us;
+	rkusb_stats.storage_writes++;
 	if (!ret)
 		ret = -EIO;
 
@@ -55,6 +87,81 @@ static int rkusb_write_sector(struct ums *ums_dev,
 	return ret;
 }
 
+static void rkusb_wb_flush(void)
+{
+	struct rkusb_wb *wb = &rkusb_wb;
+	int ret;
+
+	if (!wb->cnt)
+		return;
+
+	ret = rkusb_do_write(wb->ums, wb->start, wb->cnt, wb->buf);
+	if (ret != wb->cnt) {
+		printf("rockusb: write of " LBAFU " blocks at " LBAFU " failed\n",
+		       wb->cnt, wb->start);
+		wb->err = -EIO;
+	}
+	wb->cnt = 0;
+}
+
+void rkusb_write_idle(void)
+{
+	rkusb_wb_flush();
+}
+
+int rkusb_write_flush(void)
+{
+	int ret;
+
+	rkusb_wb_flush();
+	ret = rkusb_wb.err;
+	rkusb_wb.err = 0;
+
+	return ret;
+}
+
+static int rkusb_write_sector(struct ums *ums_dev,
+			      ulong start, lbaint_t blkcnt, const void *buf)
+{
+	struct rkusb_wb *wb = &rkusb_wb;
+	lbaint_t blkstart = start + ums_dev->start_sector;
+
+	rkusb_stats.write_xfers++;
+	rkusb_stats.write_bytes += (u64)blkcnt * SECTOR_SIZE;
+
+	if (wb->cnt && (wb->ums != ums_dev ||
+			wb->start + wb->cnt != blkstart ||
+			wb->cnt + blkcnt > RKUSB_WB_BLKS))
+		rkusb_wb_flush();
+	if (wb->err)
+		return rkusb_write_flush();
+
+	if (blkcnt >= RKUSB_WB_BLKS)
+		return rkusb_do_write(ums_dev, blkstart, blkcnt, buf);
+
+	if (!wb->buf) {
+		wb->buf = memalign(ARCH_DMA_MINALIGN,
+				   RKUSB_WB_BLKS * SECTOR_SIZE);
+		if (!wb->buf)
+			return rkusb_do_write(ums_dev, blkstart, blkcnt, buf);
+	}
+
+	if (!wb->cnt) {
+		wb->ums = ums_dev;
+		wb->start = blkstart;
+	}
+	memcpy(wb->buf + wb->cnt * SECTOR_SIZE, buf, blkcnt * SECTOR_SIZE);
+	wb->cnt += blkcnt;
+
+	if (wb->cnt == RKUSB_WB_BLKS) {
+		rkusb_wb_flush();
+		if (wb->err)
+			return rkusb_write_flush();
+	}
+
+	return blkcnt;
+}
+
 static int rkusb_erase_sector(struct ums *ums_dev,
 			      ulong start, lbaint_t blkcnt)
 {
@@ -68,6 +175,11 @@ static void rkusb_fini(void)
 {
 	int i;
 
+	if (rkusb_write_flush())
+		printf("rockusb: data of the last writes was lost\n");
+	free(rkusb_wb.buf);
+	rkusb_wb.buf = NULL;
+
 	for (i = 0; i < g_rkusb->ums_cnt; i++)
 		free((void *)g_rkusb->ums[i].name);
 	free(g_rkusb->ums);
@@ -151,6 +263,34 @@ cleanup:
 	return ret;
 }
 
+static void rkusb_print_rate(const char *name, u64 bytes, u32 xfers,
+			     u64 us)
+{
+	printf("%-6s %llu KiB in %u transfers", name, bytes >> 10, xfers);
+	if (us)
+		printf(", %llu us in storage (%llu KiB/s)",
+		       us, div64_u64(bytes * 1000000 >> 10, us));
+	printf("\n");
+}
+
+static int do_rkusb_stats(void)
+{
+	struct rkusb_stats *st = &rkusb_stats;
+
+	printf("last session: %llu ms\n", lldiv(st->session_us, 1000));
+	rkusb_print_rate("read:", st->read_bytes, st->read_xfers,
+			 st->read_us);
+	rkusb_print_rate("write:", st->write_bytes, st->write_xfers,
+			 st->write_us);
+	printf("%-6s %u storage writes\n", "", st->storage_writes);
+	if (st->session_us)
+		printf("%-6s %llu KiB/s over the session\n", "",
+		       div64_u64((st->read_bytes + st->write_bytes) *
+				 1000000 >> 10, st->session_us));
+
+	return CMD_RET_SUCCESS;
+}
+
 static int do_rkusb(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
 {
 	const char *usb_controller;
@@ -160,6 +300,10 @@ static int do_rkusb(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
 	int rc;
 	int cable_ready_timeout __maybe_unused;
 	const char *s;
+	ulong start;
+
+	if (argc == 2 && !strcmp(argv[1], "stats"))
+		return do_rkusb_stats();
 
 	if (argc != 4)
 		return CMD_RET_USAGE;
@@ -263,11 +407,16 @@ static int do_rkusb(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
 		puts("\r\n");
 	}
 
+	memset(&rkusb_stats, 0, sizeof(rkusb_stats));
+	start = timer_get_us();
+
 	while (1) {
 		usb_gadget_handle_interrupts(controller_index);
 
 		rc = fsg_main_thread(NULL);
 		if (rc) {
+			rkusb_stats.session_us = timer_get_us() - start;
+
 			/* Check I/O error */
 			if (rc == -EIO)
 				printf("\rCheck USB cable connection\n");
@@ -294,4 +443,5 @@ cleanup_rkusb:
 U_BOOT_CMD_ALWAYS(rockusb, 4, 1, do_rkusb,
 		  "Use the rockusb Protocol",
 		  "<USB_controller> <devtype> <dev[:part]>  e.g. rockusb 0 mmc 0\n"
+		  "rockusb stats - show the throughput of the last session\n"
 );
@@ -824,8 +824,8 @@ static AvbSlotVerifyResult android_slot_verify(char *boot_partname,
 		flags |= AVB_SLOT_VERIFY_FLAGS_NO_VBMETA_PARTITION;
 
 #ifdef CONFIG_MP_BOOT
-	preload_user_data.boot.addr = (void *)mpb_post(1);
-	preload_user_data.boot.size = (size_t)mpb_post(2);
+	preload_user_data.boot.addr = (void *)mpb_post(MPB_POST_BOOT_ADDR);
+	preload_user_data.boot.size = (size_t)mpb_post(MPB_POST_BOOT_SIZE);
 #endif
 
 	/* use preload one if available */
@@ -256,7 +256,7 @@ static int setup_mon_len(void)
 	gd->mon_len = (ulong)&__bss_end - CONFIG_SYS_MONITOR_BASE;
 #endif
 #ifdef CONFIG_MP_BOOT
-	mpb_init_x(3);
+	mpb_init_x(MPB_INIT_UBOOT);
 #endif
 	return 0;
 }
@@ -329,6 +329,20 @@ static int setup_dest_addr(void)
 	return 0;
 }
 
+#ifdef CONFIG_ARMV8_EARLY_DCACHE
+/*
+ * The page tables have their final place in DRAM now, so build them and
+ * run the rest of board_init_f() and relocation with the data cache on.
+ * initr_caches() then finds the MMU already enabled.
+ */
+static int initf_dcache(void)
+{
+	dcache_enable();
+
+	return 0;
+}
+#endif
+
 #ifdef CONFIG_PRAM
 /* reserve protected RAM */
 static int reserve_pram(void)
@@ -920,6 +934,9 @@ static const init_fnc_t init_sequence_f[] = {
 	reserve_round_4k,
 #ifdef CONFIG_ARM
 	reserve_mmu,
+#endif
+#ifdef CONFIG_ARMV8_EARLY_DCACHE
+	initf_dcache,
 #endif
 	reserve_video,
 	reserve_trace,
@@ -422,6 +422,51 @@ typedef enum {
 static sha1_context sha1_ctx;
 #endif
 
+#ifdef CONFIG_ANDROID_BOOT_IMAGE_HASH
+static void image_hash_update(struct udevice *crypto, void *buf, ulong len)
+{
+	if (!len)
+		return;
+#ifdef CONFIG_DM_CRYPTO
+	if (crypto)
+		crypto_sha_update(crypto, (u32 *)buf, len);
+#else
+	sha1_update(&sha1_ctx, buf, len);
+#endif
+}
+
+/*
+ * Read the image in chunks and hash each chunk right after it arrives,
+ * while it is still in the cache, rather than pulling the whole image
+ * through memory a second time once the read completes.
+ *
+ * Bytes [hoffs, hoffs + hlen) of the image are hashed.
+ */
+static int image_read_hash(struct blk_desc *desc, ulong blkstart,
+			   ulong blkcnt, void *buffer, ulong hoffs,
+			   ulong hlen, struct udevice *crypto)
+{
+	ulong chunk = max((ulong)CONFIG_ANDROID_BOOT_IMAGE_HASH_CHUNK << 10,
+			  desc->blksz) / desc->blksz;
+	ulong blk, n, pos, end;
+
+	for (blk = 0; blk < blkcnt; blk += n) {
+		n = min(chunk, blkcnt - blk);
+		/* the chunks stream into place, a read-ahead copy buys nothing */
+		if (blk_dread_direct(desc, blkstart + blk, n,
+				     buffer + blk * desc->blksz) != n)
+			return -EIO;
+
+		pos = max(blk * desc->blksz, hoffs);
+		end = min((blk + n) * desc->blksz, hoffs + hlen);
+		if (end > pos)
+			image_hash_update(crypto, buffer + pos, end - pos);
+	}
+
+	return 0;
+}
+#endif
+
 static int image_load(img_t img, struct andr_img_hdr *hdr,
 		      ulong blkstart, void *ram_base,
 		      struct udevice *crypto)
@@ -440,8 +485,19 @@ static int image_load(img_t img, struct andr_img_hdr *hdr,
 	ulong length;
 	void *buffer;
 	void *tmp = NULL;
+	bool hash = false;
+#ifdef CONFIG_ANDROID_BOOT_IMAGE_HASH
+	bool hashed = false;
+#endif
 	int ret = 0;
 
+#ifdef CONFIG_ANDROID_BOOT_IMAGE_HASH
+	hash = hdr->header_version < 3;
+#ifdef CONFIG_DM_CRYPTO
+	hash = hash && crypto;
+#endif
+#endif
+
 	switch (img) {
 	case IMG_KERNEL:
 		bsoffs = 0; /* include a page_size(image header) */
@@ -635,6 +691,19 @@ static int image_load(img_t img, struct andr_img_hdr *hdr,
 	/* load */
 	if (ram_base) {
 		memcpy(buffer, (char *)((ulong)ram_base + bsoffs), length);
+	} else if (hash) {
+#ifdef CONFIG_ANDROID_BOOT_IMAGE_HASH
+		ulong hoffs = (img == IMG_KERNEL) ? pgsz : 0;
+
+		blkoff = DIV_ROUND_UP(bsoffs, blksz);
+		ret = image_read_hash(desc, blkstart + blkoff, blkcnt, buffer,
+				      hoffs, length - hoffs, crypto);
+		if (ret) {
+			printf("Failed to read img(%d), ret=%d\n", img, ret);
+			return ret;
+		}
+		hashed = true;
+#endif
 	} else {
 		blkoff = DIV_ROUND_UP(bsoffs, blksz);
 		ret = blk_dread(desc, blkstart + blkoff, blkcnt, buffer);
@@ -654,17 +723,11 @@ crypto_calc:
 	}
 
 	/* sha1 */
-	if (hdr->header_version < 3) {
+	if (hash) {
 #ifdef CONFIG_ANDROID_BOOT_IMAGE_HASH
-#ifdef CONFIG_DM_CRYPTO
-		if (crypto) {
-			crypto_sha_update(crypto, (u32 *)buffer, length);
-			crypto_sha_update(crypto, (u32 *)&length, typesz);
-		}
-#else
-		sha1_update(&sha1_ctx, (void *)buffer, length);
-		sha1_update(&sha1_ctx, (void *)&length, typesz);
-#endif
+		if (!hashed)
+			image_hash_update(crypto, buffer, length);
+		image_hash_update(crypto, &length, typesz);
 #endif
 	}
 
@@ -730,7 +793,7 @@ static int android_image_separate(struct andr_img_hdr *hdr,
 	int verify = 1;
 
 #ifdef CONFIG_MP_BOOT
-	verify = mpb_post(3);
+	verify = mpb_post(MPB_POST_VERIFY);
 #endif
 	if (hdr->header_version < 3 && verify) {
 		struct udevice *dev = NULL;
@@ -49,6 +49,73 @@
 #define CONFIG_FASTBOOT_FLASH_FILLBUF_SIZE (1024 * 512)
 #endif
 
+#ifndef CONFIG_FASTBOOT_SPARSE_COALESCE
+#define CONFIG_FASTBOOT_SPARSE_COALESCE 0
+#endif
+
+/*
+ * Consecutive RAW chunks are collected in a run and written with a single
+ * info->write(). In the download buffer the data of two chunks is
+ * separated by the header of the second one, so to merge them the smaller
+ * of the two is moved over that header. Two chunks that are both larger
+ * than CONFIG_FASTBOOT_SPARSE_COALESCE KiB are written separately.
+ */
+struct sparse_run {
+	void		*data;
+	lbaint_t	blk;
+	lbaint_t	blkcnt;
+};
+
+static bool sparse_run_merge(struct sparse_storage *info,
+			     struct sparse_run *run, void *data,
+			     lbaint_t blkcnt)
+{
+	u64 limit = (u64)CONFIG_FASTBOOT_SPARSE_COALESCE << 10;
+	u64 run_bytes = (u64)run->blkcnt * info->blksz;
+	u64 bytes = (u64)blkcnt * info->blksz;
+	size_t gap = data - (run->data + run_bytes);
+
+	if (min(run_bytes, bytes) > limit)
+		return false;
+
+	if (run_bytes <= bytes) {
+		memmove(run->data + gap, run->data, run_bytes);
+		run->data += gap;
+	} else {
+		memmove(run->data + run_bytes, data, bytes);
+	}
+	run->blkcnt += blkcnt;
+
+	return true;
+}
+
+/*
+ * Write out the pending run. Returns the number of extra blocks the
+ * backend skipped (e.g. NAND bad blocks), or -EIO.
+ */
+static long sparse_run_flush(struct sparse_storage *info,
+			     struct sparse_run *run, char *response)
+{
+	lbaint_t blks;
+
+	if (!run->blkcnt)
+		return 0;
+
+	blks = info->write(info, run->blk, run->blkcnt, run->data);
+	/* blks might be > blkcnt (eg. NAND bad-blocks) */
+	if (blks < run->blkcnt) {
+		printf("%s: %s" LBAFU " [" LBAFU "]\n",
+		       __func__, "Write failed, block #",
+		       run->blk, blks);
+		fastboot_fail("flash write failure", response);
+		return -EIO;
+	}
+	blks -= run->blkcnt;
+	run->blkcnt = 0;
+
+	return blks;
+}
+
 void write_sparse_image(
 		struct sparse_storage *info, const char *part_name,
 		void *data, unsigned sz, char *response)
@@ -62,10 +129,14 @@ void write_sparse_image(
 	uint64_t chunk_data_sz;
 	uint32_t *fill_buf = NULL;
 	uint32_t fill_val;
+	uint32_t fill_buf_val = 0;
 	sparse_header_t *sparse_header;
 	chunk_header_t *chunk_header;
+	uint32_t chunk_sz;
 	uint32_t total_blocks = 0;
+	struct sparse_run run = { .blkcnt = 0 };
 	int fill_buf_num_blks;
+	long extra;
 	int i;
 	int j;
 
@@ -119,6 +190,12 @@ void write_sparse_image(
 			debug("chunk_type: 0x%x\n", chunk_header->chunk_type);
 			debug("chunk_data_sz: 0x%x\n", chunk_header->chunk_sz);
 			debug("total_size: 0x%x\n", chunk_header->total_sz);
+
+			/* only RAW chunks are merged */
+			extra = sparse_run_flush(info, &run, response);
+			if (extra < 0)
+				goto out;
+			blk += extra;
 		}
 
 		if (sparse_header->chunk_hdr_sz > sizeof(chunk_header_t)) {
@@ -130,7 +207,9 @@ void write_sparse_image(
 				 sizeof(chunk_header_t));
 		}
 
-		chunk_data_sz = ((u64)sparse_header->blk_sz) * chunk_header->chunk_sz;
+		/* the header may be overwritten when RAW chunks are merged */
+		chunk_sz = chunk_header->chunk_sz;
+		chunk_data_sz = ((u64)sparse_header->blk_sz) * chunk_sz;
 		blkcnt = DIV_ROUND_UP_ULL(chunk_data_sz, info->blksz);
 		switch (chunk_header->chunk_type) {
 		case CHUNK_TYPE_RAW:
@@ -138,7 +217,7 @@ void write_sparse_image(
 			    (sparse_header->chunk_hdr_sz + chunk_data_sz)) {
 				fastboot_fail(
 					"Bogus chunk size for chunk type Raw", response);
-				return;
+				goto out;
 			}
 
 			if (blk + blkcnt > info->start + info->size) {
@@ -147,22 +226,22 @@ void write_sparse_image(
 				    __func__);
 				fastboot_fail(
 				    "Request would exceed partition size!", response);
-				return;
+				goto out;
 			}
 
-			blks = info->write(info, blk, blkcnt, data);
-			/* blks might be > blkcnt (eg. NAND bad-blocks) */
-			if (blks < blkcnt) {
-				printf("%s: %s" LBAFU " [" LBAFU "]\n",
-				       __func__, "Write failed, block #",
-				       blk, blks);
-				fastboot_fail(
-					      "flash write failure", response);
-				return;
+			if (!run.blkcnt ||
+			    !sparse_run_merge(info, &run, data, blkcnt)) {
+				extra = sparse_run_flush(info, &run, response);
+				if (extra < 0)
+					goto out;
+				blk += extra;
+				run.data = data;
+				run.blk = blk;
+				run.blkcnt = blkcnt;
 			}
-			blk += blks;
+			blk += blkcnt;
 			bytes_written += ((u64)blkcnt) * info->blksz;
-			total_blocks += chunk_header->chunk_sz;
+			total_blocks += chunk_sz;
 			data += chunk_data_sz;
 			break;
 
@@ -171,28 +250,35 @@ void write_sparse_image(
 			    (sparse_header->chunk_hdr_sz + sizeof(uint32_t))) {
 				fastboot_fail(
 					"Bogus chunk size for chunk type FILL", response);
-				return;
-			}
-
-			fill_buf = (uint32_t *)
-				   memalign(ARCH_DMA_MINALIGN,
-					    ROUNDUP(
-						info->blksz * fill_buf_num_blks,
-						ARCH_DMA_MINALIGN));
-			if (!fill_buf) {
-				fastboot_fail(
-					"Malloc failed for: CHUNK_TYPE_FILL", response);
-				return;
+				goto out;
 			}
 
 			fill_val = *(uint32_t *)data;
 			data = (char *)data + sizeof(uint32_t);
 
-			for (i = 0;
-			     i < (info->blksz * fill_buf_num_blks /
-				  sizeof(fill_val));
-			     i++)
-				fill_buf[i] = fill_val;
+			/* one buffer serves all FILL chunks of the image */
+			if (!fill_buf) {
+				fill_buf = (uint32_t *)
+					   memalign(ARCH_DMA_MINALIGN,
+						    ROUNDUP(
+							info->blksz * fill_buf_num_blks,
+							ARCH_DMA_MINALIGN));
+				if (!fill_buf) {
+					fastboot_fail(
+						"Malloc failed for: CHUNK_TYPE_FILL", response);
+					goto out;
+				}
+				fill_buf_val = ~fill_val;
+			}
+
+			if (fill_buf_val != fill_val) {
+				for (i = 0;
+				     i < (info->blksz * fill_buf_num_blks /
+					  sizeof(fill_val));
+				     i++)
+					fill_buf[i] = fill_val;
+				fill_buf_val = fill_val;
+			}
 
 			if (blk + blkcnt > info->start + info->size) {
 				printf(
@@ -200,7 +286,7 @@ void write_sparse_image(
 				    __func__);
 				fastboot_fail(
 				    "Request would exceed partition size!", response);
-				return;
+				goto out;
 			}
 
 			for (i = 0; i < blkcnt;) {
@@ -216,8 +302,7 @@ void write_sparse_image(
 					       blk, j);
 					fastboot_fail(
 						      "flash write failure", response);
-					free(fill_buf);
-					return;
+					goto out;
 				}
 				blk += blks;
 				i += j;
@@ -225,12 +310,18 @@ void write_sparse_image(
 			bytes_written += ((u64)blkcnt) * info->blksz;
 			total_blocks += DIV_ROUND_UP_ULL(chunk_data_sz,
 							 sparse_header->blk_sz);
-			free(fill_buf);
 			break;
 
 		case CHUNK_TYPE_DONT_CARE:
+#ifdef CONFIG_FASTBOOT_SPARSE_DISCARD
+			if (info->erase &&
+			    blk + blkcnt <= info->start + info->size &&
+			    info->erase(info, blk, blkcnt) != blkcnt)
+				debug("%s: discard failed, block #" LBAFU "\n",
+				      __func__, blk);
+#endif
 			blk += info->reserve(info, blk, blkcnt);
-			total_blocks += chunk_header->chunk_sz;
+			total_blocks += chunk_sz;
 			break;
 
 		case CHUNK_TYPE_CRC32:
@@ -238,9 +329,9 @@ void write_sparse_image(
 			    sparse_header->chunk_hdr_sz) {
 				fastboot_fail(
 					"Bogus chunk size for chunk type Dont Care", response);
-				return;
+				goto out;
 			}
-			total_blocks += chunk_header->chunk_sz;
+			total_blocks += chunk_sz;
 			data += chunk_data_sz;
 			break;
 
@@ -248,10 +339,14 @@ void write_sparse_image(
 			printf("%s: Unknown chunk type: %x\n", __func__,
 			       chunk_header->chunk_type);
 			fastboot_fail("Unknown chunk type", response);
-			return;
+			goto out;
 		}
 	}
 
+	extra = sparse_run_flush(info, &run, response);
+	if (extra < 0)
+		goto out;
+
 	debug("Wrote %d blocks, expected to write %d blocks\n",
 	      total_blocks, sparse_header->total_blks);
 	printf("........ wrote %llu bytes to '%s'\n", bytes_written, part_name);
@@ -261,5 +356,6 @@ void write_sparse_image(
 	else
 		fastboot_okay("", response);
 
-	return;
+out:
+	free(fill_buf);
 }
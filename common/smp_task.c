@@ -0,0 +1,342 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * (C) Copyright 2026 Rockchip Electronics Co., Ltd
+ *
+ * Run boot tasks on the secondary cores.
+ */
+
+#include <common.h>
+#include <fdtdec.h>
+#include <smp_task.h>
+#include <asm/cache.h>
+#include <asm/system.h>
+#include <linux/compiler.h>
+#include <linux/libfdt.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define SMP_TASK_RING		16	/* power of two */
+#define SMP_TASK_ON_TIMEOUT_MS	10
+#define SMP_TASK_OFF_TIMEOUT_MS	100
+#define MPIDR_HWID_MASK		0xff00ffffffULL
+
+enum smp_cpu_state {
+	SMP_CPU_OFF = 0,
+	SMP_CPU_STARTING,
+	SMP_CPU_ONLINE,
+};
+
+/*
+ * Per-core context, handed to the core as the PSCI context id. The first
+ * two members are read by smp_task_entry with the MMU still off, so the
+ * layout must match arch/arm/cpu/armv8/smp_task_entry.S.
+ */
+struct smp_task_cpu {
+	ulong stack_top;
+	gd_t *gd;
+	ulong tlb_addr;		/* read with the MMU off, gd may be stale */
+	u64 mpidr;
+	int state;
+	int stop;
+	u32 head;		/* written by the boot CPU only */
+	u32 tail;		/* written by the owning core only */
+	struct smp_task *ring[SMP_TASK_RING];	/* emptied by whoever runs it */
+	u32 done;
+} __aligned(CONFIG_SYS_CACHELINE_SIZE);
+
+static struct smp_task_cpu smp_cpus[CONFIG_SMP_TASK_MAX_CPUS];
+static u8 smp_stacks[CONFIG_SMP_TASK_MAX_CPUS][CONFIG_SMP_TASK_STACK_SIZE]
+	__aligned(CONFIG_SYS_CACHELINE_SIZE);
+static int smp_ncpus;
+static bool smp_started;
+
+#define smp_mb()	__asm__ __volatile__("dmb ish" : : : "memory")
+#define smp_sev()	__asm__ __volatile__("dsb ish\n\tsev" : : : "memory")
+#define smp_wfe()	__asm__ __volatile__("wfe" : : : "memory")
+
+static void smp_task_run(struct smp_task *task)
+{
+	WRITE_ONCE(task->state, SMP_TASK_RUNNING);
+	task->ret = task->fn(task->arg);
+	__atomic_store_n(&task->state, SMP_TASK_DONE, __ATOMIC_RELEASE);
+	smp_sev();
+}
+
+void smp_task_secondary_main(struct smp_task_cpu *cpu)
+{
+	struct smp_task *task;
+
+	smp_task_arch_secondary_init(cpu->tlb_addr);
+
+	WRITE_ONCE(cpu->state, SMP_CPU_ONLINE);
+	smp_sev();
+
+	for (;;) {
+		if (READ_ONCE(cpu->tail) == READ_ONCE(cpu->head)) {
+			if (READ_ONCE(cpu->stop))
+				break;
+			smp_wfe();
+			continue;
+		}
+
+		/*
+		 * Empty the slot before looking at the task: a waiter that
+		 * emptied it first runs the task itself and may free it.
+		 */
+		smp_mb();
+		task = __atomic_exchange_n(&cpu->ring[cpu->tail % SMP_TASK_RING],
+					   NULL, __ATOMIC_ACQUIRE);
+		if (task) {
+			smp_task_run(task);
+			cpu->done++;
+		}
+
+		/* release the slot only after we are done with it */
+		smp_mb();
+		WRITE_ONCE(cpu->tail, cpu->tail + 1);
+	}
+
+	WRITE_ONCE(cpu->state, SMP_CPU_OFF);
+	smp_sev();
+	smp_task_arch_cpu_off();
+}
+
+static int smp_task_find_cpus(void)
+{
+	const void *blob = gd->fdt_blob;
+	u64 self = read_mpidr() & MPIDR_HWID_MASK;
+	int node, subnode;
+
+	node = fdt_path_offset(blob, "/cpus");
+	if (node < 0)
+		return node;
+
+	fdt_for_each_subnode(subnode, blob, node) {
+		const char *type;
+		const fdt32_t *reg;
+		u64 mpidr;
+		int len;
+
+		type = fdt_getprop(blob, subnode, "device_type", NULL);
+		if (!type || strcmp(type, "cpu"))
+			continue;
+		if (!fdtdec_get_is_enabled(blob, subnode))
+			continue;
+		reg = fdt_getprop(blob, subnode, "reg", &len);
+		if (!reg || len < sizeof(*reg))
+			continue;
+
+		mpidr = fdt_read_number(reg, len / sizeof(*reg)) &
+			MPIDR_HWID_MASK;
+		if (mpidr == self)
+			continue;
+		if (smp_ncpus == CONFIG_SMP_TASK_MAX_CPUS)
+			break;
+
+		smp_cpus[smp_ncpus++].mpidr = mpidr;
+	}
+
+	return 0;
+}
+
+static int smp_task_cpu_up(struct smp_task_cpu *cpu, u8 *stack)
+{
+	ulong start;
+	int ret;
+
+	cpu->stack_top = (ulong)stack + CONFIG_SMP_TASK_STACK_SIZE;
+	cpu->gd = (gd_t *)gd;
+	cpu->tlb_addr = gd->arch.tlb_addr;
+	cpu->head = 0;
+	cpu->tail = 0;
+	cpu->stop = 0;
+	cpu->state = SMP_CPU_STARTING;
+
+	/*
+	 * The core starts with its MMU off: it must find its context in
+	 * memory, and no cache may hold stale lines of its stack.
+	 */
+	flush_dcache_range((ulong)cpu, (ulong)(cpu + 1));
+	flush_dcache_range((ulong)stack, cpu->stack_top);
+
+	ret = smp_task_arch_cpu_on(cpu->mpidr, cpu);
+	if (ret) {
+		debug("smp: cpu %llx failed to start: %d\n", cpu->mpidr, ret);
+		cpu->state = SMP_CPU_OFF;
+		return ret;
+	}
+
+	start = get_timer(0);
+	while (READ_ONCE(cpu->state) != SMP_CPU_ONLINE) {
+		if (get_timer(start) > SMP_TASK_ON_TIMEOUT_MS) {
+			printf("smp: cpu %llx did not come online\n",
+			       cpu->mpidr);
+			return -ETIMEDOUT;
+		}
+	}
+
+	return 0;
+}
+
+static void smp_task_start(void)
+{
+	int i, n = 0;
+
+	if (smp_started)
+		return;
+	smp_started = true;
+
+	if (smp_task_find_cpus())
+		return;
+
+	for (i = 0; i < smp_ncpus; i++) {
+		if (smp_task_cpu_up(&smp_cpus[i], smp_stacks[i]))
+			continue;
+		n++;
+	}
+
+	debug("smp: %d of %d secondary cores online\n", n, smp_ncpus);
+}
+
+static bool smp_task_cpu_online(int cpu)
+{
+	return cpu >= 0 && cpu < smp_ncpus &&
+	       READ_ONCE(smp_cpus[cpu].state) == SMP_CPU_ONLINE;
+}
+
+static u32 smp_task_pending(int cpu)
+{
+	return smp_cpus[cpu].head - READ_ONCE(smp_cpus[cpu].tail);
+}
+
+int smp_task_submit(struct smp_task *task, int cpu)
+{
+	struct smp_task_cpu *c;
+	int i;
+
+	if (task->state == SMP_TASK_QUEUED || task->state == SMP_TASK_RUNNING)
+		return -EBUSY;
+
+	smp_task_start();
+	if (cpu != SMP_TASK_ANY_CPU && (cpu < 0 || cpu >= smp_ncpus))
+		return -EINVAL;
+
+	if (cpu == SMP_TASK_ANY_CPU) {
+		for (i = 0; i < smp_ncpus; i++) {
+			if (!smp_task_cpu_online(i) ||
+			    smp_task_pending(i) == SMP_TASK_RING)
+				continue;
+			if (cpu < 0 || smp_task_pending(i) < smp_task_pending(cpu))
+				cpu = i;
+		}
+	}
+
+	task->ret = 0;
+	task->cpu = cpu;
+	if (!smp_task_cpu_online(cpu) ||
+	    smp_task_pending(cpu) == SMP_TASK_RING) {
+		/* nobody to hand it to, run it here */
+		task->cpu = -1;
+		smp_task_run(task);
+		return 0;
+	}
+
+	c = &smp_cpus[cpu];
+	task->state = SMP_TASK_QUEUED;
+	task->slot = c->head % SMP_TASK_RING;
+	c->ring[task->slot] = task;
+	smp_mb();
+	WRITE_ONCE(c->head, c->head + 1);
+	smp_sev();
+
+	return 0;
+}
+
+int smp_task_poll(struct smp_task *task)
+{
+	if (__atomic_load_n(&task->state, __ATOMIC_ACQUIRE) != SMP_TASK_DONE)
+		return -EINPROGRESS;
+
+	return task->ret;
+}
+
+/* Take a task back from its core, fails once the core has taken it */
+static bool smp_task_unqueue(struct smp_task *task)
+{
+	struct smp_task *queued = task;
+	struct smp_task **slot;
+
+	if (task->cpu < 0)
+		return false;
+
+	slot = &smp_cpus[task->cpu].ring[task->slot];
+	return __atomic_compare_exchange_n(slot, &queued, NULL, false,
+					   __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+int smp_task_wait(struct smp_task *task, ulong timeout_ms)
+{
+	ulong start = get_timer(0);
+
+	if (task->state == SMP_TASK_IDLE)
+		return -EINVAL;
+
+	/* don't wait for a core that has not picked the task up yet */
+	if (smp_task_unqueue(task)) {
+		task->cpu = -1;
+		smp_task_run(task);
+	}
+
+	while (__atomic_load_n(&task->state, __ATOMIC_ACQUIRE) !=
+	       SMP_TASK_DONE) {
+		if (timeout_ms && get_timer(start) > timeout_ms) {
+			printf("smp: task '%s' timed out on cpu %d\n",
+			       task->name, task->cpu);
+			return -ETIMEDOUT;
+		}
+	}
+
+	return task->ret;
+}
+
+int smp_task_cpu_count(void)
+{
+	int i, n = 0;
+
+	smp_task_start();
+	for (i = 0; i < smp_ncpus; i++)
+		if (smp_task_cpu_online(i))
+			n++;
+
+	return n;
+}
+
+void smp_task_stop_all(void)
+{
+	struct smp_task_cpu *cpu;
+	ulong start;
+	int i;
+
+	for (i = 0; i < smp_ncpus; i++) {
+		cpu = &smp_cpus[i];
+		if (!smp_task_cpu_online(i))
+			continue;
+
+		WRITE_ONCE(cpu->stop, 1);
+		smp_sev();
+
+		start = get_timer(0);
+		while (READ_ONCE(cpu->state) != SMP_CPU_OFF ||
+		       !smp_task_arch_cpu_is_off(cpu->mpidr)) {
+			if (get_timer(start) > SMP_TASK_OFF_TIMEOUT_MS) {
+				printf("smp: cpu %llx failed to stop\n",
+				       cpu->mpidr);
+				break;
+			}
+		}
+		debug("smp: cpu %llx ran %u tasks\n", cpu->mpidr, cpu->done);
+	}
+
+	smp_ncpus = 0;
+	smp_started = false;
+}
@@ -549,7 +549,7 @@ void board_init_r(gd_t *dummy1, ulong dummy2)
 	memset(&spl_image, '\0', sizeof(spl_image));
 
 #ifdef CONFIG_MP_BOOT
-	mpb_init_x(0);
+	mpb_init_x(MPB_INIT_SPL);
 #endif
 
 #if CONFIG_IS_ENABLED(ATF)
@@ -581,7 +581,7 @@ void board_init_r(gd_t *dummy1, ulong dummy2)
 	spl_perform_fixups(&spl_image);
 
 #ifdef CONFIG_MP_BOOT
-	mpb_init_x(2);
+	mpb_init_x(MPB_INIT_SPL_EXIT);
 #endif
 
 #ifdef CONFIG_CPU_V7M
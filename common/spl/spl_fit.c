@@ -147,6 +147,31 @@ static int get_aligned_image_size(struct spl_load_info *info, int data_size,
 	return (data_size + info->bl_len - 1) / info->bl_len;
 }
 
+/* Largest partial first block that is read in place, see below */
+#define SPL_FIT_HEAD_MAX	512
+
+/*
+ * A raw read starts at a block boundary, so an image that does not is
+ * preceded by @overhead bytes of its first block. Starting the read that
+ * many bytes before @load_addr lands the image in place; the bytes below
+ * it are saved and put back by the caller. Only do so in plain DRAM.
+ */
+static bool spl_fit_read_in_place(struct spl_load_info *info, ulong load_addr,
+				  ulong overhead)
+{
+	ulong start = load_addr - overhead;
+
+	if (info->filename || overhead > SPL_FIT_HEAD_MAX ||
+	    !IS_ALIGNED(start, ARCH_DMA_MINALIGN))
+		return false;
+#if defined(CONFIG_ARCH_ROCKCHIP)
+	return start >= CONFIG_SYS_SDRAM_BASE &&
+	       load_addr < CONFIG_SYS_SDRAM_BASE + SDRAM_MAX_SIZE;
+#else
+	return false;
+#endif
+}
+
 /**
  * spl_load_fit_image(): load the image described in a certain FIT node
  * @info:	points to information about the device to load data from
@@ -180,6 +205,8 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 	uint8_t image_comp = -1, type = -1;
 	const void *data;
 	bool external_data = false;
+	bool in_place = false;
+	u8 head[SPL_FIT_HEAD_MAX];
 
 	if (IS_ENABLED(CONFIG_SPL_OS_BOOT) && IS_ENABLED(CONFIG_SPL_GZIP)) {
 		if (fit_image_get_comp(fit, node, &image_comp))
@@ -229,11 +256,22 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 		overhead = get_aligned_image_overhead(info, offset);
 		nr_sectors = get_aligned_image_size(info, length, offset);
 
+		/* Uncompressed data is read straight into its load address */
+		if (comp_addr == load_addr && overhead &&
+		    spl_fit_read_in_place(info, load_addr, overhead)) {
+			load_ptr = load_addr - overhead;
+			memcpy(head, (void *)load_ptr, overhead);
+			in_place = true;
+		}
+
 		if (info->read(info,
 			       sector + get_aligned_image_offset(info, offset),
 			       nr_sectors, (void *)load_ptr) != nr_sectors)
 			return -EIO;
 
+		if (in_place)
+			memcpy((void *)load_ptr, head, overhead);
+
 		debug("External data: dst=%lx, offset=%x, size=%lx\n",
 		      load_ptr, offset, (unsigned long)length);
 		src = (void *)load_ptr + overhead;
@@ -283,8 +321,8 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 			return -EIO;
 		}
 		length = size;
-	} else {
-		memcpy((void *)load_addr, src, length);
+	} else if (src != (void *)load_addr) {
+		memmove((void *)load_addr, src, length);
 	}
 
 	if (image_info) {
@@ -81,6 +81,7 @@ struct us_data {
 
 	unsigned int	flags;			/* from filter initially */
 #	define USB_READY	(1 << 0)
+#	define USB_NO_BATCH	(1 << 1)	/* HCD cannot queue bulk msgs */
 	unsigned char	ifnum;			/* interface number */
 	unsigned char	ep_in;			/* in endpoint */
 	unsigned char	ep_out;			/* out ....... */
@@ -528,16 +529,12 @@ static int usb_stor_CB_reset(struct us_data *us)
 }
 
 /*
- * Set up the command for a BBB device. Note that the actual SCSI
+ * Fill in the CBW for a BBB device. Note that the actual SCSI
  * command is copied into cbw.CBWCDB.
  */
-static int usb_stor_BBB_comdat(struct scsi_cmd *srb, struct us_data *us)
+static int usb_stor_BBB_cbw(struct scsi_cmd *srb, struct umass_bbb_cbw *cbw)
 {
-	int result;
-	int actlen;
 	int dir_in;
-	unsigned int pipe;
-	ALLOC_CACHE_ALIGN_BUFFER(struct umass_bbb_cbw, cbw, 1);
 
 	dir_in = US_DIRECTION(srb->cmd[0]);
 
@@ -546,8 +543,10 @@ static int usb_stor_BBB_comdat(struct scsi_cmd *srb, struct us_data *us)
 		dir_in, srb->lun, srb->cmdlen, srb->cmd, srb->datalen,
 		srb->pdata);
 	if (srb->cmdlen) {
-		for (result = 0; result < srb->cmdlen; result++)
-			printf("cmd[%d] %#x ", result, srb->cmd[result]);
+		int i;
+
+		for (i = 0; i < srb->cmdlen; i++)
+			printf("cmd[%d] %#x ", i, srb->cmd[i]);
 		printf("\n");
 	}
 #endif
@@ -557,9 +556,6 @@ static int usb_stor_BBB_comdat(struct scsi_cmd *srb, struct us_data *us)
 		return -1;
 	}
 
-	/* always OUT to the ep */
-	pipe = usb_sndbulkpipe(us->pusb_dev, us->ep_out);
-
 	cbw->dCBWSignature = cpu_to_le32(CBWSIGNATURE);
 	cbw->dCBWTag = cpu_to_le32(CBWTag++);
 	cbw->dCBWDataTransferLength = cpu_to_le32(srb->datalen);
@@ -570,6 +566,26 @@ static int usb_stor_BBB_comdat(struct scsi_cmd *srb, struct us_data *us)
 	/* DST SRC LEN!!! */
 
 	memcpy(cbw->CBWCDB, srb->cmd, srb->cmdlen);
+
+	return 0;
+}
+
+/*
+ * Set up the command for a BBB device and send it.
+ */
+static int usb_stor_BBB_comdat(struct scsi_cmd *srb, struct us_data *us)
+{
+	int result;
+	int actlen;
+	unsigned int pipe;
+	ALLOC_CACHE_ALIGN_BUFFER(struct umass_bbb_cbw, cbw, 1);
+
+	result = usb_stor_BBB_cbw(srb, cbw);
+	if (result < 0)
+		return result;
+
+	/* always OUT to the ep */
+	pipe = usb_sndbulkpipe(us->pusb_dev, us->ep_out);
 	result = usb_bulk_msg(us->pusb_dev, pipe, cbw, UMASS_BBB_CBW_SIZE,
 			      &actlen, USB_CNTL_TIMEOUT * 5);
 	if (result < 0)
@@ -704,6 +720,78 @@ static int usb_stor_BBB_clear_endpt_stall(struct us_data *us, __u8 endpt)
 			       endpt, NULL, 0, USB_CNTL_TIMEOUT * 5);
 }
 
+#if CONFIG_IS_ENABLED(DM_USB)
+/*
+ * Queue the CBW, the data and the CSW of a BBB command at once, so the
+ * device does not wait for the host between the phases.
+ *
+ * Returns 0 if the CSW was received, even after a stall in the data
+ * phase, 1 if a stall was cleared and the CSW still has to be read,
+ * -ENOSYS if the host controller cannot queue messages (nothing was sent
+ * then) and -EIO on other errors.
+ */
+static int usb_stor_BBB_batch(struct scsi_cmd *srb, struct us_data *us,
+			      struct umass_bbb_csw *csw, int *data_actlen)
+{
+	ALLOC_CACHE_ALIGN_BUFFER(struct umass_bbb_cbw, cbw, 1);
+	struct usb_bulk_xfer xfers[3], *data = NULL, *status;
+	int dir_in, count = 0, ret;
+
+	ret = usb_stor_BBB_cbw(srb, cbw);
+	if (ret < 0)
+		return -EIO;
+
+	dir_in = US_DIRECTION(srb->cmd[0]);
+	xfers[count].pipe = usb_sndbulkpipe(us->pusb_dev, us->ep_out);
+	xfers[count].buffer = cbw;
+	xfers[count++].length = UMASS_BBB_CBW_SIZE;
+	if (srb->datalen) {
+		data = &xfers[count];
+		data->pipe = dir_in ? usb_rcvbulkpipe(us->pusb_dev, us->ep_in) :
+				      usb_sndbulkpipe(us->pusb_dev, us->ep_out);
+		data->buffer = srb->pdata;
+		data->length = srb->datalen;
+		count++;
+	}
+	status = &xfers[count];
+	status->pipe = usb_rcvbulkpipe(us->pusb_dev, us->ep_in);
+	status->buffer = csw;
+	status->length = UMASS_BBB_CSW_SIZE;
+	count++;
+
+	ret = usb_bulk_batch(us->pusb_dev, xfers, count);
+	if (ret == -ENOSYS) {
+		/* Nothing was sent, so the command tag can be used again */
+		CBWTag--;
+		return ret;
+	}
+	if (data)
+		*data_actlen = data->actual;
+	if (!ret)
+		return 0;
+
+	/* Same as the phase by phase transfer: clear a STALL and read the CSW */
+	if (data && (data->status & USB_ST_STALLED)) {
+		debug("DATA:stall\n");
+		if (usb_stor_BBB_clear_endpt_stall(us, dir_in ? us->ep_in :
+						   us->ep_out) >= 0) {
+			/* After a bulk-out STALL the CSW may already be in */
+			if (!status->status &&
+			    status->actual == UMASS_BBB_CSW_SIZE)
+				return 0;
+			return 1;
+		}
+	} else if (status->status & USB_ST_STALLED) {
+		debug("STATUS:stall\n");
+		if (usb_stor_BBB_clear_endpt_stall(us, us->ep_in) >= 0)
+			return 1;
+	}
+	debug("usb_bulk_batch error status %ld\n", us->pusb_dev->status);
+
+	return -EIO;
+}
+#endif
+
 static int usb_stor_BBB_transport(struct scsi_cmd *srb, struct us_data *us)
 {
 	int result, retry;
@@ -717,6 +805,25 @@ static int usb_stor_BBB_transport(struct scsi_cmd *srb, struct us_data *us)
 #endif
 
 	dir_in = US_DIRECTION(srb->cmd[0]);
+	pipein = usb_rcvbulkpipe(us->pusb_dev, us->ep_in);
+	pipeout = usb_sndbulkpipe(us->pusb_dev, us->ep_out);
+	data_actlen = 0;
+
+#if CONFIG_IS_ENABLED(DM_USB)
+	if (!(us->flags & USB_NO_BATCH)) {
+		debug("COMMAND, DATA and STATUS phase\n");
+		result = usb_stor_BBB_batch(srb, us, csw, &data_actlen);
+		if (!result)
+			goto csw;
+		if (result > 0)
+			goto st;
+		if (result != -ENOSYS) {
+			usb_stor_BBB_reset(us);
+			return USB_STOR_TRANSPORT_FAILED;
+		}
+		us->flags |= USB_NO_BATCH;
+	}
+#endif
 
 	/* COMMAND phase */
 	debug("COMMAND phase\n");
@@ -729,10 +836,7 @@ static int usb_stor_BBB_transport(struct scsi_cmd *srb, struct us_data *us)
 	}
 	if (!(us->flags & USB_READY))
 		mdelay(5);
-	pipein = usb_rcvbulkpipe(us->pusb_dev, us->ep_in);
-	pipeout = usb_sndbulkpipe(us->pusb_dev, us->ep_out);
 	/* DATA phase + error handling */
-	data_actlen = 0;
 	/* no data, go immediately to the STATUS phase */
 	if (srb->datalen == 0)
 		goto st;
@@ -789,6 +893,9 @@ again:
 		usb_stor_BBB_reset(us);
 		return USB_STOR_TRANSPORT_FAILED;
 	}
+#if CONFIG_IS_ENABLED(DM_USB)
+csw:
+#endif
 #ifdef BBB_XPORT_TRACE
 	ptr = (unsigned char *)csw;
 	for (index = 0; index < UMASS_BBB_CSW_SIZE; index++)
@@ -958,6 +1065,9 @@ static void usb_stor_set_max_xfer_blk(struct usb_device *udev,
 	 * Windows 7 limiting transfers to 128 sectors for both USB2 and USB3
 	 * and Apple Mac OS X 10.11 limiting transfers to 256 sectors for USB2
 	 * and 2048 for USB3 devices.
+	 *
+	 * Follow OS X for USB3 devices, which are recent enough to cope and
+	 * need large transfers to get anywhere near their bandwidth.
 	 */
 	unsigned short blk = 240;
 
@@ -965,6 +1075,9 @@ static void usb_stor_set_max_xfer_blk(struct usb_device *udev,
 	size_t size;
 	int ret;
 
+	if (udev->speed >= USB_SPEED_SUPER)
+		blk = 2048;
+
 	ret = usb_get_max_xfer_size(udev, (size_t *)&size);
 	if ((ret >= 0) && (size < blk * 512))
 		blk = size / 512;
@@ -7,6 +7,7 @@
 
 #include <common.h>
 #include <command.h>
+#include <crypto.h>
 #include <errno.h>
 #include <ide.h>
 #include <malloc.h>
@@ -242,6 +243,9 @@ void part_init(struct blk_desc *dev_desc)
 	struct part_driver *entry;
 
 	blkcache_invalidate(dev_desc->if_type, dev_desc->devnum);
+	blk_readahead_invalidate(dev_desc);
+	crypto_digest_cache_invalidate(dev_desc);
+	blk_bump_gen(dev_desc);
 
 	dev_desc->part_type = PART_TYPE_UNKNOWN;
 	for (entry = drv; entry != drv + n_ents; entry++) {
@@ -0,0 +1,164 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Copyright (c) 2026 Rockchip Electronics Co., Ltd
+ *
+ * Sequential read-ahead for block devices
+ */
+
+#include <common.h>
+#include <blk.h>
+#include <malloc.h>
+#include <memalign.h>
+#include <linux/err.h>
+#include <linux/sizes.h>
+
+/*
+ * Callers that stream a region through many small blk_dread() calls
+ * (filesystems walking clusters, sparse/AVB readers, resource parsers)
+ * pay the per-command setup cost of the controller for each of them.
+ * Once a stream is seen to be sequential, the next request is extended
+ * by a read-ahead window that grows up to CONFIG_BLOCK_READAHEAD_SIZE,
+ * and following requests are then served from that window.
+ *
+ * Requests that are already at least as large as the window go to the
+ * device directly, so large image loads are never copied twice.
+ */
+#define BLK_RA_MIN_WINDOW	SZ_32K
+
+struct blk_readahead {
+	lbaint_t next;		/* block following the previous request */
+	lbaint_t start;		/* first block held in @buf */
+	lbaint_t cnt;		/* number of blocks held in @buf */
+	lbaint_t window;	/* current read-ahead window, in blocks */
+	int hwpart;		/* hardware partition @buf belongs to */
+	char *buf;
+};
+
+static ulong blk_ra_size(struct blk_desc *desc)
+{
+	return (CONFIG_BLOCK_READAHEAD_SIZE << 10) / desc->blksz;
+}
+
+static void blk_ra_update_window(struct blk_desc *desc,
+				 struct blk_readahead *ra,
+				 lbaint_t start, lbaint_t blkcnt)
+{
+	lbaint_t max = blk_ra_size(desc);
+
+	if (start != ra->next)
+		ra->window = 0;
+	else if (!ra->window)
+		ra->window = max_t(lbaint_t, BLK_RA_MIN_WINDOW / desc->blksz, 1);
+	else if (ra->window < max)
+		ra->window = min_t(lbaint_t, ra->window * 2, max);
+
+	ra->next = start + blkcnt;
+}
+
+static ulong blk_ra_direct(struct blk_desc *desc, lbaint_t start,
+			   lbaint_t blkcnt, void *buffer, lbaint_t done,
+			   blk_read_fn read)
+{
+	ulong ret;
+
+	ret = read(desc, start + done, blkcnt - done,
+		   (char *)buffer + done * desc->blksz);
+	if (IS_ERR_VALUE(ret))
+		return done ? done : ret;
+
+	return done + ret;
+}
+
+ulong blk_readahead_read(struct blk_desc *desc, lbaint_t start,
+			 lbaint_t blkcnt, void *buffer, blk_read_fn read)
+{
+	struct blk_readahead *ra = desc->ra;
+	lbaint_t max = blk_ra_size(desc);
+	lbaint_t done = 0, rest, cnt;
+	ulong ret;
+
+	if (!max || !blkcnt)
+		return read(desc, start, blkcnt, buffer);
+
+	if (!ra) {
+		ra = calloc(1, sizeof(*ra));
+		if (!ra)
+			return read(desc, start, blkcnt, buffer);
+		ra->next = ~(lbaint_t)0;
+		desc->ra = ra;
+	}
+
+	if (ra->hwpart != desc->hwpart) {
+		ra->cnt = 0;
+		ra->next = ~(lbaint_t)0;
+		ra->hwpart = desc->hwpart;
+	}
+
+	/* serve what we can from the window */
+	if (ra->cnt && start >= ra->start && start < ra->start + ra->cnt) {
+		done = min(blkcnt, ra->start + ra->cnt - start);
+		memcpy(buffer, ra->buf + (start - ra->start) * desc->blksz,
+		       done * desc->blksz);
+		debug("%s: window hit " LBAF " +" LBAFU "\n",
+		      __func__, start, done);
+	}
+
+	blk_ra_update_window(desc, ra, start, blkcnt);
+	if (done == blkcnt)
+		return blkcnt;
+
+	rest = blkcnt - done;
+	if (!ra->window || rest >= max)
+		return blk_ra_direct(desc, start, blkcnt, buffer, done, read);
+
+	cnt = min(rest + ra->window, max);
+	if (desc->lba && start + done + cnt > desc->lba)
+		cnt = desc->lba - (start + done);
+	if (cnt <= rest)
+		return blk_ra_direct(desc, start, blkcnt, buffer, done, read);
+
+	if (!ra->buf) {
+		ra->buf = memalign(ARCH_DMA_MINALIGN, max * desc->blksz);
+		if (!ra->buf)
+			return blk_ra_direct(desc, start, blkcnt, buffer,
+					     done, read);
+	}
+
+	ra->cnt = 0;
+	ret = read(desc, start + done, cnt, ra->buf);
+	if (ret != cnt)
+		return blk_ra_direct(desc, start, blkcnt, buffer, done, read);
+
+	debug("%s: fetched " LBAF " +" LBAFU " for " LBAFU "\n",
+	      __func__, start + done, cnt, rest);
+	ra->start = start + done;
+	ra->cnt = cnt;
+	memcpy((char *)buffer + done * desc->blksz, ra->buf,
+	       rest * desc->blksz);
+
+	return blkcnt;
+}
+
+void blk_readahead_invalidate(struct blk_desc *desc)
+{
+	struct blk_readahead *ra = desc->ra;
+
+	if (!ra)
+		return;
+
+	ra->cnt = 0;
+	ra->window = 0;
+	ra->next = ~(lbaint_t)0;
+}
+
+void blk_readahead_release(struct blk_desc *desc)
+{
+	struct blk_readahead *ra = desc->ra;
+
+	if (!ra)
+		return;
+
+	free(ra->buf);
+	free(ra);
+	desc->ra = NULL;
+}
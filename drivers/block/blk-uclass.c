@@ -7,10 +7,14 @@
 
 #include <common.h>
 #include <blk.h>
+#include <crypto.h>
 #include <dm.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
 #include <dm/uclass-internal.h>
+#include <linux/err.h>
+
+u32 blk_gen_counter;
 
 static const char *if_typename_str[IF_TYPE_COUNT] = {
 	[IF_TYPE_IDE]		= "ide",
@@ -357,12 +361,20 @@ ulong blk_erase_devnum(enum if_type if_type, int devnum, lbaint_t start,
 int blk_select_hwpart(struct udevice *dev, int hwpart)
 {
 	const struct blk_ops *ops = blk_get_ops(dev);
+	struct blk_desc *desc = dev_get_uclass_platdata(dev);
 
 	if (!ops)
 		return -ENOSYS;
 	if (!ops->select_hwpart)
 		return 0;
 
+	/* Another hardware partition shows other data at the same blocks */
+	if (desc->hwpart != hwpart) {
+		blk_readahead_invalidate(desc);
+		crypto_digest_cache_invalidate(desc);
+		blk_bump_gen(desc);
+	}
+
 	return ops->select_hwpart(dev, hwpart);
 }
 
@@ -446,25 +458,82 @@ int blk_get_device(int if_type, int devnum, struct udevice **devp)
 	return device_probe(*devp);
 }
 
+static ulong blk_ops_read(struct blk_desc *block_dev, lbaint_t start,
+			  lbaint_t blkcnt, void *buffer)
+{
+	struct udevice *dev = block_dev->bdev;
+
+	return blk_get_ops(dev)->read(dev, start, blkcnt, buffer);
+}
+
 unsigned long blk_dread(struct blk_desc *block_dev, lbaint_t start,
 			lbaint_t blkcnt, void *buffer)
 {
 	struct udevice *dev = block_dev->bdev;
 	const struct blk_ops *ops = blk_get_ops(dev);
-	ulong blks_read;
+	ulong blks_read, cached;
 
 	if (!ops->read)
 		return -ENOSYS;
 
-	if (blkcache_read(block_dev->if_type, block_dev->devnum,
-			  start, blkcnt, block_dev->blksz, buffer))
+	cached = blkcache_read(block_dev->if_type, block_dev->devnum,
+			       start, blkcnt, block_dev->blksz, buffer);
+	if (cached == blkcnt)
 		return blkcnt;
-	blks_read = ops->read(dev, start, blkcnt, buffer);
-	if (blks_read == blkcnt)
+
+	/* only fetch the tail the cache could not provide */
+	start += cached;
+	buffer += cached * block_dev->blksz;
+
+	blks_read = blk_readahead_read(block_dev, start, blkcnt - cached,
+				       buffer, blk_ops_read);
+	if (blks_read != blkcnt - cached)
+		return IS_ERR_VALUE(blks_read) ? blks_read : cached + blks_read;
+
+	blkcache_fill(block_dev->if_type, block_dev->devnum,
+		      start, blks_read, block_dev->blksz, buffer);
+
+	return blkcnt;
+}
+
+unsigned long blk_dread_direct(struct blk_desc *block_dev, lbaint_t start,
+			       lbaint_t blkcnt, void *buffer)
+{
+	const struct blk_ops *ops = blk_get_ops(block_dev->bdev);
+
+	if (!ops->read)
+		return -ENOSYS;
+
+	return blk_ops_read(block_dev, start, blkcnt, buffer);
+}
+
+int blk_dread_segs(struct blk_desc *block_dev, struct blk_seg *segs,
+		   int count)
+{
+	struct udevice *dev = block_dev->bdev;
+	const struct blk_ops *ops = blk_get_ops(dev);
+	int i, ret;
+
+	if (!ops->read_segs || count < 2) {
+		for (i = 0; i < count; i++) {
+			if (blk_dread(block_dev, segs[i].start, segs[i].blkcnt,
+				      segs[i].buffer) != segs[i].blkcnt)
+				return -EIO;
+		}
+		return 0;
+	}
+
+	/* Scattered runs gain nothing from the cache or from readahead */
+	ret = ops->read_segs(dev, segs, count);
+	if (ret)
+		return ret;
+
+	for (i = 0; i < count; i++)
 		blkcache_fill(block_dev->if_type, block_dev->devnum,
-			      start, blkcnt, block_dev->blksz, buffer);
+			      segs[i].start, segs[i].blkcnt, block_dev->blksz,
+			      segs[i].buffer);
 
-	return blks_read;
+	return 0;
 }
 
 unsigned long blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
@@ -477,6 +546,8 @@ unsigned long blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
 		return -ENOSYS;
 
 	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
+	blk_readahead_invalidate(block_dev);
+	blk_bump_gen(block_dev);
 	return ops->write(dev, start, blkcnt, buffer);
 }
 
@@ -490,6 +561,8 @@ unsigned long blk_derase(struct blk_desc *block_dev, lbaint_t start,
 		return -ENOSYS;
 
 	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
+	blk_readahead_invalidate(block_dev);
+	blk_bump_gen(block_dev);
 	return ops->erase(dev, start, blkcnt);
 }
 
@@ -676,8 +749,16 @@ int blk_unbind_all(int if_type)
 	return 0;
 }
 
+static int blk_pre_remove(struct udevice *dev)
+{
+	blk_readahead_release(dev_get_uclass_platdata(dev));
+
+	return 0;
+}
+
 UCLASS_DRIVER(blk) = {
 	.id		= UCLASS_BLK,
 	.name		= "blk",
+	.pre_remove	= blk_pre_remove,
 	.per_device_platdata_auto_alloc_size = sizeof(struct blk_desc),
 };
@@ -6,8 +6,11 @@
  */
 
 #include <common.h>
+#include <crypto.h>
 #include <linux/err.h>
 
+u32 blk_gen_counter;
+
 struct blk_driver *blk_driver_lookup_type(int if_type)
 {
 	struct blk_driver *drv = ll_entry_start(struct blk_driver, blk_driver);
@@ -195,8 +198,15 @@ int blk_dselect_hwpart(struct blk_desc *desc, int hwpart)
 
 	if (!drv)
 		return -ENOSYS;
-	if (drv->select_hwpart)
+	if (drv->select_hwpart) {
+		/* Another hwpart shows other data at the same blocks */
+		if (desc->hwpart != hwpart) {
+			blk_readahead_invalidate(desc);
+			crypto_digest_cache_invalidate(desc);
+			blk_bump_gen(desc);
+		}
 		return drv->select_hwpart(desc, hwpart);
+	}
 
 	return 0;
 }
@@ -261,5 +271,5 @@ int blk_select_hwpart_devnum(enum if_type if_type, int devnum, int hwpart)
 	ret = get_desc(drv, devnum, &desc);
 	if (ret)
 		return ret;
-	return drv->select_hwpart(desc, hwpart);
+	return blk_dselect_hwpart(desc, hwpart);
 }
@@ -11,163 +11,425 @@
 #include <part.h>
 #include <linux/ctype.h>
 #include <linux/list.h>
+#include <linux/log2.h>
 
-struct block_cache_node {
+/*
+ * The cache is organised as a hashed, set-associative array of lines.
+ * Each line covers an aligned run of 'max_blocks_per_entry' blocks of one
+ * device and carries a bitmap of the blocks it actually holds, so small
+ * metadata reads that never fill a whole line can still be served.
+ *
+ * Every device gets a budget (in bytes) of line memory it may own; once a
+ * device is over budget it may only recycle its own lines, so one busy
+ * device cannot flush the metadata of all the others.
+ */
+#define BLKCACHE_WAYS		4
+#define BLKCACHE_MAX_LINE_BLKS	32	/* bits in block_cache_line.valid */
+#define BLKCACHE_MAX_FILL_LINES	4	/* don't cache big stuff */
+
+struct block_cache_dev {
 	struct list_head lh;
 	int iftype;
 	int devnum;
-	lbaint_t start;
-	lbaint_t blkcnt;
+	unsigned long budget;
+	unsigned long used;
+	unsigned hits;
+	unsigned partial_hits;
+	unsigned misses;
+};
+
+struct block_cache_line {
+	struct block_cache_dev *dev;	/* NULL if the line is free */
+	lbaint_t tag;			/* first block covered by the line */
 	unsigned long blksz;
+	unsigned long stamp;		/* for LRU replacement within a set */
+	u32 valid;			/* bitmap of blocks held */
 	char *cache;
 };
 
-static LIST_HEAD(block_cache);
+static LIST_HEAD(block_cache_devs);
+static struct block_cache_line *block_cache;
+static unsigned long block_cache_clock;
 
 static struct block_cache_stats _stats = {
-	.max_blocks_per_entry = 2,
-	.max_entries = 32
+	.max_blocks_per_entry = 8,
+	.max_entries = 1024
 };
 
-static struct block_cache_node *cache_find(int iftype, int devnum,
-					   lbaint_t start, lbaint_t blkcnt,
-					   unsigned long blksz)
-{
-	struct block_cache_node *node;
-
-	list_for_each_entry(node, &block_cache, lh)
-		if ((node->iftype == iftype) &&
-		    (node->devnum == devnum) &&
-		    (node->blksz == blksz) &&
-		    (node->start <= start) &&
-		    (node->start + node->blkcnt >= start + blkcnt)) {
-			if (block_cache.next != &node->lh) {
-				/* maintain MRU ordering */
-				list_del(&node->lh);
-				list_add(&node->lh, &block_cache);
-			}
-			return node;
-		}
+static struct block_cache_dev *cache_dev(int iftype, int devnum, bool create)
+{
+	struct block_cache_dev *bdev;
+
+	list_for_each_entry(bdev, &block_cache_devs, lh)
+		if (bdev->iftype == iftype && bdev->devnum == devnum)
+			return bdev;
+
+	if (!create)
+		return NULL;
+
+	bdev = calloc(1, sizeof(*bdev));
+	if (!bdev)
+		return NULL;
+
+	bdev->iftype = iftype;
+	bdev->devnum = devnum;
+	bdev->budget = CONFIG_BLOCK_CACHE_DEV_BUDGET << 20;
+	list_add_tail(&bdev->lh, &block_cache_devs);
+
+	return bdev;
+}
+
+static unsigned int cache_line_shift(void)
+{
+	return ilog2(_stats.max_blocks_per_entry);
+}
+
+static struct block_cache_line *cache_set(struct block_cache_dev *bdev,
+					  lbaint_t tag)
+{
+	unsigned int set_bits = ilog2(_stats.max_entries / BLKCACHE_WAYS);
+	u64 key;
+
+	if (!set_bits)
+		return block_cache;
+
+	key = ((u64)tag >> cache_line_shift()) ^
+	      ((u64)bdev->iftype << 56) ^ ((u64)bdev->devnum << 48);
+	key *= 0x9e3779b97f4a7c15ULL;
+
+	return block_cache + (key >> (64 - set_bits)) * BLKCACHE_WAYS;
+}
+
+static struct block_cache_line *cache_lookup(struct block_cache_dev *bdev,
+					     lbaint_t tag, unsigned long blksz)
+{
+	struct block_cache_line *set = cache_set(bdev, tag);
+	int way;
+
+	for (way = 0; way < BLKCACHE_WAYS; way++)
+		if (set[way].dev == bdev &&
+		    set[way].tag == tag &&
+		    set[way].blksz == blksz)
+			return &set[way];
+
+	return NULL;
+}
+
+static unsigned long cache_line_bytes(unsigned long blksz)
+{
+	return blksz * _stats.max_blocks_per_entry;
+}
+
+static void cache_drop(struct block_cache_line *line)
+{
+	if (!line->dev)
+		return;
+
+	debug("drop: start " LBAF ", count %u\n",
+	      line->tag, _stats.max_blocks_per_entry);
+	line->dev->used -= cache_line_bytes(line->blksz);
+	line->dev = NULL;
+	line->valid = 0;
+	_stats.entries--;
+}
+
+static void cache_free_all(void)
+{
+	struct block_cache_dev *bdev;
+	int i;
+
+	if (block_cache) {
+		for (i = 0; i < _stats.max_entries; i++)
+			free(block_cache[i].cache);
+		free(block_cache);
+		block_cache = NULL;
+	}
+
+	list_for_each_entry(bdev, &block_cache_devs, lh)
+		bdev->used = 0;
+	_stats.entries = 0;
+}
+
+static int cache_alloc(void)
+{
+	if (block_cache)
+		return 0;
+
+	block_cache = calloc(_stats.max_entries, sizeof(*block_cache));
+	if (!block_cache)
+		return -ENOMEM;
+
 	return 0;
 }
 
+/*
+ * Pick the line to (re)use for @bdev in @set. Free ways are preferred
+ * while the device is within its budget; a device over budget recycles
+ * the least recently used of its own lines, and returns NULL if it holds
+ * none in this set.
+ */
+static struct block_cache_line *cache_victim(struct block_cache_dev *bdev,
+					     struct block_cache_line *set,
+					     unsigned long bytes)
+{
+	struct block_cache_line *lru = NULL, *own = NULL;
+	int way;
+
+	for (way = 0; way < BLKCACHE_WAYS; way++) {
+		struct block_cache_line *line = &set[way];
+
+		if (!line->dev) {
+			if (bdev->used + bytes <= bdev->budget)
+				return line;
+			continue;
+		}
+		if (!lru || line->stamp < lru->stamp)
+			lru = line;
+		if (line->dev == bdev && (!own || line->stamp < own->stamp))
+			own = line;
+	}
+
+	if (bdev->used + bytes > bdev->budget)
+		return own;
+
+	return lru;
+}
+
+static struct block_cache_line *cache_get_line(struct block_cache_dev *bdev,
+					       lbaint_t tag,
+					       unsigned long blksz)
+{
+	struct block_cache_line *line;
+	unsigned long bytes = cache_line_bytes(blksz);
+
+	line = cache_lookup(bdev, tag, blksz);
+	if (line)
+		return line;
+
+	line = cache_victim(bdev, cache_set(bdev, tag), bytes);
+	if (!line)
+		return NULL;
+
+	cache_drop(line);
+	if (line->cache && line->blksz != blksz) {
+		free(line->cache);
+		line->cache = NULL;
+	}
+	if (!line->cache) {
+		line->cache = malloc(bytes);
+		if (!line->cache)
+			return NULL;
+	}
+
+	line->dev = bdev;
+	line->tag = tag;
+	line->blksz = blksz;
+	line->valid = 0;
+	bdev->used += bytes;
+	_stats.entries++;
+
+	return line;
+}
+
 int blkcache_read(int iftype, int devnum,
 		  lbaint_t start, lbaint_t blkcnt,
 		  unsigned long blksz, void *buffer)
 {
-	struct block_cache_node *node = cache_find(iftype, devnum, start,
-						   blkcnt, blksz);
-	if (node) {
-		const char *src = node->cache + (start - node->start) * blksz;
-		memcpy(buffer, src, blksz * blkcnt);
+	lbaint_t mask = _stats.max_blocks_per_entry - 1;
+	struct block_cache_dev *bdev;
+	lbaint_t done = 0;
+
+	if (!blkcnt)
+		return 0;
+
+	bdev = cache_dev(iftype, devnum, false);
+	if (!bdev || !bdev->used)
+		goto out;
+
+	/* serve the longest cached prefix of the request */
+	while (done < blkcnt) {
+		lbaint_t blk = start + done;
+		struct block_cache_line *line;
+		unsigned int first = blk & mask;
+		unsigned int n = 0;
+
+		line = cache_lookup(bdev, blk & ~mask, blksz);
+		if (!line)
+			break;
+
+		while (first + n <= mask && done + n < blkcnt &&
+		       (line->valid & (1U << (first + n))))
+			n++;
+		if (!n)
+			break;
+
+		memcpy((char *)buffer + done * blksz,
+		       line->cache + first * blksz, n * blksz);
+		line->stamp = ++block_cache_clock;
+		done += n;
+		if (first + n <= mask)
+			break;
+	}
+
+out:
+	if (done == blkcnt) {
 		debug("hit: start " LBAF ", count " LBAFU "\n",
 		      start, blkcnt);
 		++_stats.hits;
-		return 1;
+		++bdev->hits;
+	} else if (done) {
+		debug("partial: start " LBAF ", count " LBAFU ", cached " LBAFU "\n",
+		      start, blkcnt, done);
+		++_stats.partial_hits;
+		++bdev->partial_hits;
+	} else {
+		debug("miss: start " LBAF ", count " LBAFU "\n",
+		      start, blkcnt);
+		++_stats.misses;
+		if (bdev)
+			++bdev->misses;
 	}
 
-	debug("miss: start " LBAF ", count " LBAFU "\n",
-	      start, blkcnt);
-	++_stats.misses;
-	return 0;
+	return done;
 }
 
 void blkcache_fill(int iftype, int devnum,
 		   lbaint_t start, lbaint_t blkcnt,
 		   unsigned long blksz, void const *buffer)
 {
-	lbaint_t bytes;
-	struct block_cache_node *node;
+	lbaint_t mask = _stats.max_blocks_per_entry - 1;
+	struct block_cache_dev *bdev;
+	lbaint_t done = 0;
 
 	/* don't cache big stuff */
-	if (blkcnt > _stats.max_blocks_per_entry)
+	if (blkcnt > _stats.max_blocks_per_entry * BLKCACHE_MAX_FILL_LINES)
 		return;
 
 	if (_stats.max_entries == 0)
 		return;
 
-	bytes = blksz * blkcnt;
-	if (_stats.max_entries <= _stats.entries) {
-		/* pop LRU */
-		node = (struct block_cache_node *)block_cache.prev;
-		list_del(&node->lh);
-		_stats.entries--;
-		debug("drop: start " LBAF ", count " LBAFU "\n",
-		      node->start, node->blkcnt);
-		if (node->blkcnt * node->blksz < bytes) {
-			free(node->cache);
-			node->cache = 0;
-		}
-	} else {
-		node = malloc(sizeof(*node));
-		if (!node)
-			return;
-		node->cache = 0;
-	}
-
-	if (!node->cache) {
-		node->cache = malloc(bytes);
-		if (!node->cache) {
-			free(node);
-			return;
-		}
-	}
+	bdev = cache_dev(iftype, devnum, true);
+	if (!bdev || !bdev->budget || cache_alloc())
+		return;
 
 	debug("fill: start " LBAF ", count " LBAFU "\n",
 	      start, blkcnt);
 
-	node->iftype = iftype;
-	node->devnum = devnum;
-	node->start = start;
-	node->blkcnt = blkcnt;
-	node->blksz = blksz;
-	memcpy(node->cache, buffer, bytes);
-	list_add(&node->lh, &block_cache);
-	_stats.entries++;
+	while (done < blkcnt) {
+		lbaint_t blk = start + done;
+		struct block_cache_line *line;
+		unsigned int first = blk & mask;
+		unsigned int n = min_t(lbaint_t, mask + 1 - first,
+				       blkcnt - done);
+
+		line = cache_get_line(bdev, blk & ~mask, blksz);
+		if (!line)
+			return;
+
+		memcpy(line->cache + first * blksz,
+		       (const char *)buffer + done * blksz, n * blksz);
+		if (n == BLKCACHE_MAX_LINE_BLKS)
+			line->valid = ~0U;
+		else
+			line->valid |= ((1U << n) - 1) << first;
+		line->stamp = ++block_cache_clock;
+		done += n;
+	}
 }
 
 void blkcache_invalidate(int iftype, int devnum)
 {
-	struct list_head *entry, *n;
-	struct block_cache_node *node;
-
-	list_for_each_safe(entry, n, &block_cache) {
-		node = (struct block_cache_node *)entry;
-		if ((node->iftype == iftype) &&
-		    (node->devnum == devnum)) {
-			list_del(entry);
-			free(node->cache);
-			free(node);
-			--_stats.entries;
-		}
+	struct block_cache_dev *bdev;
+	int i;
+
+	bdev = cache_dev(iftype, devnum, false);
+	if (!bdev || !bdev->used)
+		return;
+
+	for (i = 0; i < _stats.max_entries; i++) {
+		if (block_cache[i].dev != bdev)
+			continue;
+		cache_drop(&block_cache[i]);
+		free(block_cache[i].cache);
+		block_cache[i].cache = NULL;
 	}
 }
 
-void blkcache_configure(unsigned blocks, unsigned entries)
+int blkcache_configure(unsigned blocks, unsigned entries)
 {
-	struct block_cache_node *node;
+	if (blocks > BLKCACHE_MAX_LINE_BLKS ||
+	    (blocks && !is_power_of_2(blocks)))
+		return -EINVAL;
+
+	/* whole number of sets, and a power of two of them */
+	if (entries < BLKCACHE_WAYS || !blocks)
+		entries = 0;
+	else
+		entries = rounddown_pow_of_two(entries / BLKCACHE_WAYS) *
+			  BLKCACHE_WAYS;
+
 	if ((blocks != _stats.max_blocks_per_entry) ||
-	    (entries != _stats.max_entries)) {
-		/* invalidate cache */
-		while (!list_empty(&block_cache)) {
-			node = (struct block_cache_node *)block_cache.next;
-			list_del(&node->lh);
-			free(node->cache);
-			free(node);
-		}
-		_stats.entries = 0;
-	}
+	    (entries != _stats.max_entries))
+		cache_free_all();
 
 	_stats.max_blocks_per_entry = blocks;
 	_stats.max_entries = entries;
 
 	_stats.hits = 0;
+	_stats.partial_hits = 0;
 	_stats.misses = 0;
+
+	return 0;
+}
+
+int blkcache_set_budget(int iftype, int devnum, unsigned mib)
+{
+	struct block_cache_dev *bdev;
+
+	bdev = cache_dev(iftype, devnum, true);
+	if (!bdev)
+		return -ENOMEM;
+
+	bdev->budget = (unsigned long)mib << 20;
+	if (bdev->used > bdev->budget)
+		blkcache_invalidate(iftype, devnum);
+
+	return 0;
+}
+
+int blkcache_dev_stats(int index, struct block_cache_dev_stats *stats)
+{
+	struct block_cache_dev *bdev;
+
+	list_for_each_entry(bdev, &block_cache_devs, lh) {
+		if (index--)
+			continue;
+
+		stats->iftype = bdev->iftype;
+		stats->devnum = bdev->devnum;
+		stats->hits = bdev->hits;
+		stats->partial_hits = bdev->partial_hits;
+		stats->misses = bdev->misses;
+		stats->used = bdev->used;
+		stats->budget = bdev->budget;
+		return 0;
+	}
+
+	return -ENOENT;
 }
 
 void blkcache_stats(struct block_cache_stats *stats)
 {
+	struct block_cache_dev *bdev;
+
 	memcpy(stats, &_stats, sizeof(*stats));
 	_stats.hits = 0;
+	_stats.partial_hits = 0;
 	_stats.misses = 0;
+
+	list_for_each_entry(bdev, &block_cache_devs, lh) {
+		bdev->hits = 0;
+		bdev->partial_hits = 0;
+		bdev->misses = 0;
+	}
 }
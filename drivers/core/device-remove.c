@@ -169,6 +169,10 @@ int device_remove(struct udevice *dev, uint flags)
 	if (!dev)
 		return -EINVAL;
 
+	/* Let a half-probed device finish so that remove() sees it whole */
+	if (dev->flags & DM_FLAG_PROBE_PENDING)
+		device_probe(dev);
+
 	if (!(dev->flags & DM_FLAG_ACTIVATED))
 		return 0;
 
@@ -15,6 +15,7 @@
 #include <fdtdec.h>
 #include <fdt_support.h>
 #include <malloc.h>
+#include <watchdog.h>
 #include <dm/device.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
@@ -401,7 +402,59 @@ static void *alloc_priv(int size, uint flags)
 	return priv;
 }
 
-int device_probe(struct udevice *dev)
+/* Last part of probing, once the driver has completed */
+static int device_probe_post(struct udevice *dev)
+{
+	int ret;
+
+	ret = uclass_post_probe_device(dev);
+	if (ret) {
+		if (device_remove(dev, DM_REMOVE_NORMAL)) {
+			dm_warn("%s: Device '%s' failed to remove on error path\n",
+				__func__, dev->name);
+		}
+		dev->flags &= ~DM_FLAG_ACTIVATED;
+		dev->seq = -1;
+		device_free(dev);
+		return ret;
+	}
+
+	if (dev->parent && device_get_uclass_id(dev) == UCLASS_PINCTRL)
+		pinctrl_select_state(dev, "default");
+
+	return 0;
+}
+
+static int device_probe_finish(struct udevice *dev, bool wait)
+{
+	const struct driver *drv = dev->driver;
+	int ret;
+
+	/* Look active to anything the driver probes from here */
+	dev->flags |= DM_FLAG_ACTIVATED;
+	do {
+		ret = drv->probe_finish(dev);
+		if (ret == -EAGAIN)
+			WATCHDOG_RESET();
+	} while (ret == -EAGAIN && wait);
+
+	if (ret == -EAGAIN) {
+		dev->flags &= ~DM_FLAG_ACTIVATED;
+		return ret;
+	}
+
+	dev->flags &= ~DM_FLAG_PROBE_PENDING;
+	if (ret) {
+		dev->flags &= ~DM_FLAG_ACTIVATED;
+		dev->seq = -1;
+		device_free(dev);
+		return ret;
+	}
+
+	return device_probe_post(dev);
+}
+
+static int device_probe_common(struct udevice *dev, bool start_only)
 {
 	const struct driver *drv;
 	int size = 0;
@@ -414,6 +467,9 @@ int device_probe(struct udevice *dev)
 	if (dev->flags & DM_FLAG_ACTIVATED)
 		return 0;
 
+	if (dev->flags & DM_FLAG_PROBE_PENDING)
+		return start_only ? 0 : device_probe_finish(dev, true);
+
 	drv = dev->driver;
 	assert(drv);
 
@@ -506,19 +562,16 @@ int device_probe(struct udevice *dev)
 		}
 	}
 
-	ret = uclass_post_probe_device(dev);
-	if (ret)
-		goto fail_uclass;
-
-	if (dev->parent && device_get_uclass_id(dev) == UCLASS_PINCTRL)
-		pinctrl_select_state(dev, "default");
+	if (drv->probe_finish) {
+		dev->flags &= ~DM_FLAG_ACTIVATED;
+		dev->flags |= DM_FLAG_PROBE_PENDING;
+		if (start_only)
+			return 0;
 
-	return 0;
-fail_uclass:
-	if (device_remove(dev, DM_REMOVE_NORMAL)) {
-		dm_warn("%s: Device '%s' failed to remove on error path\n",
-			__func__, dev->name);
+		return device_probe_finish(dev, true);
 	}
+
+	return device_probe_post(dev);
 fail:
 	dev->flags &= ~DM_FLAG_ACTIVATED;
 
@@ -528,6 +581,27 @@ fail:
 	return ret;
 }
 
+int device_probe(struct udevice *dev)
+{
+	return device_probe_common(dev, false);
+}
+
+int device_probe_start(struct udevice *dev)
+{
+	return device_probe_common(dev, true);
+}
+
+int device_probe_step(struct udevice *dev)
+{
+	if (!dev)
+		return -EINVAL;
+
+	if (!(dev->flags & DM_FLAG_PROBE_PENDING))
+		return device_probe(dev);
+
+	return device_probe_finish(dev, false);
+}
+
 void *dev_get_platdata(struct udevice *dev)
 {
 	if (!dev) {
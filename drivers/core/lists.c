@@ -17,6 +17,9 @@
 #include <dm/util.h>
 #include <fdtdec.h>
 #include <linux/compiler.h>
+#include <malloc.h>
+
+DECLARE_GLOBAL_DATA_PTR;
 
 struct driver *lists_driver_lookup_name(const char *name)
 {
@@ -123,10 +126,122 @@ static int driver_check_compatible(const struct udevice_id *of_match,
 	return -ENOENT;
 }
 
-int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp)
+#if CONFIG_IS_ENABLED(DM_OF_INDEX)
+/**
+ * struct driver_compat - entry of the compatible-string lookup table
+ *
+ * @compat:	Compatible string
+ * @drv:	First driver (in linker-list order) matching @compat
+ * @id:		The entry of @drv's of_match table that matched
+ * @next:	Next entry in the same hash bucket
+ */
+struct driver_compat {
+	const char *compat;
+	struct driver *drv;
+	const struct udevice_id *id;
+	struct driver_compat *next;
+};
+
+static struct driver_compat **driver_compat_tbl;
+static uint driver_compat_mask;
+
+static uint driver_compat_hash(const char *compat)
+{
+	uint hash = 0;
+
+	while (*compat)
+		hash = hash * 31 + *compat++;
+
+	return hash & driver_compat_mask;
+}
+
+static int driver_compat_index_build(void)
 {
 	struct driver *driver = ll_entry_start(struct driver, driver);
 	const int n_ents = ll_entry_count(struct driver, driver);
+	const struct udevice_id *of_match;
+	struct driver_compat *ent, **bucket;
+	struct driver *entry;
+	uint count = 0, size = 1;
+
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		for (of_match = entry->of_match; of_match && of_match->compatible;
+		     of_match++)
+			count++;
+	}
+	while (size < count)
+		size <<= 1;
+
+	driver_compat_tbl = calloc(1, size * sizeof(*driver_compat_tbl) +
+				   count * sizeof(*ent));
+	if (!driver_compat_tbl)
+		return -ENOMEM;
+	driver_compat_mask = size - 1;
+
+	/* Keep the first match only, as the linear search would */
+	ent = (struct driver_compat *)(driver_compat_tbl + size);
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		for (of_match = entry->of_match; of_match && of_match->compatible;
+		     of_match++) {
+			bucket = &driver_compat_tbl[driver_compat_hash(
+							of_match->compatible)];
+			while (*bucket && strcmp((*bucket)->compat,
+						 of_match->compatible))
+				bucket = &(*bucket)->next;
+			if (*bucket)
+				continue;
+			ent->compat = of_match->compatible;
+			ent->drv = entry;
+			ent->id = of_match;
+			*bucket = ent++;
+		}
+	}
+
+	return 0;
+}
+#endif
+
+/**
+ * driver_lookup_compatible() - Find the first driver matching a compatible
+ *
+ * @compat:	The compatible string to search for
+ * @of_idp:	Returns the match that was found
+ * @return the driver, or NULL if none matches
+ */
+static struct driver *driver_lookup_compatible(const char *compat,
+					       const struct udevice_id **of_idp)
+{
+	struct driver *driver = ll_entry_start(struct driver, driver);
+	const int n_ents = ll_entry_count(struct driver, driver);
+	struct driver *entry;
+
+#if CONFIG_IS_ENABLED(DM_OF_INDEX)
+	/* The table lives in BSS, so only use it after relocation */
+	if ((gd->flags & GD_FLG_RELOC) &&
+	    (driver_compat_tbl || !driver_compat_index_build())) {
+		struct driver_compat *ent;
+
+		ent = driver_compat_tbl[driver_compat_hash(compat)];
+		for (; ent; ent = ent->next) {
+			if (!strcmp(ent->compat, compat)) {
+				*of_idp = ent->id;
+				return ent->drv;
+			}
+		}
+
+		return NULL;
+	}
+#endif
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		if (!driver_check_compatible(entry->of_match, of_idp, compat))
+			return entry;
+	}
+
+	return NULL;
+}
+
+int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp)
+{
 	const struct udevice_id *id;
 	struct driver *entry;
 	struct udevice *dev;
@@ -163,13 +278,8 @@ int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp)
 		pr_debug("   - attempt to match compatible string '%s'\n",
 			 compat);
 
-		for (entry = driver; entry != driver + n_ents; entry++) {
-			ret = driver_check_compatible(entry->of_match, &id,
-						      compat);
-			if (!ret)
-				break;
-		}
-		if (entry == driver + n_ents)
+		entry = driver_lookup_compatible(compat, &id);
+		if (!entry)
 			continue;
 
 		pr_debug("   - found match at '%s'\n", entry->name);
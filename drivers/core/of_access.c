@@ -26,6 +26,7 @@
 #include <linux/ctype.h>
 #include <linux/err.h>
 #include <linux/ioport.h>
+#include <malloc.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -44,6 +45,25 @@ static struct device_node *of_stdout;
 /* pointer to options given after the alias (separated by :) or NULL if none */
 static const char *of_stdout_options;
 
+/**
+ * struct of_phandle_index - phandle lookup table of a live tree
+ *
+ * dtc allocates phandles from 1 upwards, so a table indexed directly by
+ * phandle stays small. One is kept for the U-Boot tree and one for the
+ * kernel tree when both are live.
+ *
+ * @root:	Root node of the tree the table belongs to
+ * @nodes:	Node for each phandle, NULL if none
+ * @max:	Largest phandle in the table
+ */
+struct of_phandle_index {
+	const struct device_node *root;
+	struct device_node **nodes;
+	phandle max;
+};
+
+static struct of_phandle_index of_phandle_idx[2];
+
 /**
  * struct alias_prop - Alias property in 'aliases' node
  *
@@ -409,6 +429,70 @@ struct device_node *of_find_compatible_node(struct device_node *from,
 	return np;
 }
 
+int of_phandle_index_build(struct device_node *root)
+{
+#if CONFIG_IS_ENABLED(DM_OF_INDEX)
+	struct of_phandle_index *idx = &of_phandle_idx[0];
+	struct device_node *np;
+	phandle top = 0;
+	int count = 0;
+
+	if (idx->root && idx->root != root)
+		idx = &of_phandle_idx[1];
+	free(idx->nodes);
+	idx->root = NULL;
+	idx->nodes = NULL;
+
+	for (np = root; np; np = of_find_all_nodes(np)) {
+		if (np->phandle) {
+			top = max(top, np->phandle);
+			count++;
+		}
+	}
+	/* Hand-written phandles can be anything; don't waste memory on them */
+	if (!count || top > count * 4 + 64)
+		return 0;
+
+	idx->nodes = calloc(top + 1, sizeof(*idx->nodes));
+	if (!idx->nodes)
+		return -ENOMEM;
+	for (np = root; np; np = of_find_all_nodes(np)) {
+		if (np->phandle && !idx->nodes[np->phandle])
+			idx->nodes[np->phandle] = np;
+	}
+	idx->root = root;
+	idx->max = top;
+	debug("%s: %d phandles, max %u\n", __func__, count, top);
+#endif
+
+	return 0;
+}
+
+static struct device_node *of_find_node_in_tree(struct device_node *root,
+						phandle handle)
+{
+	struct device_node *np;
+	int i;
+
+	for (i = 0; CONFIG_IS_ENABLED(DM_OF_INDEX) &&
+		    i < ARRAY_SIZE(of_phandle_idx); i++) {
+		struct of_phandle_index *idx = &of_phandle_idx[i];
+
+		if (idx->root != root || handle > idx->max)
+			continue;
+		np = idx->nodes[handle];
+		if (np && np->phandle == handle)
+			return np;
+		break;
+	}
+
+	for (np = root; np; np = of_find_all_nodes(np))
+		if (np->phandle == handle)
+			break;
+
+	return np;
+}
+
 struct device_node *of_find_node_by_phandle(phandle handle)
 {
 	struct device_node *np;
@@ -416,18 +500,12 @@ struct device_node *of_find_node_by_phandle(phandle handle)
 	if (!handle)
 		return NULL;
 
-	for_each_of_allnodes(np)
-		if (np->phandle == handle)
-			break;
+	np = of_find_node_in_tree(gd->of_root, handle);
 
 #ifdef CONFIG_USING_KERNEL_DTB_V2
 	/* If not find in kernel fdt, traverse u-boot fdt */
-	if (!np) {
-		for (np = gd->of_root_f; np; np = of_find_all_nodes(np)) {
-			if (np->phandle == handle)
-				break;
-		}
-	}
+	if (!np)
+		np = of_find_node_in_tree(gd->of_root_f, handle);
 #endif
 	(void)of_node_get(np);
 
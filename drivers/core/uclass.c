@@ -503,6 +503,56 @@ int uclass_get_device_by_phandle(enum uclass_id id, struct udevice *parent,
 }
 #endif
 
+int uclass_probe_all(enum uclass_id id)
+{
+	struct udevice *dev, *last = NULL;
+	struct uclass *uc;
+	int pending;
+	int err = 0;
+	int ret;
+
+	ret = uclass_get(id, &uc);
+	if (ret)
+		return ret;
+
+	/* Start everything, then step what is pending until it is done */
+	uclass_foreach_dev(dev, uc) {
+		last = dev;
+		ret = device_probe_start(dev);
+		if (ret && !err)
+			err = ret;
+	}
+	if (!last)
+		return 0;
+
+	do {
+		pending = 0;
+		uclass_foreach_dev(dev, uc) {
+			if (!(dev->flags & DM_FLAG_PROBE_PENDING))
+				continue;
+			ret = device_probe_step(dev);
+			if (ret == -EAGAIN)
+				pending++;
+			else if (ret && !err)
+				err = ret;
+		}
+	} while (pending);
+
+	/*
+	 * Probing may have bound more devices, e.g. PCI bridges. Those are
+	 * added at the end of the list; devices that failed above are not
+	 * tried again, that would only repeat their wait for nothing.
+	 */
+	dev = last;
+	list_for_each_entry_continue(dev, &uc->dev_head, uclass_node) {
+		ret = device_probe(dev);
+		if (ret && !err)
+			err = ret;
+	}
+
+	return err;
+}
+
 int uclass_first_device(enum uclass_id id, struct udevice **devp)
 {
 	struct udevice *dev;
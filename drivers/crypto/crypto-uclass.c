@@ -298,6 +298,103 @@ int crypto_ae(struct udevice *dev, cipher_context *ctx,
 	return ops->cipher_ae(dev, ctx, in, len, aad, aad_len, out, tag);
 }
 
+#if CONFIG_IS_ENABLED(CRYPTO_DIGEST_CACHE)
+#define DIGEST_CACHE_SALT_MAX	64
+#define DIGEST_CACHE_DIGEST_MAX	64
+
+struct digest_cache_entry {
+	struct blk_desc	*dev;
+	lbaint_t	start;
+	u64		len;
+	u32		algo;
+	u32		write_gen;
+	u32		salt_len;
+	u8		salt[DIGEST_CACHE_SALT_MAX];
+	u8		digest[DIGEST_CACHE_DIGEST_MAX];
+};
+
+static struct digest_cache_entry digest_cache[CONFIG_CRYPTO_DIGEST_CACHE_ENTRIES];
+static u32 digest_cache_next;
+
+static struct digest_cache_entry *
+digest_cache_find(const struct crypto_digest_key *key)
+{
+	struct digest_cache_entry *e;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(digest_cache); i++) {
+		e = &digest_cache[i];
+		if (e->dev == key->dev && e->start == key->start &&
+		    e->len == key->len && e->algo == key->algo &&
+		    e->salt_len == key->salt_len &&
+		    (!key->salt_len || !memcmp(e->salt, key->salt, key->salt_len)))
+			return e;
+	}
+
+	return NULL;
+}
+
+static bool digest_cache_usable(const struct crypto_digest_key *key)
+{
+	return key->dev && key->salt_len <= DIGEST_CACHE_SALT_MAX &&
+	       (key->salt || !key->salt_len) &&
+	       crypto_algo_nbits(key->algo) &&
+	       BITS2BYTE(crypto_algo_nbits(key->algo)) <=
+	       DIGEST_CACHE_DIGEST_MAX;
+}
+
+void crypto_digest_cache_invalidate(struct blk_desc *dev)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(digest_cache); i++) {
+		if (digest_cache[i].dev == dev)
+			digest_cache[i].dev = NULL;
+	}
+}
+
+int crypto_digest_cache_get(const struct crypto_digest_key *key, u8 *digest)
+{
+	struct digest_cache_entry *e;
+
+	if (!digest_cache_usable(key))
+		return -ENOENT;
+
+	e = digest_cache_find(key);
+	if (!e || e->write_gen != key->dev->write_gen)
+		return -ENOENT;
+
+	memcpy(digest, e->digest, BITS2BYTE(crypto_algo_nbits(key->algo)));
+
+	return 0;
+}
+
+void crypto_digest_cache_put(const struct crypto_digest_key *key,
+			     const u8 *digest)
+{
+	struct digest_cache_entry *e;
+
+	if (!digest_cache_usable(key))
+		return;
+
+	e = digest_cache_find(key);
+	if (!e) {
+		e = &digest_cache[digest_cache_next];
+		digest_cache_next = (digest_cache_next + 1) %
+				    ARRAY_SIZE(digest_cache);
+	}
+
+	e->dev = key->dev;
+	e->start = key->start;
+	e->len = key->len;
+	e->algo = key->algo;
+	e->write_gen = key->dev->write_gen;
+	e->salt_len = key->salt_len;
+	memcpy(e->salt, key->salt, key->salt_len);
+	memcpy(e->digest, digest, BITS2BYTE(crypto_algo_nbits(key->algo)));
+}
+#endif
+
 UCLASS_DRIVER(crypto) = {
 	.id	= UCLASS_CRYPTO,
 	.name	= "crypto",
@@ -0,0 +1,239 @@
+/*
+ * eMMC Command Queue Host Controller Interface (CQHCI)
+ *
+ * The engine fetches task descriptors from memory and issues CMD44/45
+ * and CMD46/47 itself, so a batch of reads or writes costs one doorbell
+ * write instead of a CMD18/CMD25 plus CMD12 round trip per transfer, and
+ * the card is free to reorder the tasks it has queued.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <cqhci.h>
+#include <errno.h>
+#include <malloc.h>
+#include <memalign.h>
+#include <mmc.h>
+
+/* Time a batch may go without any task completing */
+#define CQHCI_TIMEOUT_MS	3000
+#define CQHCI_HALT_TIMEOUT_MS	100
+
+#define CQHCI_ACT_TASK		0x5
+#define CQHCI_ACT_TRAN		0x4
+#define CQHCI_ACT_LINK		0x6
+
+/* Link and transfer descriptors only carry the low 32 address bits */
+static bool cqhci_dma32(const void *buf, ulong len)
+{
+	return (u64)(ulong)buf + len <= (1ULL << 32);
+}
+
+int cqhci_init(struct cqhci_host *cq, struct mmc *mmc, void __iomem *mmio)
+{
+	cq->mmio = mmio;
+	cq->mmc = mmc;
+	cq->boundary = 0;
+	cq->enabled = false;
+
+	/* A task and a link descriptor per slot */
+	cq->desc = memalign(1024, CQHCI_NUM_SLOTS * 2 * sizeof(u64));
+	if (!cq->desc)
+		return -ENOMEM;
+
+	cq->trans = memalign(ARCH_DMA_MINALIGN, CQHCI_NUM_SLOTS *
+			     CQHCI_MAX_SEGS * sizeof(u64));
+	if (!cq->trans || !cqhci_dma32(cq->trans, CQHCI_NUM_SLOTS *
+				       CQHCI_MAX_SEGS * sizeof(u64))) {
+		free(cq->trans);
+		free(cq->desc);
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static int cqhci_halt(struct cqhci_host *cq)
+{
+	ulong start;
+
+	if (cqhci_readl(cq, CQHCI_CTL) & CQHCI_HALT)
+		return 0;
+
+	cqhci_writel(cq, CQHCI_HALT, CQHCI_CTL);
+	start = get_timer(0);
+	while (!(cqhci_readl(cq, CQHCI_CTL) & CQHCI_HALT)) {
+		if (get_timer(start) > CQHCI_HALT_TIMEOUT_MS)
+			return -ETIMEDOUT;
+	}
+
+	return 0;
+}
+
+int cqhci_enable(struct cqhci_host *cq)
+{
+	ulong desc = (ulong)cq->desc;
+	u32 cfg;
+
+	cfg = cqhci_readl(cq, CQHCI_CFG);
+	if (cfg & CQHCI_ENABLE) {
+		cfg &= ~CQHCI_ENABLE;
+		cqhci_writel(cq, cfg, CQHCI_CFG);
+	}
+
+	/* 64-bit task descriptors, no direct commands */
+	cfg &= ~(CQHCI_DCMD | CQHCI_TASK_DESC_SZ);
+	cqhci_writel(cq, cfg, CQHCI_CFG);
+
+	cqhci_writel(cq, lower_32_bits(desc), CQHCI_TDLBA);
+	cqhci_writel(cq, upper_32_bits(desc), CQHCI_TDLBAU);
+
+	/* The engine polls the card with CMD13, which needs the RCA */
+	cqhci_writel(cq, cq->mmc->rca, CQHCI_SSC2);
+
+	/* Report status in CQHCI_IS but do not raise interrupts */
+	cqhci_writel(cq, CQHCI_IS_HAC | CQHCI_IS_TCC | CQHCI_IS_TCL |
+		     CQHCI_IS_ERR_MASK, CQHCI_ISTE);
+	cqhci_writel(cq, 0, CQHCI_ISGE);
+	cqhci_writel(cq, cqhci_readl(cq, CQHCI_IS), CQHCI_IS);
+
+	cqhci_writel(cq, cfg | CQHCI_ENABLE, CQHCI_CFG);
+
+	if (cqhci_readl(cq, CQHCI_CTL) & CQHCI_HALT)
+		cqhci_writel(cq, 0, CQHCI_CTL);
+
+	cq->enabled = true;
+
+	return 0;
+}
+
+int cqhci_disable(struct cqhci_host *cq)
+{
+	int ret;
+
+	if (!cq->enabled)
+		return 0;
+
+	ret = cqhci_halt(cq);
+	cqhci_writel(cq, cqhci_readl(cq, CQHCI_CFG) & ~CQHCI_ENABLE,
+		     CQHCI_CFG);
+	cq->enabled = false;
+
+	return ret;
+}
+
+/* Fill in the task, link and transfer descriptors of slot @tag */
+static int cqhci_prep_task(struct cqhci_host *cq, int tag,
+			   struct mmc_cqe_task *task)
+{
+	u64 *trans = &cq->trans[tag * CQHCI_MAX_SEGS];
+	ulong addr = (ulong)task->buf;
+	ulong len = task->blocks * MMC_MAX_BLOCK_LEN;
+	int i = 0;
+
+	while (len) {
+		ulong seg = min_t(ulong, len, CQHCI_MAX_SEG_SIZE);
+
+		/* Stop short of the boundary, the next descriptor crosses it */
+		if (cq->boundary)
+			seg = min(seg, cq->boundary -
+				  (addr & (cq->boundary - 1)));
+		if (i == CQHCI_MAX_SEGS)
+			return -E2BIG;
+
+		len -= seg;
+		trans[i++] = CQHCI_VALID(1) | CQHCI_END(!len) |
+			     CQHCI_ACT(CQHCI_ACT_TRAN) |
+			     CQHCI_DAT_LENGTH(seg) | CQHCI_DAT_ADDR_LO(addr);
+		addr += seg;
+	}
+
+	cq->desc[tag * 2] = CQHCI_VALID(1) | CQHCI_END(1) | CQHCI_INT(1) |
+			    CQHCI_ACT(CQHCI_ACT_TASK) |
+			    CQHCI_DATA_DIR(!task->write) |
+			    CQHCI_BLK_COUNT(task->blocks) |
+			    CQHCI_BLK_ADDR(task->blk);
+	cq->desc[tag * 2 + 1] = CQHCI_VALID(1) | CQHCI_ACT(CQHCI_ACT_LINK) |
+				CQHCI_DAT_ADDR_LO((ulong)trans);
+
+	/* Write back outgoing data, and drop dirty lines over incoming data */
+	flush_dcache_range((ulong)task->buf, (ulong)task->buf +
+			   task->blocks * MMC_MAX_BLOCK_LEN);
+
+	return 0;
+}
+
+int cqhci_request(struct cqhci_host *cq, struct mmc_cqe_task *tasks,
+		  int count)
+{
+	u32 mask, done = 0, tcn, is;
+	ulong start;
+	int i, ret = 0;
+
+	if (!cq->enabled)
+		return -EINVAL;
+	if (count > CQHCI_NUM_SLOTS)
+		return -E2BIG;
+
+	for (i = 0; i < count; i++) {
+		if (!cqhci_dma32(tasks[i].buf,
+				 tasks[i].blocks * MMC_MAX_BLOCK_LEN))
+			return -EINVAL;
+		ret = cqhci_prep_task(cq, i, &tasks[i]);
+		if (ret)
+			return ret;
+	}
+	flush_dcache_range((ulong)cq->trans,
+			   ALIGN((ulong)&cq->trans[count * CQHCI_MAX_SEGS],
+				 ARCH_DMA_MINALIGN));
+	flush_dcache_range((ulong)cq->desc,
+			   (ulong)&cq->desc[CQHCI_NUM_SLOTS * 2]);
+
+	mask = count == 32 ? ~0U : BIT(count) - 1;
+	cqhci_writel(cq, cqhci_readl(cq, CQHCI_IS), CQHCI_IS);
+	cqhci_writel(cq, cqhci_readl(cq, CQHCI_TCN), CQHCI_TCN);
+	cqhci_writel(cq, mask, CQHCI_TDBR);
+
+	start = get_timer(0);
+	while (done != mask) {
+		is = cqhci_readl(cq, CQHCI_IS);
+		if (is & CQHCI_IS_ERR_MASK) {
+			printf("%s: task error, IS %x TERRI %x\n", __func__, is,
+			       cqhci_readl(cq, CQHCI_TERRI));
+			ret = -EIO;
+			break;
+		}
+
+		tcn = cqhci_readl(cq, CQHCI_TCN) & mask;
+		if (tcn) {
+			/* Acknowledge everything that completed at once */
+			cqhci_writel(cq, tcn, CQHCI_TCN);
+			done |= tcn;
+			start = get_timer(0);
+		} else if (get_timer(start) > CQHCI_TIMEOUT_MS) {
+			printf("%s: timeout, %x of %x done\n", __func__, done,
+			       mask);
+			ret = -ETIMEDOUT;
+			break;
+		}
+	}
+	cqhci_writel(cq, cqhci_readl(cq, CQHCI_IS), CQHCI_IS);
+
+	if (ret) {
+		/* Drop whatever is still queued so the bus can be reused */
+		cqhci_halt(cq);
+		cqhci_writel(cq, CQHCI_CLEAR_ALL_TASKS, CQHCI_CTL);
+		return ret;
+	}
+
+	for (i = 0; i < count; i++) {
+		if (tasks[i].write)
+			continue;
+		invalidate_dcache_range((ulong)tasks[i].buf,
+					(ulong)tasks[i].buf +
+					tasks[i].blocks * MMC_MAX_BLOCK_LEN);
+	}
+
+	return 0;
+}
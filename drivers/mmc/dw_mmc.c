@@ -739,6 +739,30 @@ static int dwmci_execute_tuning(struct mmc *mmc, u32 opcode)
 	return host->execute_tuning(host, opcode);
 }
 
+#if defined(CONFIG_DM_MMC) && CONFIG_IS_ENABLED(MMC_TUNING_CACHE)
+static int dwmci_get_tuning(struct udevice *dev, u32 *phase)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	struct dwmci_host *host = (struct dwmci_host *)mmc->priv;
+
+	if (!host->get_tuning)
+		return -ENOSYS;
+
+	return host->get_tuning(host, phase);
+}
+
+static int dwmci_set_tuning(struct udevice *dev, u32 phase)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	struct dwmci_host *host = (struct dwmci_host *)mmc->priv;
+
+	if (!host->set_tuning)
+		return -ENOSYS;
+
+	return host->set_tuning(host, phase);
+}
+#endif
+
 #ifdef CONFIG_DM_MMC
 static int dwmci_set_ios(struct udevice *dev)
 {
@@ -895,6 +919,10 @@ const struct dm_mmc_ops dm_dwmci_ops = {
 	.set_ios	= dwmci_set_ios,
 	.get_cd         = dwmci_get_cd,
 	.execute_tuning	= dwmci_execute_tuning,
+#if CONFIG_IS_ENABLED(MMC_TUNING_CACHE)
+	.get_tuning	= dwmci_get_tuning,
+	.set_tuning	= dwmci_set_tuning,
+#endif
 };
 
 #else
@@ -75,6 +75,11 @@ int dm_mmc_send_cmd_prepare(struct udevice *dev, struct mmc_cmd *cmd,
 
 int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd, struct mmc_data *data)
 {
+#if CONFIG_IS_ENABLED(MMC_CQE)
+	/* The card rejects legacy commands while it is in queue mode */
+	if (mmc->cmdq_en)
+		mmc_cmdq_disable(mmc, false);
+#endif
 	return dm_mmc_send_cmd(mmc->dev, cmd, data);
 }
 
@@ -157,6 +162,65 @@ int mmc_set_enhanced_strobe(struct mmc *mmc)
 {
 	return dm_mmc_set_enhanced_strobe(mmc->dev);
 }
+
+#if CONFIG_IS_ENABLED(MMC_CQE)
+int mmc_cmdq_enable(struct mmc *mmc)
+{
+	struct dm_mmc_ops *ops = mmc_get_ops(mmc->dev);
+	int ret;
+
+	if (mmc->cmdq_en)
+		return 0;
+	if (!mmc->cmdq_depth || !ops->cqe_enable)
+		return -ENOSYS;
+
+	ret = mmc_switch(mmc, EXT_CSD_CMD_SET_NORMAL, EXT_CSD_CMDQ_MODE_EN, 1);
+	if (ret)
+		return ret;
+
+	ret = ops->cqe_enable(mmc->dev);
+	if (ret) {
+		mmc_switch(mmc, EXT_CSD_CMD_SET_NORMAL, EXT_CSD_CMDQ_MODE_EN, 0);
+		return ret;
+	}
+	mmc->cmdq_en = true;
+
+	return 0;
+}
+
+int mmc_cmdq_disable(struct mmc *mmc, bool discard)
+{
+	struct dm_mmc_ops *ops = mmc_get_ops(mmc->dev);
+	struct mmc_cmd cmd;
+
+	if (!mmc->cmdq_en)
+		return 0;
+
+	/* Clear the flag first, the switch goes through mmc_send_cmd() */
+	mmc->cmdq_en = false;
+	ops->cqe_disable(mmc->dev);
+
+	/* The card refuses CMD6 while it still holds queued tasks */
+	if (discard) {
+		cmd.cmdidx = MMC_CMD_CMDQ_TASK_MGMT;
+		cmd.resp_type = MMC_RSP_R1b;
+		cmd.cmdarg = MMC_CMDQ_DISCARD_QUEUE;
+		mmc_send_cmd(mmc, &cmd, NULL);
+	}
+
+	return mmc_switch(mmc, EXT_CSD_CMD_SET_NORMAL, EXT_CSD_CMDQ_MODE_EN, 0);
+}
+
+int mmc_cqe_request(struct mmc *mmc, struct mmc_cqe_task *tasks, int count)
+{
+	struct dm_mmc_ops *ops = mmc_get_ops(mmc->dev);
+
+	if (!mmc->cmdq_en || !ops->cqe_request)
+		return -ENOSYS;
+
+	return ops->cqe_request(mmc->dev, tasks, count);
+}
+#endif
 struct mmc *mmc_get_mmc_dev(struct udevice *dev)
 {
 	struct mmc_uclass_priv *upriv;
@@ -351,6 +415,9 @@ static int mmc_blk_probe(struct udevice *dev)
 
 static const struct blk_ops mmc_blk_ops = {
 	.read	= mmc_bread,
+#if CONFIG_IS_ENABLED(MMC_CQE)
+	.read_segs	= mmc_bread_segs,
+#endif
 #if CONFIG_IS_ENABLED(MMC_WRITE)
 	.write	= mmc_bwrite,
 	.erase	= mmc_berase,
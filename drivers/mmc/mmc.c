@@ -365,6 +365,84 @@ re_init_retry:
 }
 #endif
 
+#if CONFIG_IS_ENABLED(MMC_CQE)
+bool mmc_cqe_can_transfer(struct mmc *mmc, struct blk_seg *segs, int count)
+{
+	int i;
+
+	/* Tasks address 512-byte blocks through 32-bit ADMA2 descriptors */
+	if (!mmc->cmdq_depth || !mmc->high_capacity ||
+	    mmc->read_bl_len != MMC_MAX_BLOCK_LEN ||
+	    mmc->write_bl_len != MMC_MAX_BLOCK_LEN)
+		return false;
+
+	for (i = 0; i < count; i++) {
+		ulong buf = (ulong)segs[i].buffer;
+		u64 end = (u64)buf + (u64)segs[i].blkcnt * MMC_MAX_BLOCK_LEN;
+
+		if (!IS_ALIGNED(buf, ARCH_DMA_MINALIGN) || end > (1ULL << 32))
+			return false;
+	}
+
+	return true;
+}
+
+int mmc_cqe_transfer(struct mmc *mmc, struct blk_seg *segs, int count,
+		     bool write)
+{
+	struct mmc_cqe_task tasks[MMC_CQE_MAX_DEPTH];
+	int i, n = 0, ret;
+
+	/* Descriptors hold 32-bit addresses, leave such runs to the caller */
+	if (!mmc_cqe_can_transfer(mmc, segs, count))
+		return -EINVAL;
+
+	ret = mmc_cmdq_enable(mmc);
+	if (ret)
+		goto err;
+
+	for (i = 0; i < count; i++) {
+		lbaint_t start = segs[i].start;
+		lbaint_t left = segs[i].blkcnt;
+		char *buf = segs[i].buffer;
+
+		while (left) {
+			u32 cur = min_t(lbaint_t, left, MMC_CQE_MAX_BLOCKS);
+
+			tasks[n].blk = start;
+			tasks[n].blocks = cur;
+			tasks[n].buf = buf;
+			tasks[n].write = write;
+			if (++n == mmc->cmdq_depth) {
+				ret = mmc_cqe_request(mmc, tasks, n);
+				if (ret)
+					goto err;
+				n = 0;
+			}
+			start += cur;
+			left -= cur;
+			buf += cur * MMC_MAX_BLOCK_LEN;
+		}
+	}
+
+	if (n) {
+		ret = mmc_cqe_request(mmc, tasks, n);
+		if (ret)
+			goto err;
+	}
+
+	return 0;
+
+err:
+	/* Stick to legacy commands until the card is initialised again */
+	printf("MMC: command queue failed (%d), disabling it\n", ret);
+	mmc_cmdq_disable(mmc, true);
+	mmc->cmdq_depth = 0;
+
+	return ret;
+}
+#endif
+
 #if CONFIG_IS_ENABLED(BLK)
 ulong mmc_bread(struct udevice *dev, lbaint_t start, lbaint_t blkcnt, void *dst)
 #else
@@ -410,6 +488,16 @@ ulong mmc_bread(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 		return 0;
 	}
 
+#if CONFIG_IS_ENABLED(MMC_CQE)
+	if (mmc->cmdq_depth) {
+		struct blk_seg seg = { start, blkcnt, dst };
+
+		if (mmc_cqe_can_transfer(mmc, &seg, 1) &&
+		    !mmc_cqe_transfer(mmc, &seg, 1, false))
+			return blkcnt;
+	}
+#endif
+
 	if (mmc_set_blocklen(mmc, mmc->read_bl_len)) {
 		debug("%s: Failed to set blocklen\n", __func__);
 		return 0;
@@ -449,6 +537,38 @@ re_init_retry:
 	return blkcnt;
 }
 
+#if CONFIG_IS_ENABLED(MMC_CQE)
+int mmc_bread_segs(struct udevice *dev, struct blk_seg *segs, int count)
+{
+	struct blk_desc *block_dev = dev_get_uclass_platdata(dev);
+	struct mmc *mmc = find_mmc_device(block_dev->devnum);
+	int i;
+
+	if (!mmc)
+		return -ENODEV;
+
+	if (blk_dselect_hwpart(block_dev, block_dev->hwpart) < 0)
+		return -EIO;
+
+	for (i = 0; i < count; i++) {
+		if (segs[i].start + segs[i].blkcnt > block_dev->lba)
+			return -EINVAL;
+	}
+
+	if (mmc_cqe_can_transfer(mmc, segs, count) &&
+	    !mmc_cqe_transfer(mmc, segs, count, false))
+		return 0;
+
+	for (i = 0; i < count; i++) {
+		if (mmc_bread(dev, segs[i].start, segs[i].blkcnt,
+			      segs[i].buffer) != segs[i].blkcnt)
+			return -EIO;
+	}
+
+	return 0;
+}
+#endif
+
 void mmc_set_clock(struct mmc *mmc, uint clock)
 {
 	if (clock > mmc->cfg->f_max)
@@ -929,7 +1049,20 @@ static int mmc_execute_tuning(struct mmc *mmc)
 		return mmc->cfg->ops->execute_tuning(mmc, opcode);
 #else
 	if (ops->execute_tuning) {
+#if CONFIG_IS_ENABLED(MMC_TUNING_CACHE)
+		int err;
+
+		if (!mmc_tuning_restore(mmc))
+			return 0;
+
+		err = ops->execute_tuning(mmc->dev, opcode);
+		if (!err)
+			mmc_tuning_record(mmc);
+
+		return err;
+#else
 		return ops->execute_tuning(mmc->dev, opcode);
+#endif
 #endif
 	} else {
 		debug("Tuning feature required for HS200 mode.\n");
@@ -1884,6 +2017,9 @@ static int mmc_startup(struct mmc *mmc)
 	 */
 	mmc->erase_grp_size = 1;
 	mmc->part_config = MMCPART_NOAVAILABLE;
+#if CONFIG_IS_ENABLED(MMC_CQE)
+	mmc->cmdq_depth = 0;
+#endif
 	if (!IS_SD(mmc) && (mmc->version >= MMC_VERSION_4)) {
 		/* select high speed to reduce initialization time */
 		mmc_select_hs(mmc);
@@ -1950,6 +2086,12 @@ static int mmc_startup(struct mmc *mmc)
 			mmc->part_attr = ext_csd[EXT_CSD_PARTITIONS_ATTRIBUTE];
 		if (ext_csd[EXT_CSD_SEC_FEATURE_SUPPORT] & EXT_CSD_SEC_GB_CL_EN)
 			mmc->esr.mmc_can_trim = 1;
+#if CONFIG_IS_ENABLED(MMC_CQE)
+		if ((mmc->cfg->host_caps & MMC_MODE_CQE) &&
+		    mmc->version >= MMC_VERSION_5_1 &&
+		    (ext_csd[EXT_CSD_CMDQ_SUPPORT] & 0x1))
+			mmc->cmdq_depth = (ext_csd[EXT_CSD_CMDQ_DEPTH] & 0x1f) + 1;
+#endif
 
 		mmc->capacity_boot = ext_csd[EXT_CSD_BOOT_MULT] << 17;
 
@@ -2321,6 +2463,11 @@ static int mmc_complete_init(struct mmc *mmc)
 		mmc->has_init = 0;
 	else
 		mmc->has_init = 1;
+#if CONFIG_IS_ENABLED(MMC_TUNING_CACHE)
+	/* Only now may the results be written, possibly to this card */
+	if (!err)
+		mmc_tuning_flush();
+#endif
 	return err;
 }
 
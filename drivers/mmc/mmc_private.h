@@ -20,6 +20,98 @@ int mmc_send_cmd_prepare(struct mmc *mmc, struct mmc_cmd *cmd,
 #endif
 extern int mmc_send_status(struct mmc *mmc, int timeout);
 extern int mmc_set_blocklen(struct mmc *mmc, int len);
+
+#if CONFIG_IS_ENABLED(MMC_CQE)
+/**
+ * mmc_cmdq_enable() - switch the card and host to command queue mode
+ *
+ * The card stays in queue mode until mmc_cmdq_disable() is called, which
+ * mmc_send_cmd() does by itself before sending any legacy command.
+ *
+ * @mmc:	MMC device
+ * @return 0 if OK, -ENOSYS if the card or host cannot queue, -ve on error
+ */
+int mmc_cmdq_enable(struct mmc *mmc);
+
+/**
+ * mmc_cmdq_disable() - leave command queue mode
+ *
+ * @mmc:	MMC device
+ * @discard:	true to have the card drop its queued tasks first
+ * @return 0 if OK, -ve on error
+ */
+int mmc_cmdq_disable(struct mmc *mmc, bool discard);
+
+/**
+ * mmc_cqe_request() - run a batch of queued tasks
+ *
+ * @mmc:	MMC device, in command queue mode
+ * @tasks:	Tasks to run
+ * @count:	Number of tasks, at most mmc->cmdq_depth
+ * @return 0 if all tasks completed, -ve on error
+ */
+int mmc_cqe_request(struct mmc *mmc, struct mmc_cqe_task *tasks, int count);
+
+/**
+ * mmc_cqe_can_transfer() - check whether the command queue can be used
+ *
+ * @mmc:	MMC device
+ * @segs:	Runs of blocks to transfer
+ * @count:	Number of runs
+ * @return true if the card queues tasks and every buffer is DMA-able
+ */
+bool mmc_cqe_can_transfer(struct mmc *mmc, struct blk_seg *segs, int count);
+
+/**
+ * mmc_cqe_transfer() - read or write runs of blocks as queued tasks
+ *
+ * Runs are split into tasks of at most MMC_CQE_MAX_BLOCKS and issued in
+ * batches of up to the card's queue depth. On failure the card leaves
+ * queue mode for good and the caller should retry with legacy commands.
+ * Runs that mmc_cqe_can_transfer() rejects are refused with -EINVAL and
+ * the queue stays usable.
+ *
+ * @mmc:	MMC device
+ * @segs:	Runs of blocks, checked with mmc_cqe_can_transfer()
+ * @count:	Number of runs
+ * @write:	true to write the runs to the card
+ * @return 0 if OK, -ve on error
+ */
+int mmc_cqe_transfer(struct mmc *mmc, struct blk_seg *segs, int count,
+		     bool write);
+
+int mmc_bread_segs(struct udevice *dev, struct blk_seg *segs, int count);
+#endif
+
+#if CONFIG_IS_ENABLED(MMC_TUNING_CACHE)
+/**
+ * mmc_tuning_restore() - apply a cached tuning result
+ *
+ * Looks up the card, host, timing and clock in the tuning cache, applies
+ * the result and checks it with one data read. A result that fails the
+ * check is dropped from the cache.
+ *
+ * @mmc:	MMC device, switched to the timing to tune
+ * @return 0 if a result was applied and checked, -ve if the card must
+ * be tuned
+ */
+int mmc_tuning_restore(struct mmc *mmc);
+
+/**
+ * mmc_tuning_record() - add the result of a successful tuning to the cache
+ *
+ * @mmc:	MMC device that was just tuned
+ */
+void mmc_tuning_record(struct mmc *mmc);
+
+/**
+ * mmc_tuning_flush() - hand a changed tuning cache to the board
+ *
+ * Called once a card finished initialising, as mmc_tuning_save() may
+ * write to that very card.
+ */
+void mmc_tuning_flush(void);
+#endif
 #ifdef CONFIG_FSL_ESDHC_ADAPTER_IDENT
 void mmc_adapter_card_type_ident(void);
 #endif
@@ -0,0 +1,159 @@
+/*
+ * Cache of validated tuning results
+ *
+ * Tuning sweeps the sample point with up to a few dozen tuning blocks.
+ * The outcome only depends on the card, the host, the timing and the
+ * clock, so it is kept here, handed on by the board to later boot stages
+ * and boots, and applied again with a single tuning block as a check.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <mmc.h>
+#include "mmc_private.h"
+
+static struct mmc_tuning_rec tuning_recs[MMC_TUNING_RECS];
+/* Number of records, -1 until the board had a chance to load them */
+static int tuning_count = -1;
+/* Set when the records changed since they were last handed to the board */
+static bool tuning_dirty;
+
+__weak int mmc_tuning_load(struct mmc_tuning_rec *recs, int max)
+{
+	return 0;
+}
+
+__weak void mmc_tuning_save(const struct mmc_tuning_rec *recs, int count)
+{
+}
+
+static void mmc_tuning_init(void)
+{
+	if (tuning_count >= 0)
+		return;
+
+	tuning_count = mmc_tuning_load(tuning_recs, MMC_TUNING_RECS);
+	if (tuning_count < 0 || tuning_count > MMC_TUNING_RECS)
+		tuning_count = 0;
+}
+
+static void mmc_tuning_key(struct mmc *mmc, struct mmc_tuning_rec *key)
+{
+	memcpy(key->cid, mmc->cid, sizeof(key->cid));
+#if !CONFIG_IS_ENABLED(OF_PLATDATA)
+	key->host = (u32)dev_read_addr(mmc->dev);
+#else
+	key->host = 0;
+#endif
+	key->clock = mmc->clock;
+	key->timing = mmc->timing;
+	key->phase = 0;
+}
+
+static struct mmc_tuning_rec *mmc_tuning_find(const struct mmc_tuning_rec *key)
+{
+	struct mmc_tuning_rec *rec;
+	int i;
+
+	for (i = 0; i < tuning_count; i++) {
+		rec = &tuning_recs[i];
+		if (!memcmp(rec->cid, key->cid, sizeof(rec->cid)) &&
+		    rec->host == key->host && rec->clock == key->clock &&
+		    rec->timing == key->timing)
+			return rec;
+	}
+
+	return NULL;
+}
+
+int mmc_tuning_get(const struct mmc_tuning_rec **recs)
+{
+	mmc_tuning_init();
+	*recs = tuning_recs;
+
+	return tuning_count;
+}
+
+void mmc_tuning_merge(const struct mmc_tuning_rec *recs, int count)
+{
+	int i;
+
+	mmc_tuning_init();
+	for (i = 0; i < count && tuning_count < MMC_TUNING_RECS; i++) {
+		if (!mmc_tuning_find(&recs[i]))
+			tuning_recs[tuning_count++] = recs[i];
+	}
+}
+
+int mmc_tuning_restore(struct mmc *mmc)
+{
+	struct dm_mmc_ops *ops = mmc_get_ops(mmc->dev);
+	struct mmc_tuning_rec key, *rec;
+	u32 opcode;
+
+	if (!ops->set_tuning)
+		return -ENOSYS;
+
+	mmc_tuning_init();
+	mmc_tuning_key(mmc, &key);
+	rec = mmc_tuning_find(&key);
+	if (!rec)
+		return -ENOENT;
+
+	if (IS_SD(mmc))
+		opcode = MMC_SEND_TUNING_BLOCK;
+	else
+		opcode = MMC_SEND_TUNING_BLOCK_HS200;
+
+	/* The tuning block is CRC checked and compared with its pattern */
+	if (!ops->set_tuning(mmc->dev, rec->phase) &&
+	    !mmc_send_tuning(mmc, opcode))
+		return 0;
+
+	debug("%s: cached tuning result failed, tuning again\n",
+	      mmc->dev->name);
+	*rec = tuning_recs[--tuning_count];
+	tuning_dirty = true;
+
+	return -EIO;
+}
+
+void mmc_tuning_record(struct mmc *mmc)
+{
+	struct dm_mmc_ops *ops = mmc_get_ops(mmc->dev);
+	struct mmc_tuning_rec key, *rec;
+
+	if (!ops->get_tuning)
+		return;
+
+	mmc_tuning_init();
+	mmc_tuning_key(mmc, &key);
+	if (ops->get_tuning(mmc->dev, &key.phase))
+		return;
+
+	rec = mmc_tuning_find(&key);
+	if (rec) {
+		if (rec->phase == key.phase)
+			return;
+	} else if (tuning_count < MMC_TUNING_RECS) {
+		rec = &tuning_recs[tuning_count++];
+	} else {
+		/* Forget the oldest result */
+		memmove(tuning_recs, tuning_recs + 1,
+			(MMC_TUNING_RECS - 1) * sizeof(*rec));
+		rec = &tuning_recs[MMC_TUNING_RECS - 1];
+	}
+	*rec = key;
+	tuning_dirty = true;
+}
+
+void mmc_tuning_flush(void)
+{
+	if (!tuning_dirty)
+		return;
+
+	tuning_dirty = false;
+	mmc_tuning_save(tuning_recs, tuning_count);
+}
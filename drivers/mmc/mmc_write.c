@@ -240,6 +240,16 @@ ulong mmc_bwrite(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 	if (err < 0)
 		return 0;
 
+#if CONFIG_IS_ENABLED(MMC_CQE)
+	if (mmc->cmdq_depth) {
+		struct blk_seg seg = { start, blkcnt, (void *)src };
+
+		if (mmc_cqe_can_transfer(mmc, &seg, 1) &&
+		    !mmc_cqe_transfer(mmc, &seg, 1, true))
+			return blkcnt;
+	}
+#endif
+
 	if (mmc_set_blocklen(mmc, mmc->write_bl_len))
 		return 0;
 
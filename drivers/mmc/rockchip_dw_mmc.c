@@ -168,6 +168,36 @@ static int rockchip_dwmmc_execute_tuning(struct dwmci_host *host, u32 opcode)
 
 	return ret;
 }
+
+#if CONFIG_IS_ENABLED(MMC_TUNING_CACHE)
+static int rockchip_dwmmc_get_tuning(struct dwmci_host *host, u32 *phase)
+{
+	struct udevice *dev = host->priv;
+	struct rockchip_dwmmc_priv *priv = dev_get_priv(dev);
+	int degrees;
+
+	if (IS_ERR(&priv->sample_clk))
+		return -EIO;
+
+	degrees = clk_get_phase(&priv->sample_clk);
+	if (degrees < 0)
+		return degrees;
+	*phase = degrees;
+
+	return 0;
+}
+
+static int rockchip_dwmmc_set_tuning(struct dwmci_host *host, u32 phase)
+{
+	struct udevice *dev = host->priv;
+	struct rockchip_dwmmc_priv *priv = dev_get_priv(dev);
+
+	if (IS_ERR(&priv->sample_clk))
+		return -EIO;
+
+	return clk_set_phase(&priv->sample_clk, phase);
+}
+#endif
 #else
 static int rockchip_dwmmc_execute_tuning(struct dwmci_host *host, u32 opcode) { return 0; }
 #endif
@@ -211,6 +241,10 @@ static int rockchip_dwmmc_probe(struct udevice *dev)
 	if (ret < 0)
 		debug("MMC: sample clock not found, not support hs200!\n");
 	host->execute_tuning = rockchip_dwmmc_execute_tuning;
+#if !defined(CONFIG_MMC_SIMPLE) && CONFIG_IS_ENABLED(MMC_TUNING_CACHE)
+	host->get_tuning = rockchip_dwmmc_get_tuning;
+	host->set_tuning = rockchip_dwmmc_set_tuning;
+#endif
 #endif
 	host->fifoth_val = MSIZE(DWMCI_MSIZE) |
 		RX_WMARK(priv->fifo_depth / 2 - 1) |
@@ -8,9 +8,11 @@
 
 #include <asm/arch/hardware.h>
 #include <common.h>
+#include <cqhci.h>
 #include <dm.h>
 #include <dt-structs.h>
 #include <linux/libfdt.h>
+#include <linux/sizes.h>
 #include <malloc.h>
 #include <mapmem.h>
 #include <sdhci.h>
@@ -45,6 +47,8 @@ DECLARE_GLOBAL_DATA_PTR;
 /* DWC IP vendor area 1 pointer */
 #define DWCMSHC_P_VENDOR_AREA1		0xe8
 #define DWCMSHC_AREA1_MASK		GENMASK(11, 0)
+#define DWCMSHC_P_VENDOR_AREA2		0xea
+#define DWCMSHC_AREA2_MASK		GENMASK(11, 0)
 /* Rockchip specific Registers */
 #define DWCMSHC_CTRL_HS400		0x7
 #define DWCMSHC_CARD_IS_EMMC		BIT(0)
@@ -53,6 +57,10 @@ DECLARE_GLOBAL_DATA_PTR;
 #define DWCMSHC_HOST_CTRL3		0x508
 #define DWCMSHC_EMMC_CONTROL		0x52c
 #define DWCMSHC_EMMC_ATCTRL		0x540
+#define DWCMSHC_EMMC_AT_EN		BIT(0)
+#define DWCMSHC_EMMC_SW_TUNE_EN		BIT(4)
+#define DWCMSHC_EMMC_ATSTAT		0x544
+#define DWCMSHC_EMMC_CENTER_PH_CODE	GENMASK(7, 0)
 #define DWCMSHC_EMMC_DLL_CTRL		0x800
 #define DWCMSHC_EMMC_DLL_CTRL_RESET	BIT(1)
 #define DWCMSHC_EMMC_DLL_RXCLK		0x804
@@ -114,6 +122,9 @@ struct rockchip_sdhc {
 	void *base;
 	struct rockchip_emmc_phy *phy;
 	struct clk emmc_clk;
+#if CONFIG_IS_ENABLED(MMC_CQHCI)
+	struct cqhci_host cqhci;
+#endif
 };
 
 struct sdhci_data {
@@ -121,10 +132,14 @@ struct sdhci_data {
 	void (*set_ios_post)(struct sdhci_host *host);
 	int (*set_enhanced_strobe)(struct sdhci_host *host);
 	int (*get_phy)(struct udevice *dev);
+	int (*get_tuning)(struct sdhci_host *host, u32 *phase);
+	int (*set_tuning)(struct sdhci_host *host, u32 phase);
+	void (*reset_tuning)(struct sdhci_host *host);
 	u32 flags;
 #define RK_DLL_CMD_OUT		BIT(1)
 #define RK_RXCLK_NO_INVERTER	BIT(2)
 #define RK_TAP_VALUE_SEL	BIT(3)
+#define RK_CQE			BIT(4)
 
 	u8 hs200_tx_tap;
 	u8 hs400_tx_tap;
@@ -453,6 +468,53 @@ static int dwcmshc_sdhci_set_enhanced_strobe(struct sdhci_host *host)
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(MMC_TUNING_CACHE)
+static int dwcmshc_sdhci_get_tuning(struct sdhci_host *host, u32 *phase)
+{
+	*phase = sdhci_readl(host, DWCMSHC_EMMC_ATSTAT) &
+		 DWCMSHC_EMMC_CENTER_PH_CODE;
+
+	return 0;
+}
+
+static int dwcmshc_sdhci_set_tuning(struct sdhci_host *host, u32 phase)
+{
+	u32 extra;
+	u16 ctrl;
+
+	/* Software owns the sample point while SW_TUNE_EN is set */
+	extra = sdhci_readl(host, DWCMSHC_EMMC_ATCTRL);
+	extra &= ~DWCMSHC_EMMC_AT_EN;
+	extra |= DWCMSHC_EMMC_SW_TUNE_EN;
+	sdhci_writel(host, extra, DWCMSHC_EMMC_ATCTRL);
+
+	extra = sdhci_readl(host, DWCMSHC_EMMC_ATSTAT);
+	extra &= ~DWCMSHC_EMMC_CENTER_PH_CODE;
+	extra |= phase & DWCMSHC_EMMC_CENTER_PH_CODE;
+	sdhci_writel(host, extra, DWCMSHC_EMMC_ATSTAT);
+
+	ctrl = sdhci_readw(host, SDHCI_HOST_CONTROL2);
+	ctrl |= SDHCI_CTRL_TUNED_CLK;
+	sdhci_writew(host, ctrl, SDHCI_HOST_CONTROL2);
+
+	return 0;
+}
+
+static void dwcmshc_sdhci_reset_tuning(struct sdhci_host *host)
+{
+	u32 extra;
+	u16 ctrl;
+
+	extra = sdhci_readl(host, DWCMSHC_EMMC_ATCTRL);
+	extra &= ~DWCMSHC_EMMC_SW_TUNE_EN;
+	sdhci_writel(host, extra, DWCMSHC_EMMC_ATCTRL);
+
+	ctrl = sdhci_readw(host, SDHCI_HOST_CONTROL2);
+	ctrl &= ~SDHCI_CTRL_TUNED_CLK;
+	sdhci_writew(host, ctrl, SDHCI_HOST_CONTROL2);
+}
+#endif
+
 static void dwcmshc_sdhci_set_ios_post(struct sdhci_host *host)
 {
 	u16 ctrl;
@@ -508,10 +570,48 @@ static int rockchip_sdhci_set_enhanced_strobe(struct sdhci_host *host)
 	return -ENOTSUPP;
 }
 
+#if CONFIG_IS_ENABLED(MMC_TUNING_CACHE)
+static int rockchip_sdhci_get_tuning(struct sdhci_host *host, u32 *phase)
+{
+	struct rockchip_sdhc *priv = container_of(host, struct rockchip_sdhc, host);
+	struct sdhci_data *data = (struct sdhci_data *)dev_get_driver_data(priv->dev);
+
+	if (data->get_tuning)
+		return data->get_tuning(host, phase);
+
+	return -ENOTSUPP;
+}
+
+static int rockchip_sdhci_set_tuning(struct sdhci_host *host, u32 phase)
+{
+	struct rockchip_sdhc *priv = container_of(host, struct rockchip_sdhc, host);
+	struct sdhci_data *data = (struct sdhci_data *)dev_get_driver_data(priv->dev);
+
+	if (data->set_tuning)
+		return data->set_tuning(host, phase);
+
+	return -ENOTSUPP;
+}
+
+static void rockchip_sdhci_reset_tuning(struct sdhci_host *host)
+{
+	struct rockchip_sdhc *priv = container_of(host, struct rockchip_sdhc, host);
+	struct sdhci_data *data = (struct sdhci_data *)dev_get_driver_data(priv->dev);
+
+	if (data->reset_tuning)
+		data->reset_tuning(host);
+}
+#endif
+
 static struct sdhci_ops rockchip_sdhci_ops = {
 	.set_clock	= rockchip_sdhci_set_clock,
 	.set_ios_post	= rockchip_sdhci_set_ios_post,
 	.set_enhanced_strobe = rockchip_sdhci_set_enhanced_strobe,
+#if CONFIG_IS_ENABLED(MMC_TUNING_CACHE)
+	.get_tuning	= rockchip_sdhci_get_tuning,
+	.set_tuning	= rockchip_sdhci_set_tuning,
+	.reset_tuning	= rockchip_sdhci_reset_tuning,
+#endif
 };
 
 static int rockchip_sdhci_probe(struct udevice *dev)
@@ -575,6 +675,21 @@ static int rockchip_sdhci_probe(struct udevice *dev)
 	if (data->set_enhanced_strobe && dev_read_bool(dev, "mmc-hs400-enhanced-strobe"))
 		host->host_caps |= MMC_MODE_HS400ES;
 
+#if CONFIG_IS_ENABLED(MMC_CQHCI)
+	/* The CQHCI registers sit where vendor area 2 points */
+	if ((data->flags & RK_CQE) && dev_read_bool(dev, "supports-cqe")) {
+		u16 area2 = sdhci_readw(host, DWCMSHC_P_VENDOR_AREA2);
+
+		if (!cqhci_init(&prv->cqhci, &plat->mmc, host->ioaddr +
+				(area2 & DWCMSHC_AREA2_MASK))) {
+			/* DWCMSHC DMA cannot cross a 128 MiB boundary */
+			prv->cqhci.boundary = SZ_128M;
+			host->cqe = &prv->cqhci;
+			host->host_caps |= MMC_MODE_CQE;
+		}
+	}
+#endif
+
 	ret = sdhci_setup_cfg(&plat->cfg, host, 0, EMMC_MIN_FREQ);
 
 	plat->cfg.fixed_drv_type = dev_read_u32_default(dev, "fixed-emmc-driver-type", 0);
@@ -616,7 +731,12 @@ static const struct sdhci_data arasan_data = {
 static const struct sdhci_data rk3568_data = {
 	.emmc_set_clock = dwcmshc_sdhci_emmc_set_clock,
 	.get_phy = dwcmshc_emmc_get_phy,
-	.flags = RK_RXCLK_NO_INVERTER,
+#if CONFIG_IS_ENABLED(MMC_TUNING_CACHE)
+	.get_tuning = dwcmshc_sdhci_get_tuning,
+	.set_tuning = dwcmshc_sdhci_set_tuning,
+	.reset_tuning = dwcmshc_sdhci_reset_tuning,
+#endif
+	.flags = RK_RXCLK_NO_INVERTER | RK_CQE,
 	.hs200_tx_tap = 16,
 	.hs400_tx_tap = 8,
 	.hs400_cmd_tap = 8,
@@ -627,9 +747,14 @@ static const struct sdhci_data rk3568_data = {
 static const struct sdhci_data rk3588_data = {
 	.emmc_set_clock = dwcmshc_sdhci_emmc_set_clock,
 	.get_phy = dwcmshc_emmc_get_phy,
+#if CONFIG_IS_ENABLED(MMC_TUNING_CACHE)
+	.get_tuning = dwcmshc_sdhci_get_tuning,
+	.set_tuning = dwcmshc_sdhci_set_tuning,
+	.reset_tuning = dwcmshc_sdhci_reset_tuning,
+#endif
 	.set_ios_post = dwcmshc_sdhci_set_ios_post,
 	.set_enhanced_strobe = dwcmshc_sdhci_set_enhanced_strobe,
-	.flags = RK_DLL_CMD_OUT,
+	.flags = RK_DLL_CMD_OUT | RK_CQE,
 	.hs200_tx_tap = 16,
 	.hs400_tx_tap = 9,
 	.hs400_cmd_tap = 8,
@@ -640,9 +765,14 @@ static const struct sdhci_data rk3588_data = {
 static const struct sdhci_data rk3528_data = {
 	.emmc_set_clock = dwcmshc_sdhci_emmc_set_clock,
 	.get_phy = dwcmshc_emmc_get_phy,
+#if CONFIG_IS_ENABLED(MMC_TUNING_CACHE)
+	.get_tuning = dwcmshc_sdhci_get_tuning,
+	.set_tuning = dwcmshc_sdhci_set_tuning,
+	.reset_tuning = dwcmshc_sdhci_reset_tuning,
+#endif
 	.set_ios_post = dwcmshc_sdhci_set_ios_post,
 	.set_enhanced_strobe = dwcmshc_sdhci_set_enhanced_strobe,
-	.flags = RK_DLL_CMD_OUT | RK_TAP_VALUE_SEL,
+	.flags = RK_DLL_CMD_OUT | RK_TAP_VALUE_SEL | RK_CQE,
 	.hs200_tx_tap = 12,
 	.hs400_tx_tap = 6,
 	.hs400_cmd_tap = 6,
@@ -653,9 +783,14 @@ static const struct sdhci_data rk3528_data = {
 static const struct sdhci_data rk3562_data = {
 	.emmc_set_clock = dwcmshc_sdhci_emmc_set_clock,
 	.get_phy = dwcmshc_emmc_get_phy,
+#if CONFIG_IS_ENABLED(MMC_TUNING_CACHE)
+	.get_tuning = dwcmshc_sdhci_get_tuning,
+	.set_tuning = dwcmshc_sdhci_set_tuning,
+	.reset_tuning = dwcmshc_sdhci_reset_tuning,
+#endif
 	.set_ios_post = dwcmshc_sdhci_set_ios_post,
 	.set_enhanced_strobe = dwcmshc_sdhci_set_enhanced_strobe,
-	.flags = RK_DLL_CMD_OUT | RK_TAP_VALUE_SEL,
+	.flags = RK_DLL_CMD_OUT | RK_TAP_VALUE_SEL | RK_CQE,
 	.hs200_tx_tap = 12,
 	.hs400_tx_tap = 6,
 	.hs400_cmd_tap = 6,
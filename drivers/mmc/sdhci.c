@@ -9,6 +9,7 @@
  */
 
 #include <common.h>
+#include <cqhci.h>
 #include <errno.h>
 #include <malloc.h>
 #include <mmc.h>
@@ -300,6 +301,12 @@ static int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
 	stat = sdhci_readl(host, SDHCI_INT_STATUS);
 	sdhci_writel(host, SDHCI_INT_ALL_MASK, SDHCI_INT_STATUS);
 	if (!ret) {
+#ifdef CONFIG_MMC_SDHCI_SDMA
+		/* Drop lines the CPU may have prefetched during the DMA */
+		if (data && data->flags == MMC_DATA_READ)
+			invalidate_dcache_range(start_addr,
+						start_addr + trans_bytes);
+#endif
 		if ((host->quirks & SDHCI_QUIRK_32BIT_DMA_ADDR) &&
 				!is_aligned && (data->flags == MMC_DATA_READ))
 			memcpy(data->dest, aligned_buffer, trans_bytes);
@@ -675,6 +682,11 @@ static int sdhci_execute_tuning(struct mmc *mmc, u32 opcode)
 		return -EINVAL;
 	}
 
+#if CONFIG_IS_ENABLED(MMC_TUNING_CACHE)
+	if (host->ops && host->ops->reset_tuning)
+		host->ops->reset_tuning(host);
+#endif
+
 	ctrl = sdhci_readw(host, SDHCI_HOST_CONTROL2);
 	ctrl |= SDHCI_CTRL_EXEC_TUNING;
 	sdhci_writew(host, ctrl, SDHCI_HOST_CONTROL2);
@@ -682,6 +694,30 @@ static int sdhci_execute_tuning(struct mmc *mmc, u32 opcode)
 	return __sdhci_execute_tuning(host, opcode);
 }
 
+#if defined(CONFIG_DM_MMC) && CONFIG_IS_ENABLED(MMC_TUNING_CACHE)
+static int sdhci_get_tuning(struct udevice *dev, u32 *phase)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	struct sdhci_host *host = mmc->priv;
+
+	if (!host->ops || !host->ops->get_tuning)
+		return -ENOSYS;
+
+	return host->ops->get_tuning(host, phase);
+}
+
+static int sdhci_set_tuning(struct udevice *dev, u32 phase)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	struct sdhci_host *host = mmc->priv;
+
+	if (!host->ops || !host->ops->set_tuning)
+		return -ENOSYS;
+
+	return host->ops->set_tuning(host, phase);
+}
+#endif
+
 #ifdef CONFIG_DM_MMC
 int sdhci_probe(struct udevice *dev)
 {
@@ -701,12 +737,86 @@ static int sdhci_set_enhanced_strobe(struct udevice *dev)
 	return -ENOTSUPP;
 }
 
+#if CONFIG_IS_ENABLED(MMC_CQHCI)
+static int sdhci_cqe_enable(struct udevice *dev)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	struct sdhci_host *host = mmc->priv;
+	u8 ctrl;
+
+	if (!host->cqe)
+		return -ENOSYS;
+
+	/* The engine moves the data with ADMA2, in 512-byte blocks */
+	ctrl = sdhci_readb(host, SDHCI_HOST_CONTROL);
+	ctrl &= ~SDHCI_CTRL_DMA_MASK;
+	ctrl |= SDHCI_CTRL_ADMA32;
+	sdhci_writeb(host, ctrl, SDHCI_HOST_CONTROL);
+	sdhci_writew(host, SDHCI_MAKE_BLKSZ(SDHCI_DEFAULT_BOUNDARY_ARG, 512),
+		     SDHCI_BLOCK_SIZE);
+	sdhci_writew(host, SDHCI_TRNS_MULTI | SDHCI_TRNS_BLK_CNT_EN |
+		     SDHCI_TRNS_DMA, SDHCI_TRANSFER_MODE);
+
+	sdhci_writel(host, SDHCI_INT_ERROR_MASK | SDHCI_INT_CQE,
+		     SDHCI_INT_ENABLE);
+	sdhci_writel(host, SDHCI_INT_ALL_MASK, SDHCI_INT_STATUS);
+
+	return cqhci_enable(host->cqe);
+}
+
+static int sdhci_cqe_disable(struct udevice *dev)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	struct sdhci_host *host = mmc->priv;
+	int ret;
+	u8 ctrl;
+
+	if (!host->cqe)
+		return -ENOSYS;
+
+	ret = cqhci_disable(host->cqe);
+
+	/* Back to what sdhci_send_command() expects */
+	ctrl = sdhci_readb(host, SDHCI_HOST_CONTROL);
+	ctrl &= ~SDHCI_CTRL_DMA_MASK;
+	sdhci_writeb(host, ctrl, SDHCI_HOST_CONTROL);
+	sdhci_writel(host, SDHCI_INT_DATA_MASK | SDHCI_INT_CMD_MASK,
+		     SDHCI_INT_ENABLE);
+	sdhci_writel(host, SDHCI_INT_ALL_MASK, SDHCI_INT_STATUS);
+	if (ret)
+		sdhci_reset(host, SDHCI_RESET_CMD | SDHCI_RESET_DATA);
+
+	return ret;
+}
+
+static int sdhci_cqe_request(struct udevice *dev, struct mmc_cqe_task *tasks,
+			     int count)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	struct sdhci_host *host = mmc->priv;
+
+	if (!host->cqe)
+		return -ENOSYS;
+
+	return cqhci_request(host->cqe, tasks, count);
+}
+#endif
+
 const struct dm_mmc_ops sdhci_ops = {
 	.card_busy	= sdhci_card_busy,
 	.send_cmd	= sdhci_send_command,
 	.set_ios	= sdhci_set_ios,
 	.execute_tuning = sdhci_execute_tuning,
 	.set_enhanced_strobe = sdhci_set_enhanced_strobe,
+#if CONFIG_IS_ENABLED(MMC_CQHCI)
+	.cqe_enable	= sdhci_cqe_enable,
+	.cqe_disable	= sdhci_cqe_disable,
+	.cqe_request	= sdhci_cqe_request,
+#endif
+#if CONFIG_IS_ENABLED(MMC_TUNING_CACHE)
+	.get_tuning	= sdhci_get_tuning,
+	.set_tuning	= sdhci_set_tuning,
+#endif
 };
 #else
 static const struct mmc_ops sdhci_ops = {
@@ -174,6 +174,7 @@ static void tx_descs_init(struct dw_eth_dev *priv)
 
 	writel((ulong)&desc_table_p[0], &dma_p->txdesclistaddr);
 	priv->tx_currdescnum = 0;
+	priv->tx_free = 0;
 }
 
 static void rx_descs_init(struct dw_eth_dev *priv)
@@ -214,6 +215,9 @@ static void rx_descs_init(struct dw_eth_dev *priv)
 
 	writel((ulong)&desc_table_p[0], &dma_p->rxdesclistaddr);
 	priv->rx_currdescnum = 0;
+	priv->rx_ready = 0;
+	priv->rx_freedescnum = 0;
+	priv->rx_freecount = 0;
 }
 
 static int _dw_write_hwaddr(struct dw_eth_dev *priv, u8 *mac_id)
@@ -343,6 +347,34 @@ int designware_eth_enable(struct dw_eth_dev *priv)
 	return 0;
 }
 
+/*
+ * Find out how many descriptors from tx_currdescnum on the DMA is done
+ * with, invalidating up to DW_TX_BATCH of them in one go rather than
+ * one per frame. The batch stops at the end of the ring so that it is
+ * a single address range.
+ */
+static u32 dw_tx_reclaim(struct dw_eth_dev *priv)
+{
+	u32 desc_num = priv->tx_currdescnum;
+	u32 count = min_t(u32, DW_TX_BATCH, CONFIG_TX_DESCR_NUM - desc_num);
+	struct dmamacdescr *desc_p = &priv->tx_mac_descrtable[desc_num];
+	u32 i;
+
+	/*
+	 * Strictly we only need to invalidate the "txrx_status" fields,
+	 * but on some platforms we cannot invalidate only 4 bytes. This
+	 * is safe because the individual descriptors in the array are
+	 * each aligned to ARCH_DMA_MINALIGN and padded appropriately.
+	 */
+	invalidate_dcache_range((ulong)desc_p, (ulong)(desc_p + count));
+
+	for (i = 0; i < count; i++)
+		if (desc_p[i].txrx_status & DESC_TXSTS_OWNBYDMA)
+			break;
+
+	return i;
+}
+
 static int _dw_eth_send(struct dw_eth_dev *priv, void *packet, int length)
 {
 	struct eth_dma_regs *dma_p = priv->dma_regs_p;
@@ -353,21 +385,15 @@ static int _dw_eth_send(struct dw_eth_dev *priv, void *packet, int length)
 		roundup(sizeof(*desc_p), ARCH_DMA_MINALIGN);
 	ulong data_start = desc_p->dmamac_addr;
 	ulong data_end = data_start + roundup(length, ARCH_DMA_MINALIGN);
-	/*
-	 * Strictly we only need to invalidate the "txrx_status" field
-	 * for the following check, but on some platforms we cannot
-	 * invalidate only 4 bytes, so we flush the entire descriptor,
-	 * which is 16 bytes in total. This is safe because the
-	 * individual descriptors in the array are each aligned to
-	 * ARCH_DMA_MINALIGN and padded appropriately.
-	 */
-	invalidate_dcache_range(desc_start, desc_end);
 
 	/* Check if the descriptor is owned by CPU */
-	if (desc_p->txrx_status & DESC_TXSTS_OWNBYDMA) {
+	if (!priv->tx_free)
+		priv->tx_free = dw_tx_reclaim(priv);
+	if (!priv->tx_free) {
 		printf("CPU not owner of tx frame\n");
 		return -EPERM;
 	}
+	priv->tx_free--;
 
 	memcpy((void *)data_start, packet, length);
 
@@ -404,53 +430,87 @@ static int _dw_eth_send(struct dw_eth_dev *priv, void *packet, int length)
 	return 0;
 }
 
-static int _dw_eth_recv(struct dw_eth_dev *priv, uchar **packetp)
+/* Hand the descriptors freed so far back to the DMA in one flush */
+static void dw_rx_flush_free(struct dw_eth_dev *priv)
+{
+	struct dmamacdescr *desc_p =
+		&priv->rx_mac_descrtable[priv->rx_freedescnum];
+
+	if (!priv->rx_freecount)
+		return;
+
+	/* Flush only status fields - others weren't changed */
+	flush_dcache_range((ulong)desc_p,
+			   (ulong)(desc_p + priv->rx_freecount));
+	priv->rx_freecount = 0;
+}
+
+/*
+ * Collect the frames the DMA has completed from rx_currdescnum on, up
+ * to DW_RX_BATCH and never past the end of the ring, so that their
+ * descriptors and their buffers each take a single invalidate.
+ */
+static u32 dw_rx_batch(struct dw_eth_dev *priv)
 {
-	u32 status, desc_num = priv->rx_currdescnum;
+	u32 desc_num = priv->rx_currdescnum;
+	u32 count = min_t(u32, DW_RX_BATCH, CONFIG_RX_DESCR_NUM - desc_num);
 	struct dmamacdescr *desc_p = &priv->rx_mac_descrtable[desc_num];
-	int length = -EAGAIN;
-	ulong desc_start = (ulong)desc_p;
-	ulong desc_end = desc_start +
-		roundup(sizeof(*desc_p), ARCH_DMA_MINALIGN);
-	ulong data_start = desc_p->dmamac_addr;
-	ulong data_end;
+	ulong data_start, data_end;
+	u32 status, length, i;
 
-	/* Invalidate entire buffer descriptor */
-	invalidate_dcache_range(desc_start, desc_end);
+	invalidate_dcache_range((ulong)desc_p, (ulong)(desc_p + count));
 
-	status = desc_p->txrx_status;
+	for (i = 0; i < count; i++)
+		if (desc_p[i].txrx_status & DESC_RXSTS_OWNBYDMA)
+			break;
+	if (!i)
+		return 0;
 
-	/* Check  if the owner is the CPU */
-	if (!(status & DESC_RXSTS_OWNBYDMA)) {
+	/* Rx buffers are contiguous in descriptor order */
+	status = desc_p[i - 1].txrx_status;
+	length = (status & DESC_RXSTS_FRMLENMSK) >> DESC_RXSTS_FRMLENSHFT;
+	data_start = desc_p[0].dmamac_addr;
+	data_end = desc_p[i - 1].dmamac_addr +
+		roundup(length, ARCH_DMA_MINALIGN);
+	invalidate_dcache_range(data_start, data_end);
 
-		length = (status & DESC_RXSTS_FRMLENMSK) >>
-			 DESC_RXSTS_FRMLENSHFT;
+	return i;
+}
 
-		/* Invalidate received data */
-		data_end = data_start + roundup(length, ARCH_DMA_MINALIGN);
-		invalidate_dcache_range(data_start, data_end);
-		*packetp = (uchar *)(ulong)desc_p->dmamac_addr;
+static int _dw_eth_recv(struct dw_eth_dev *priv, uchar **packetp)
+{
+	struct dmamacdescr *desc_p;
+	u32 status;
+
+	if (!priv->rx_ready) {
+		priv->rx_ready = dw_rx_batch(priv);
+		if (!priv->rx_ready)
+			return -EAGAIN;
 	}
 
-	return length;
+	desc_p = &priv->rx_mac_descrtable[priv->rx_currdescnum];
+	status = desc_p->txrx_status;
+	*packetp = (uchar *)(ulong)desc_p->dmamac_addr;
+
+	return (status & DESC_RXSTS_FRMLENMSK) >> DESC_RXSTS_FRMLENSHFT;
 }
 
 static int _dw_free_pkt(struct dw_eth_dev *priv)
 {
 	u32 desc_num = priv->rx_currdescnum;
 	struct dmamacdescr *desc_p = &priv->rx_mac_descrtable[desc_num];
-	ulong desc_start = (ulong)desc_p;
-	ulong desc_end = desc_start +
-		roundup(sizeof(*desc_p), ARCH_DMA_MINALIGN);
 
 	/*
 	 * Make the current descriptor valid again and go to
-	 * the next one
+	 * the next one. The flush is deferred until the whole batch has
+	 * been handed back; a batch never wraps, so it is one range.
 	 */
 	desc_p->txrx_status |= DESC_RXSTS_OWNBYDMA;
-
-	/* Flush only status field - others weren't changed */
-	flush_dcache_range(desc_start, desc_end);
+	if (!priv->rx_freecount)
+		priv->rx_freedescnum = desc_num;
+	priv->rx_freecount++;
+	if (!--priv->rx_ready)
+		dw_rx_flush_free(priv);
 
 	/* Test the wrap-around condition. */
 	if (++desc_num >= CONFIG_RX_DESCR_NUM)
@@ -510,13 +570,17 @@ static int dw_eth_recv(struct eth_device *dev)
 {
 	uchar *packet;
 	int length;
+	int i;
 
-	length = _dw_eth_recv(dev->priv, &packet);
-	if (length == -EAGAIN)
-		return 0;
-	net_process_received_packet(packet, length);
+	/* Drain the whole batch, like eth_rx() does for driver model */
+	for (i = 0; i < CONFIG_RX_DESCR_NUM; i++) {
+		length = _dw_eth_recv(dev->priv, &packet);
+		if (length == -EAGAIN)
+			break;
+		net_process_received_packet(packet, length);
 
-	_dw_free_pkt(dev->priv);
+		_dw_free_pkt(dev->priv);
+	}
 
 	return 0;
 }
@@ -12,8 +12,25 @@
 #include <asm-generic/gpio.h>
 #endif
 
+#ifdef CONFIG_DW_ETH_TX_DESCR_NUM
+#define CONFIG_TX_DESCR_NUM	CONFIG_DW_ETH_TX_DESCR_NUM
+#else
 #define CONFIG_TX_DESCR_NUM	16
+#endif
+#ifdef CONFIG_DW_ETH_RX_DESCR_NUM
+#define CONFIG_RX_DESCR_NUM	CONFIG_DW_ETH_RX_DESCR_NUM
+#else
 #define CONFIG_RX_DESCR_NUM	16
+#endif
+/*
+ * Descriptors looked at per cache maintenance operation: received
+ * frames are picked up and handed back, and sent descriptors reclaimed,
+ * this many at a time. Rx batches stay within half the ring so that the
+ * DMA keeps descriptors to fill while a batch is being processed.
+ */
+#define DW_RX_BATCH		(CONFIG_RX_DESCR_NUM < 32 ? \
+				 CONFIG_RX_DESCR_NUM / 2 : 16)
+#define DW_TX_BATCH		16
 #define CONFIG_ETH_BUFSIZE	2048
 #define TX_TOTAL_BUFSIZE	(CONFIG_ETH_BUFSIZE * CONFIG_TX_DESCR_NUM)
 #define RX_TOTAL_BUFSIZE	(CONFIG_ETH_BUFSIZE * CONFIG_RX_DESCR_NUM)
@@ -230,6 +247,13 @@ struct dw_eth_dev {
 	u32 max_speed;
 	u32 tx_currdescnum;
 	u32 rx_currdescnum;
+	/* Tx descriptors from tx_currdescnum on known to be free */
+	u32 tx_free;
+	/* Rx frames from rx_currdescnum on already invalidated */
+	u32 rx_ready;
+	/* First Rx descriptor handed back but not yet flushed, and count */
+	u32 rx_freedescnum;
+	u32 rx_freecount;
 
 	struct eth_mac_regs *mac_regs_p;
 	struct eth_dma_regs *dma_regs_p;
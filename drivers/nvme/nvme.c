@@ -12,17 +12,17 @@
 #include <memalign.h>
 #include <pci.h>
 #include <dm/device-internal.h>
+#include <linux/log2.h>
 #include "nvme.h"
 
-#define NVME_Q_DEPTH		2
+#define NVME_Q_DEPTH		CONFIG_NVME_QUEUE_DEPTH
 #define NVME_AQ_DEPTH		2
 #define NVME_SQ_SIZE(depth)	(depth * sizeof(struct nvme_command))
 #define NVME_CQ_SIZE(depth)	(depth * sizeof(struct nvme_completion))
-#define NVME_CQ_ALLOCATION	ALIGN(NVME_CQ_SIZE(NVME_Q_DEPTH), \
-				      ARCH_DMA_MINALIGN)
+#define NVME_CQ_ALLOCATION(depth)	ALIGN(NVME_CQ_SIZE(depth), \
+					      ARCH_DMA_MINALIGN)
 #define ADMIN_TIMEOUT		60
 #define IO_TIMEOUT		30
-#define MAX_PRP_POOL		512
 
 enum nvme_queue_id {
 	NVME_ADMIN_Q,
@@ -69,16 +69,26 @@ static int nvme_wait_ready(struct nvme_dev *dev, bool enabled)
 	return -ETIME;
 }
 
-static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp2,
+/**
+ * nvme_setup_prps() - describe a buffer with PRP entries
+ *
+ * Transfers are limited to what a single PRP list page can describe (see
+ * nvme_get_info_from_identify()), so the list never needs chaining.
+ *
+ * @dev:	NVMe device
+ * @prp_list:	Page-sized PRP list to fill in, if one is needed
+ * @prp2:	Returns the value of the command's PRP entry 2
+ * @total_len:	Length of the transfer in bytes
+ * @dma_addr:	Start of the buffer
+ * @return 0 if OK, -EINVAL if the transfer does not fit in @prp_list
+ */
+static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp_list, u64 *prp2,
 			   int total_len, u64 dma_addr)
 {
 	u32 page_size = dev->page_size;
 	int offset = dma_addr & (page_size - 1);
-	u64 *prp_pool;
 	int length = total_len;
 	int i, nprps;
-	u32 prps_per_page = page_size >> 3;
-	u32 num_pages;
 
 	length -= (page_size - offset);
 
@@ -87,8 +97,7 @@ static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp2,
 		return 0;
 	}
 
-	if (length)
-		dma_addr += (page_size - offset);
+	dma_addr += (page_size - offset);
 
 	if (length <= page_size) {
 		*prp2 = dma_addr;
@@ -96,40 +105,17 @@ static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp2,
 	}
 
 	nprps = DIV_ROUND_UP(length, page_size);
-	num_pages = DIV_ROUND_UP(nprps + 1, prps_per_page);
-
-	if (nprps > dev->prp_entry_num) {
-		free(dev->prp_pool);
-		/*
-		 * Always increase in increments of pages.  It doesn't waste
-		 * much memory and reduces the number of allocations.
-		 */
-		dev->prp_pool = memalign(page_size, num_pages * page_size);
-		if (!dev->prp_pool) {
-			printf("Error: malloc prp_pool fail\n");
-			return -ENOMEM;
-		}
-		dev->prp_entry_num = prps_per_page * num_pages;
-	}
+	if (nprps > page_size >> 3)
+		return -EINVAL;
 
-	prp_pool = dev->prp_pool;
-	i = 0;
-	while (nprps) {
-		if (i == prps_per_page) {
-			*(prp_pool + i) = *(prp_pool + i - 1);
-			*(prp_pool + i - 1) = cpu_to_le64((ulong)prp_pool +
-					page_size);
-			i = 1;
-			prp_pool += page_size;
-		}
-		*(prp_pool + i++) = cpu_to_le64(dma_addr);
+	for (i = 0; i < nprps; i++) {
+		prp_list[i] = cpu_to_le64(dma_addr);
 		dma_addr += page_size;
-		nprps--;
 	}
-	*prp2 = (ulong)dev->prp_pool;
+	*prp2 = (ulong)prp_list;
 
-	flush_dcache_range((ulong)dev->prp_pool, (ulong)dev->prp_pool +
-			   dev->prp_entry_num * sizeof(u64));
+	flush_dcache_range((ulong)prp_list,
+			   ALIGN((ulong)&prp_list[nprps], ARCH_DMA_MINALIGN));
 
 	return 0;
 }
@@ -146,11 +132,12 @@ static u16 nvme_read_completion_status(struct nvme_queue *nvmeq, u16 index)
 	/*
 	 * Single CQ entries are always smaller than a cache line, so we
 	 * can't invalidate them individually. However CQ entries are
-	 * read only by the CPU, so it's safe to always invalidate all of them,
-	 * as the cache line should never become dirty.
+	 * read only by the CPU, so it's safe to invalidate the whole line
+	 * holding the entry, as the cache line should never become dirty.
+	 * Deep queues are polled a lot, so don't invalidate more than that.
 	 */
-	ulong start = (ulong)&nvmeq->cqes[0];
-	ulong stop = start + NVME_CQ_ALLOCATION;
+	ulong start = rounddown((ulong)&nvmeq->cqes[index], ARCH_DMA_MINALIGN);
+	ulong stop = start + ARCH_DMA_MINALIGN;
 
 	invalidate_dcache_range(start, stop);
 
@@ -158,12 +145,15 @@ static u16 nvme_read_completion_status(struct nvme_queue *nvmeq, u16 index)
 }
 
 /**
- * nvme_submit_cmd() - copy a command into a queue and ring the doorbell
+ * nvme_queue_cmd() - copy a command into a queue without ringing the doorbell
+ *
+ * The controller does not see the command until nvme_ring_sq() is called,
+ * which allows several commands to be handed over with one MMIO write.
  *
  * @nvmeq:	The queue to use
  * @cmd:	The command to send
  */
-static void nvme_submit_cmd(struct nvme_queue *nvmeq, struct nvme_command *cmd)
+static void nvme_queue_cmd(struct nvme_queue *nvmeq, struct nvme_command *cmd)
 {
 	u16 tail = nvmeq->sq_tail;
 
@@ -173,10 +163,63 @@ static void nvme_submit_cmd(struct nvme_queue *nvmeq, struct nvme_command *cmd)
 
 	if (++tail == nvmeq->q_depth)
 		tail = 0;
-	writel(tail, nvmeq->q_db);
 	nvmeq->sq_tail = tail;
 }
 
+static void nvme_ring_sq(struct nvme_queue *nvmeq)
+{
+	writel(nvmeq->sq_tail, nvmeq->q_db);
+}
+
+/**
+ * nvme_submit_cmd() - copy a command into a queue and ring the doorbell
+ *
+ * @nvmeq:	The queue to use
+ * @cmd:	The command to send
+ */
+static void nvme_submit_cmd(struct nvme_queue *nvmeq, struct nvme_command *cmd)
+{
+	nvme_queue_cmd(nvmeq, cmd);
+	nvme_ring_sq(nvmeq);
+}
+
+/**
+ * nvme_reap_cqe() - consume the next completion queue entry, if any
+ *
+ * The head doorbell is not written; call nvme_ring_cq() once a batch of
+ * entries has been consumed.
+ *
+ * @nvmeq:	The queue to use
+ * @cmd_id:	Returns the command id of the completed command
+ * @status:	Returns the status field of the completion, phase removed
+ * @return true if an entry was consumed, false if none is pending
+ */
+static bool nvme_reap_cqe(struct nvme_queue *nvmeq, u16 *cmd_id, u16 *status)
+{
+	u16 head = nvmeq->cq_head;
+	u16 st;
+
+	st = nvme_read_completion_status(nvmeq, head);
+	if ((st & 0x01) != nvmeq->cq_phase)
+		return false;
+
+	*cmd_id = readw(&nvmeq->cqes[head].command_id);
+	*status = st >> 1;
+
+	if (++head == nvmeq->q_depth) {
+		head = 0;
+		nvmeq->cq_phase = !nvmeq->cq_phase;
+	}
+	nvmeq->cq_head = head;
+
+	return true;
+}
+
+static void nvme_ring_cq(struct nvme_queue *nvmeq)
+{
+	writel(nvmeq->cq_head, nvmeq->q_db + nvmeq->dev->db_stride);
+}
+
 static int nvme_submit_sync_cmd(struct nvme_queue *nvmeq,
 				struct nvme_command *cmd,
 				u32 *result, unsigned timeout)
@@ -246,7 +289,7 @@ static struct nvme_queue *nvme_alloc_queue(struct nvme_dev *dev,
 		return NULL;
 	memset(nvmeq, 0, sizeof(*nvmeq));
 
-	nvmeq->cqes = (void *)memalign(4096, NVME_CQ_ALLOCATION);
+	nvmeq->cqes = (void *)memalign(4096, NVME_CQ_ALLOCATION(depth));
 	if (!nvmeq->cqes)
 		goto free_nvmeq;
 	memset((void *)nvmeq->cqes, 0, NVME_CQ_SIZE(depth));
@@ -344,7 +387,8 @@ static void nvme_init_queue(struct nvme_queue *nvmeq, u16 qid)
 	nvmeq->q_db = &dev->dbs[qid * 2 * dev->db_stride];
 	memset((void *)nvmeq->cqes, 0, NVME_CQ_SIZE(nvmeq->q_depth));
 	flush_dcache_range((ulong)nvmeq->cqes,
-			   (ulong)nvmeq->cqes + NVME_CQ_ALLOCATION);
+			   (ulong)nvmeq->cqes +
+			   NVME_CQ_ALLOCATION(nvmeq->q_depth));
 	dev->online_queues++;
 }
 
@@ -654,6 +698,13 @@ static int nvme_get_info_from_identify(struct nvme_dev *dev)
 		dev->max_transfer_shift = 20;
 	}
 
+	/*
+	 * Keep every command within what one PRP list page can describe,
+	 * so that each in-flight command needs exactly one page of PRPs.
+	 */
+	dev->max_transfer_shift = min_t(u32, dev->max_transfer_shift,
+					2 * ilog2(dev->page_size) - 3);
+
 	free(ctrl);
 	return 0;
 }
@@ -730,26 +781,60 @@ static int nvme_blk_probe(struct udevice *udev)
 	return 0;
 }
 
+/*
+ * Drop every command still queued on the I/O queue. Deleting a submission
+ * queue aborts its commands before the delete completes, so the controller
+ * no longer transfers to or from their buffers, and no late completion
+ * can be mistaken for one of a later command with the same id.
+ */
+static int nvme_reset_io_queue(struct nvme_dev *dev)
+{
+	struct nvme_queue *nvmeq = dev->queues[NVME_IO_Q];
+	int ret;
+
+	ret = nvme_delete_sq(dev, NVME_IO_Q);
+	if (!ret)
+		ret = nvme_delete_cq(dev, NVME_IO_Q);
+	if (ret) {
+		/* A disabled controller does no more DMA either */
+		printf("ERROR: cannot delete I/O queue, disabling controller\n");
+		nvme_disable_ctrl(dev);
+		return ret;
+	}
+
+	dev->online_queues--;
+	ret = nvme_create_queue(nvmeq, NVME_IO_Q);
+
+	return ret < 0 ? ret : 0;
+}
+
 static ulong nvme_blk_rw(struct udevice *udev, lbaint_t blknr,
 			 lbaint_t blkcnt, void *buffer, bool read)
 {
 	struct nvme_ns *ns = dev_get_priv(udev);
 	struct nvme_dev *dev = ns->dev;
+	struct nvme_queue *nvmeq = dev->queues[NVME_IO_Q];
 	struct nvme_command c;
 	struct blk_desc *desc = dev_get_uclass_platdata(udev);
-	int status;
-	u64 prp2;
 	u64 total_len = blkcnt << desc->log2blksz;
-	u64 temp_len = total_len;
 	uintptr_t temp_buffer;
+	u32 prps_per_page = dev->page_size >> 3;
 
 	u64 slba = blknr;
 	u16 lbas = 1 << (dev->max_transfer_shift - ns->lba_shift);
 	u64 total_lbas = blkcnt;
+	/* First block that did not make it, blknr + blkcnt if all did */
+	u64 fail_lba = blknr + blkcnt;
+
+	/* Start LBA of the command in each slot; the slot is the command id */
+	u64 slot_lba[NVME_Q_DEPTH];
+	u16 free_slot[NVME_Q_DEPTH];
+	int nr_free, inflight = 0;
+	ulong start;
 
 	struct bounce_buffer bb;
 	unsigned int bb_flags;
-	int ret;
+	int i, ret;
 
 	if (read)
 		bb_flags = GEN_BB_WRITE;
@@ -761,47 +846,92 @@ static ulong nvme_blk_rw(struct udevice *udev, lbaint_t blknr,
 		return -ENOMEM;
 	temp_buffer = (unsigned long)bb.bounce_buffer;
 
+	/* A queue of depth n holds at most n - 1 commands */
+	nr_free = nvmeq->q_depth - 1;
+	for (i = 0; i < nr_free; i++)
+		free_slot[i] = nr_free - 1 - i;
+
+	memset(&c, 0, sizeof(c));
 	c.rw.opcode = read ? nvme_cmd_read : nvme_cmd_write;
-	c.rw.flags = 0;
 	c.rw.nsid = cpu_to_le32(ns->ns_id);
-	c.rw.control = 0;
-	c.rw.dsmgmt = 0;
-	c.rw.reftag = 0;
-	c.rw.apptag = 0;
-	c.rw.appmask = 0;
-	c.rw.metadata = 0;
 
 	/* Enable FUA for data integrity if vwc is enabled */
 	if (dev->vwc)
 		c.rw.control |= NVME_RW_FUA;
 
-	while (total_lbas) {
-		if (total_lbas < lbas) {
-			lbas = (u16)total_lbas;
-			total_lbas = 0;
-		} else {
+	/*
+	 * Keep the queue full: hand over as many commands as there are free
+	 * slots with one doorbell write, then consume every completion that
+	 * has been posted and update the head doorbell once for all of them.
+	 */
+	start = get_timer(0);
+	while ((total_lbas && fail_lba == blknr + blkcnt) || inflight) {
+		bool queued = false;
+		u16 cmd_id, status;
+		u64 prp2;
+		int slot;
+
+		while (total_lbas && nr_free && fail_lba == blknr + blkcnt) {
+			if (total_lbas < lbas)
+				lbas = (u16)total_lbas;
+
+			slot = free_slot[--nr_free];
+			if (nvme_setup_prps(dev,
+					    dev->prp_pool + slot * prps_per_page,
+					    &prp2, lbas << ns->lba_shift,
+					    temp_buffer)) {
+				free_slot[nr_free++] = slot;
+				fail_lba = slba;
+				break;
+			}
+			slot_lba[slot] = slba;
+			c.rw.command_id = cpu_to_le16(slot);
+			c.rw.slba = cpu_to_le64(slba);
+			c.rw.length = cpu_to_le16(lbas - 1);
+			c.rw.prp1 = cpu_to_le64(temp_buffer);
+			c.rw.prp2 = cpu_to_le64(prp2);
+			nvme_queue_cmd(nvmeq, &c);
+			queued = true;
+			inflight++;
+
 			total_lbas -= lbas;
+			slba += lbas;
+			temp_buffer += lbas << ns->lba_shift;
 		}
+		if (queued)
+			nvme_ring_sq(nvmeq);
+
+		if (!inflight)
+			break;
 
-		if (nvme_setup_prps(dev, &prp2,
-				    lbas << ns->lba_shift, temp_buffer))
-			return -EIO;
-		c.rw.slba = cpu_to_le64(slba);
-		slba += lbas;
-		c.rw.length = cpu_to_le16(lbas - 1);
-		c.rw.prp1 = cpu_to_le64(temp_buffer);
-		c.rw.prp2 = cpu_to_le64(prp2);
-		status = nvme_submit_sync_cmd(dev->queues[NVME_IO_Q],
-				&c, NULL, IO_TIMEOUT);
-		if (status)
+		i = 0;
+		while (nvme_reap_cqe(nvmeq, &cmd_id, &status)) {
+			slot = le16_to_cpu(cmd_id);
+			if (slot >= nvmeq->q_depth - 1)
+				continue;
+			if (status) {
+				printf("ERROR: status = %x, lba = %llx\n", status,
+				       (unsigned long long)slot_lba[slot]);
+				fail_lba = min(fail_lba, slot_lba[slot]);
+			}
+			free_slot[nr_free++] = slot;
+			inflight--;
+			i++;
+		}
+		if (i) {
+			nvme_ring_cq(nvmeq);
+			start = get_timer(0);
+		} else if (get_timer(start) > IO_TIMEOUT * 1000) {
+			printf("ERROR: %d command(s) timed out\n", inflight);
+			fail_lba = blknr;
+			nvme_reset_io_queue(dev);
 			break;
-		temp_len -= (u32)lbas << ns->lba_shift;
-		temp_buffer += lbas << ns->lba_shift;
+		}
 	}
 
 	bounce_buffer_stop(&bb);
 
-	return (total_len - temp_len) >> desc->log2blksz;
+	return fail_lba - blknr;
 }
 
 static ulong nvme_blk_read(struct udevice *udev, lbaint_t blknr,
@@ -873,14 +1003,17 @@ static int nvme_probe(struct udevice *udev)
 	if (ret)
 		goto free_queue;
 
-	/* Allocate after the page size is known */
-	ndev->prp_pool = memalign(ndev->page_size, MAX_PRP_POOL);
+	/*
+	 * Allocate after the page size is known: one PRP list page for each
+	 * command that can be in flight on the I/O queue.
+	 */
+	ndev->prp_pool = memalign(ndev->page_size,
+				  (ndev->q_depth - 1) * ndev->page_size);
 	if (!ndev->prp_pool) {
 		ret = -ENOMEM;
 		printf("Error: %s: Out of memory!\n", udev->name);
 		goto free_nvme;
 	}
-	ndev->prp_entry_num = MAX_PRP_POOL >> 3;
 
 	ret = nvme_setup_io_queues(ndev);
 	if (ret)
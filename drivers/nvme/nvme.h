@@ -625,8 +625,7 @@ struct nvme_dev {
 	u32 stripe_size;
 	u32 page_size;
 	u8 vwc;
-	u64 *prp_pool;
-	u32 prp_entry_num;
+	u64 *prp_pool;		/* a PRP list page per I/O queue slot */
 	u32 nn;
 };
 
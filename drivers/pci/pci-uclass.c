@@ -1277,15 +1277,10 @@ U_BOOT_DRIVER(pci_generic_drv) = {
 
 void pci_init(void)
 {
-	struct udevice *bus;
-
 	/*
 	 * Enumerate all known controller devices. Enumeration has the side-
 	 * effect of probing them, so PCIe devices will be enumerated too.
+	 * Controllers waiting for link training do so side by side.
 	 */
-	for (uclass_first_device(UCLASS_PCI, &bus);
-	     bus;
-	     uclass_next_device(&bus)) {
-		;
-	}
+	uclass_probe_all(UCLASS_PCI);
 }
@@ -70,6 +70,19 @@ struct rk_pcie {
 	struct pci_region	mem;
 	bool		is_bifurcation;
 	u32 gen;
+	/* Link training, stepped by rockchip_pcie_probe_finish() */
+	int		link_state;
+	int		link_retries;
+	ulong		link_stamp;
+	ulong		link_wait;
+};
+
+enum {
+	RK_PCIE_PERST_WAIT,	/* T_PVPERL before releasing PERST# */
+	RK_PCIE_LTSSM_WAIT,	/* PERST# released, LTSSM not started yet */
+	RK_PCIE_LINK_WAIT,	/* polling for link up */
+	RK_PCIE_LINK_SETTLE,	/* link up, allowing for a Gen switch */
+	RK_PCIE_LINK_DONE,
 };
 
 enum {
@@ -542,58 +555,96 @@ static int is_link_up(struct rk_pcie *priv)
 	return 0;
 }
 
-static int rk_pcie_link_up(struct rk_pcie *priv, u32 cap_speed)
+static void rk_pcie_link_wait(struct rk_pcie *priv, int state, ulong ms)
 {
-	int retries;
+	priv->link_state = state;
+	priv->link_stamp = get_timer(0);
+	priv->link_wait = ms;
+}
 
+static void rk_pcie_link_start(struct rk_pcie *priv, u32 cap_speed)
+{
 	if (is_link_up(priv)) {
 		printf("PCI Link already up before configuration!\n");
-		return 1;
+		priv->link_state = RK_PCIE_LINK_DONE;
+		return;
 	}
 
 	/* DW pre link configurations */
 	rk_pcie_configure(priv, cap_speed);
 
-	/* Release the device */
-	if (dm_gpio_is_valid(&priv->rst_gpio)) {
-		/*
-		 * T_PVPERL (Power stable to PERST# inactive) should be a minimum of 100ms.
-		 * We add a 200ms by default for sake of hoping everthings
-		 * work fine.
-		 */
-		msleep(200);
+	/*
+	 * T_PVPERL (Power stable to PERST# inactive) should be a minimum of
+	 * 100ms. We add a 200ms by default for sake of hoping everthings
+	 * work fine.
+	 */
+	if (dm_gpio_is_valid(&priv->rst_gpio))
+		rk_pcie_link_wait(priv, RK_PCIE_PERST_WAIT, 200);
+	else
+		rk_pcie_link_wait(priv, RK_PCIE_LTSSM_WAIT, 0);
+}
+
+/*
+ * Advance link training by one step without blocking. The delays between
+ * steps are the ones the blocking sequence used to msleep() for, so other
+ * controllers train their links while this one waits.
+ *
+ * Returns 0 once the link is up and settled, -EAGAIN while training is in
+ * progress, -ve error if the link did not come up.
+ */
+static int rk_pcie_link_step(struct rk_pcie *priv)
+{
+	if (priv->link_state == RK_PCIE_LINK_DONE)
+		return 0;
+	if (get_timer(priv->link_stamp) < priv->link_wait)
+		return -EAGAIN;
+
+	switch (priv->link_state) {
+	case RK_PCIE_PERST_WAIT:
+		/* Release the device */
 		dm_gpio_set_value(&priv->rst_gpio, 1);
 		/*
-		 * Add this 20ms delay because we observe link is always up stably after it and
-		 * could help us save 20ms for scanning devices.
+		 * Add this 20ms delay because we observe link is always up
+		 * stably after it and could help us save 20ms for scanning
+		 * devices.
 		 */
-		msleep(20);
-	}
-
-	rk_pcie_disable_ltssm(priv);
-	rk_pcie_link_status_clear(priv);
-	rk_pcie_enable_debug(priv);
-
-	/* Enable LTSSM */
-	rk_pcie_enable_ltssm(priv);
-
-	for (retries = 0; retries < 50; retries++) {
+		rk_pcie_link_wait(priv, RK_PCIE_LTSSM_WAIT, 20);
+		return -EAGAIN;
+	case RK_PCIE_LTSSM_WAIT:
+		rk_pcie_disable_ltssm(priv);
+		rk_pcie_link_status_clear(priv);
+		rk_pcie_enable_debug(priv);
+
+		/* Enable LTSSM */
+		rk_pcie_enable_ltssm(priv);
+		priv->link_retries = 0;
+		rk_pcie_link_wait(priv, RK_PCIE_LINK_WAIT, 0);
+		return -EAGAIN;
+	case RK_PCIE_LINK_WAIT:
 		if (is_link_up(priv)) {
 			dev_info(priv->dev, "PCIe Link up, LTSSM is 0x%x\n",
 				 rk_pcie_readl_apb(priv, PCIE_CLIENT_LTSSM_STATUS));
 			rk_pcie_debug_dump(priv);
 			/* Link maybe in Gen switch recovery but we need to wait more 1s */
-			msleep(1000);
-			return 0;
+			rk_pcie_link_wait(priv, RK_PCIE_LINK_SETTLE, 1000);
+			return -EAGAIN;
+		}
+		if (priv->link_retries++ == 50) {
+			dev_err(priv->dev, "PCIe-%d Link Fail\n",
+				priv->dev->seq);
+			return -EINVAL;
 		}
 
 		dev_info(priv->dev, "PCIe Linking... LTSSM is 0x%x\n",
 			 rk_pcie_readl_apb(priv, PCIE_CLIENT_LTSSM_STATUS));
 		rk_pcie_debug_dump(priv);
-		msleep(10);
+		rk_pcie_link_wait(priv, RK_PCIE_LINK_WAIT, 10);
+		return -EAGAIN;
+	case RK_PCIE_LINK_SETTLE:
+		priv->link_state = RK_PCIE_LINK_DONE;
+		return 0;
 	}
 
-	dev_err(priv->dev, "PCIe-%d Link Fail\n", priv->dev->seq);
 	return -EINVAL;
 }
 
@@ -658,13 +709,9 @@ static int rockchip_pcie_init_port(struct udevice *dev)
 	rk_pcie_writel_apb(priv, 0x0, 0xf00040);
 	rk_pcie_setup_host(priv);
 
-	ret = rk_pcie_link_up(priv, priv->gen);
-	if (ret < 0)
-		goto err_link_up;
+	rk_pcie_link_start(priv, priv->gen);
 
 	return 0;
-err_link_up:
-	clk_disable_bulk(&priv->clks);
 err_deassert_bulk:
 	reset_assert_bulk(&priv->rsts);
 err_power_off_phy:
@@ -674,6 +721,16 @@ err_exit_phy:
 	return ret;
 }
 
+static void rockchip_pcie_exit_port(struct udevice *dev)
+{
+	struct rk_pcie *priv = dev_get_priv(dev);
+
+	clk_disable_bulk(&priv->clks);
+	reset_assert_bulk(&priv->rsts);
+	generic_phy_power_off(&priv->phy);
+	generic_phy_exit(&priv->phy);
+}
+
 static int rockchip_pcie_parse_dt(struct udevice *dev)
 {
 	struct rk_pcie *priv = dev_get_priv(dev);
@@ -740,8 +797,6 @@ static int rockchip_pcie_parse_dt(struct udevice *dev)
 static int rockchip_pcie_probe(struct udevice *dev)
 {
 	struct rk_pcie *priv = dev_get_priv(dev);
-	struct udevice *ctlr = pci_get_controller(dev);
-	struct pci_controller *hose = dev_get_uclass_priv(ctlr);
 	int ret;
 
 	priv->first_busno = dev->seq;
@@ -751,9 +806,23 @@ static int rockchip_pcie_probe(struct udevice *dev)
 	if (ret)
 		return ret;
 
-	ret = rockchip_pcie_init_port(dev);
-	if (ret)
+	return rockchip_pcie_init_port(dev);
+}
+
+static int rockchip_pcie_probe_finish(struct udevice *dev)
+{
+	struct rk_pcie *priv = dev_get_priv(dev);
+	struct udevice *ctlr = pci_get_controller(dev);
+	struct pci_controller *hose = dev_get_uclass_priv(ctlr);
+	int ret;
+
+	ret = rk_pcie_link_step(priv);
+	if (ret == -EAGAIN)
 		return ret;
+	if (ret) {
+		rockchip_pcie_exit_port(dev);
+		return ret;
+	}
 
 	dev_info(dev, "PCIE-%d: Link up (Gen%d-x%d, Bus%d)\n",
 		 dev->seq, rk_pcie_get_link_speed(priv),
@@ -823,5 +892,6 @@ U_BOOT_DRIVER(rockchip_pcie) = {
 	.of_match		= rockchip_pcie_ids,
 	.ops			= &rockchip_pcie_ops,
 	.probe			= rockchip_pcie_probe,
+	.probe_finish		= rockchip_pcie_probe_finish,
 	.priv_auto_alloc_size	= sizeof(struct rk_pcie),
 };
@@ -18,6 +18,7 @@
 #include <scsi.h>
 #include <asm/io.h>
 #include <asm/dma-mapping.h>
+#include <asm/unaligned.h>
 #include <linux/bitops.h>
 #include <linux/delay.h>
 
@@ -55,6 +56,9 @@
 /* maximum bytes per request */
 #define UFS_MAX_BYTES	(128 * 256 * 1024)
 
+/* Smallest piece a read or write is split into to spread it over slots */
+#define UFS_MIN_SPLIT_BYTES	(64 * 1024)
+
 static inline bool ufshcd_is_hba_active(struct ufs_hba *hba);
 static inline void ufshcd_hba_stop(struct ufs_hba *hba);
 static int ufshcd_hba_enable(struct ufs_hba *hba);
@@ -598,27 +602,33 @@ static void ufshcd_host_memory_configure(struct ufs_hba *hba)
 	dma_addr_t cmd_desc_dma_addr;
 	u16 response_offset;
 	u16 prdt_offset;
+	int i;
 
-	utrdlp = hba->utrdl;
-	cmd_desc_dma_addr = (dma_addr_t)hba->ucdl;
+	response_offset = offsetof(struct utp_transfer_cmd_desc, response_upiu);
+	prdt_offset = offsetof(struct utp_transfer_cmd_desc, prd_table);
 
-	utrdlp->command_desc_base_addr_lo =
+	for (i = 0; i < hba->nutrs; i++) {
+		utrdlp = &hba->utrdl[i];
+		cmd_desc_dma_addr = (dma_addr_t)&hba->ucdl[i];
+
+		utrdlp->command_desc_base_addr_lo =
 				cpu_to_le32(lower_32_bits(cmd_desc_dma_addr));
-	utrdlp->command_desc_base_addr_hi =
+		utrdlp->command_desc_base_addr_hi =
 				cpu_to_le32(upper_32_bits(cmd_desc_dma_addr));
 
-	response_offset = offsetof(struct utp_transfer_cmd_desc, response_upiu);
-	prdt_offset = offsetof(struct utp_transfer_cmd_desc, prd_table);
-
-	utrdlp->response_upiu_offset = cpu_to_le16(response_offset >> 2);
-	utrdlp->prd_table_offset = cpu_to_le16(prdt_offset >> 2);
-	utrdlp->response_upiu_length = cpu_to_le16(ALIGNED_UPIU_SIZE >> 2);
+		utrdlp->response_upiu_offset =
+				cpu_to_le16(response_offset >> 2);
+		utrdlp->prd_table_offset = cpu_to_le16(prdt_offset >> 2);
+		utrdlp->response_upiu_length =
+				cpu_to_le16(ALIGNED_UPIU_SIZE >> 2);
+	}
 
-	hba->ucd_req_ptr = (struct utp_upiu_req *)hba->ucdl;
+	/* Device management commands always use slot TASK_TAG */
+	hba->ucd_req_ptr = (struct utp_upiu_req *)&hba->ucdl[TASK_TAG];
 	hba->ucd_rsp_ptr =
-		(struct utp_upiu_rsp *)&hba->ucdl->response_upiu;
+		(struct utp_upiu_rsp *)&hba->ucdl[TASK_TAG].response_upiu;
 	hba->ucd_prdt_ptr =
-		(struct ufshcd_sg_entry *)&hba->ucdl->prd_table;
+		(struct ufshcd_sg_entry *)&hba->ucdl[TASK_TAG].prd_table;
 }
 
 /**
@@ -626,19 +636,25 @@ static void ufshcd_host_memory_configure(struct ufs_hba *hba)
  */
 static int ufshcd_memory_alloc(struct ufs_hba *hba)
 {
-	/* Allocate one Transfer Request Descriptor
+	hba->nutrs = (hba->capabilities & MASK_TRANSFER_REQUESTS_SLOTS) + 1;
+
+	/* Allocate a Transfer Request Descriptor for each slot
 	 * Should be aligned to 1k boundary.
 	 */
-	hba->utrdl = memalign(1024, sizeof(struct utp_transfer_req_desc));
+	hba->utrdl = memalign(1024, hba->nutrs *
+			      sizeof(struct utp_transfer_req_desc));
 	if (!hba->utrdl) {
 		dev_err(hba->dev, "Transfer Descriptor memory allocation failed\n");
 		return -ENOMEM;
 	}
+	memset(hba->utrdl, 0, hba->nutrs *
+	       sizeof(struct utp_transfer_req_desc));
 
-	/* Allocate one Command Descriptor
+	/* Allocate a Command Descriptor for each slot
 	 * Should be aligned to 1k boundary.
 	 */
-	hba->ucdl = memalign(1024, sizeof(struct utp_transfer_cmd_desc));
+	hba->ucdl = memalign(1024, hba->nutrs *
+			     sizeof(struct utp_transfer_cmd_desc));
 	if (!hba->ucdl) {
 		dev_err(hba->dev, "Command descriptor memory allocation failed\n");
 		return -ENOMEM;
@@ -1379,29 +1395,31 @@ static int ufshcd_uic_change_pwr_mode(struct ufs_hba *hba, u8 mode)
 }
 
 static
-void ufshcd_prepare_utp_scsi_cmd_upiu(struct ufs_hba *hba,
-				      struct scsi_cmd *pccb, u32 upiu_flags)
+void ufshcd_prepare_utp_scsi_cmd_upiu(struct ufs_hba *hba, unsigned int tag,
+				      struct scsi_cmd *pccb, u32 upiu_flags,
+				      ulong datalen)
 {
-	struct utp_upiu_req *ucd_req_ptr = hba->ucd_req_ptr;
+	struct utp_upiu_req *ucd_req_ptr =
+		(struct utp_upiu_req *)&hba->ucdl[tag];
 	unsigned int cdb_len;
 
 	/* command descriptor fields */
 	ucd_req_ptr->header.dword_0 =
 			UPIU_HEADER_DWORD(UPIU_TRANSACTION_COMMAND, upiu_flags,
-					  pccb->lun, TASK_TAG);
+					  pccb->lun, tag);
 	ucd_req_ptr->header.dword_1 =
 			UPIU_HEADER_DWORD(UPIU_COMMAND_SET_TYPE_SCSI, 0, 0, 0);
 
 	/* Total EHS length and Data segment length will be zero */
 	ucd_req_ptr->header.dword_2 = 0;
 
-	ucd_req_ptr->sc.exp_data_transfer_len = cpu_to_be32(pccb->datalen);
+	ucd_req_ptr->sc.exp_data_transfer_len = cpu_to_be32(datalen);
 
 	cdb_len = min_t(unsigned short, pccb->cmdlen, UFS_CDB_SIZE);
 	memset(ucd_req_ptr->sc.cdb, 0, UFS_CDB_SIZE);
 	memcpy(ucd_req_ptr->sc.cdb, pccb->cmd, cdb_len);
 
-	memset(hba->ucd_rsp_ptr, 0, sizeof(struct utp_upiu_rsp));
+	memset(hba->ucdl[tag].response_upiu, 0, sizeof(struct utp_upiu_rsp));
 }
 
 static inline void prepare_prdt_desc(struct ufshcd_sg_entry *entry,
@@ -1412,13 +1430,12 @@ static inline void prepare_prdt_desc(struct ufshcd_sg_entry *entry,
 	entry->upper_addr = cpu_to_le32(upper_32_bits((unsigned long)buf));
 }
 
-static void prepare_prdt_table(struct ufs_hba *hba, struct scsi_cmd *pccb)
+static void prepare_prdt_table(struct ufs_hba *hba, unsigned int tag,
+			       u8 *buf, ulong datalen)
 {
-	struct utp_transfer_req_desc *req_desc = hba->utrdl;
-	struct ufshcd_sg_entry *prd_table = hba->ucd_prdt_ptr;
-	ulong datalen = pccb->datalen;
+	struct utp_transfer_req_desc *req_desc = &hba->utrdl[tag];
+	struct ufshcd_sg_entry *prd_table = hba->ucdl[tag].prd_table;
 	int table_length;
-	u8 *buf;
 	int i;
 
 	if (!datalen) {
@@ -1426,8 +1443,7 @@ static void prepare_prdt_table(struct ufs_hba *hba, struct scsi_cmd *pccb)
 		return;
 	}
 
-	table_length = DIV_ROUND_UP(pccb->datalen, MAX_PRDT_ENTRY);
-	buf = pccb->pdata;
+	table_length = DIV_ROUND_UP(datalen, MAX_PRDT_ENTRY);
 	i = table_length;
 	while (--i) {
 		prepare_prdt_desc(&prd_table[table_length - i - 1], buf,
@@ -1441,53 +1457,235 @@ static void prepare_prdt_table(struct ufs_hba *hba, struct scsi_cmd *pccb)
 	req_desc->prd_table_length = table_length;
 }
 
-static int ufs_scsi_exec(struct udevice *scsi_dev, struct scsi_cmd *pccb)
+/**
+ * ufs_scsi_get_rw() - find the LBA and length of a read or write command
+ *
+ * Only these commands can be split over several slots.
+ *
+ * @return true if @pccb is a READ(10), WRITE(10) or READ(16) that moves data
+ */
+static bool ufs_scsi_get_rw(struct scsi_cmd *pccb, u64 *lba, u32 *blocks)
 {
-	struct ufs_hba *hba = dev_get_uclass_priv(scsi_dev->parent);
-	struct utp_transfer_req_desc *req_desc = hba->utrdl;
+	const u8 *cdb = pccb->cmd;
+
+	switch (cdb[0]) {
+	case SCSI_READ10:
+	case SCSI_WRITE10:
+		*lba = get_unaligned_be32(&cdb[2]);
+		*blocks = get_unaligned_be16(&cdb[7]);
+		break;
+	case SCSI_READ16:
+		if (pccb->cmdlen != 16)
+			return false;
+		*lba = get_unaligned_be64(&cdb[2]);
+		*blocks = get_unaligned_be32(&cdb[11]);
+		break;
+	default:
+		return false;
+	}
+
+	return *blocks && pccb->datalen && !(pccb->datalen % *blocks);
+}
+
+static void ufs_scsi_set_rw(u8 *cdb, u64 lba, u32 blocks)
+{
+	if (cdb[0] == SCSI_READ16) {
+		put_unaligned_be64(lba, &cdb[2]);
+		put_unaligned_be32(blocks, &cdb[11]);
+	} else {
+		put_unaligned_be32(lba, &cdb[2]);
+		put_unaligned_be16(blocks, &cdb[7]);
+	}
+}
+
+/**
+ * ufs_scsi_slot_prepare() - set up a slot for (part of) a SCSI command
+ *
+ * @hba:	UFS host
+ * @tag:	Slot to use
+ * @pccb:	Command, with its CDB already adjusted for this part
+ * @buf:	Data for this part
+ * @datalen:	Length of @buf in bytes
+ */
+static void ufs_scsi_slot_prepare(struct ufs_hba *hba, unsigned int tag,
+				  struct scsi_cmd *pccb, u8 *buf, ulong datalen)
+{
+	struct utp_transfer_req_desc *req_desc = &hba->utrdl[tag];
+	ulong start = rounddown((ulong)buf, ARCH_DMA_MINALIGN);
+	ulong end = roundup((ulong)buf + datalen, ARCH_DMA_MINALIGN);
 	u32 upiu_flags;
-	int ocs, result = 0;
-	u8 scsi_status;
 
 	ufshcd_prepare_req_desc_hdr(req_desc, &upiu_flags, pccb->dma_dir);
-	ufshcd_prepare_utp_scsi_cmd_upiu(hba, pccb, upiu_flags);
-	prepare_prdt_table(hba, pccb);
+	ufshcd_prepare_utp_scsi_cmd_upiu(hba, tag, pccb, upiu_flags, datalen);
+	prepare_prdt_table(hba, tag, buf, datalen);
+
+	flush_dcache_range((ulong)&hba->ucdl[tag],
+			   (ulong)&hba->ucdl[tag + 1]);
+	/* Write back the data, and anything sharing its first/last line */
+	if (datalen)
+		flush_dcache_range(start, end);
+}
 
-	ufshcd_send_command(hba, TASK_TAG);
+/**
+ * ufs_scsi_slot_result() - check how the command in a slot completed
+ *
+ * @return 0 if it succeeded, -EINVAL otherwise
+ */
+static int ufs_scsi_slot_result(struct ufs_hba *hba, unsigned int tag)
+{
+	struct utp_upiu_rsp *rsp =
+		(struct utp_upiu_rsp *)hba->ucdl[tag].response_upiu;
+	int ocs, result;
+	u8 scsi_status;
 
-	ocs = ufshcd_get_tr_ocs(hba);
-	switch (ocs) {
-	case OCS_SUCCESS:
-		result = ufshcd_get_req_rsp(hba->ucd_rsp_ptr);
-		switch (result) {
-		case UPIU_TRANSACTION_RESPONSE:
-			result = ufshcd_get_rsp_upiu_result(hba->ucd_rsp_ptr);
+	ocs = le32_to_cpu(hba->utrdl[tag].header.dword_2) & MASK_OCS;
+	if (ocs != OCS_SUCCESS) {
+		dev_err(hba->dev, "OCS error from controller = %x\n", ocs);
+		return -EINVAL;
+	}
 
-			scsi_status = result & MASK_SCSI_STATUS;
-			if (scsi_status)
-				return -EINVAL;
+	result = ufshcd_get_req_rsp(rsp);
+	switch (result) {
+	case UPIU_TRANSACTION_RESPONSE:
+		result = ufshcd_get_rsp_upiu_result(rsp);
 
-			break;
-		case UPIU_TRANSACTION_REJECT_UPIU:
-			/* TODO: handle Reject UPIU Response */
-			dev_err(hba->dev,
-				"Reject UPIU not fully implemented\n");
-			return -EINVAL;
-		default:
-			dev_err(hba->dev,
-				"Unexpected request response code = %x\n",
-				result);
+		scsi_status = result & MASK_SCSI_STATUS;
+		if (scsi_status)
 			return -EINVAL;
-		}
+
 		break;
+	case UPIU_TRANSACTION_REJECT_UPIU:
+		/* TODO: handle Reject UPIU Response */
+		dev_err(hba->dev, "Reject UPIU not fully implemented\n");
+		return -EINVAL;
 	default:
-		dev_err(hba->dev, "OCS error from controller = %x\n", ocs);
+		dev_err(hba->dev, "Unexpected request response code = %x\n",
+			result);
 		return -EINVAL;
 	}
 
 	return 0;
 }
 
+/**
+ * ufs_scsi_run_slots() - run the commands set up in @slots and wait for them
+ *
+ * All of them are handed to the controller with one doorbell write. The
+ * doorbell register then tells which slots have completed, so there is no
+ * per-command interrupt status handshake; completions are checked once
+ * the whole batch is done. Descriptors of neighbouring slots share cache
+ * lines, which is why slots are not refilled while others are in flight.
+ *
+ * @return 0 if all commands succeeded, -ve on error
+ */
+static int ufs_scsi_run_slots(struct ufs_hba *hba, u32 slots)
+{
+	unsigned long start;
+	u32 intr_status, pending;
+	int tag, ret = 0;
+
+	flush_dcache_range((ulong)hba->utrdl,
+			   (ulong)&hba->utrdl[hba->nutrs]);
+
+	ufshcd_writel(hba, ufshcd_readl(hba, REG_INTERRUPT_STATUS),
+		      REG_INTERRUPT_STATUS);
+	ufshcd_writel(hba, slots, REG_UTP_TRANSFER_REQ_DOOR_BELL);
+
+	start = get_timer(0);
+	do {
+		pending = ufshcd_readl(hba, REG_UTP_TRANSFER_REQ_DOOR_BELL) &
+			  slots;
+		intr_status = ufshcd_readl(hba, REG_INTERRUPT_STATUS) &
+			      hba->intr_mask;
+
+		if (intr_status & UFSHCD_ERROR_MASK) {
+			dev_err(hba->dev, "Error in status:%08x\n",
+				intr_status);
+			ret = -EIO;
+			break;
+		}
+		if (get_timer(start) > QUERY_REQ_TIMEOUT) {
+			dev_err(hba->dev,
+				"Timedout waiting for UTP response\n");
+			ret = -ETIMEDOUT;
+			break;
+		}
+	} while (pending);
+
+	if (ret) {
+		/* Writing 0 to a slot's bit clears it */
+		ufshcd_writel(hba, ~pending, REG_UTP_TRANSFER_REQ_LIST_CLEAR);
+		return ret;
+	}
+
+	invalidate_dcache_range((ulong)hba->utrdl,
+				(ulong)&hba->utrdl[hba->nutrs]);
+	for (tag = 0; tag < hba->nutrs; tag++) {
+		if (!(slots & BIT(tag)))
+			continue;
+		invalidate_dcache_range((ulong)hba->ucdl[tag].response_upiu,
+					(ulong)hba->ucdl[tag].prd_table);
+		if (ufs_scsi_slot_result(hba, tag))
+			ret = -EINVAL;
+	}
+
+	return ret;
+}
+
+static int ufs_scsi_exec(struct udevice *scsi_dev, struct scsi_cmd *pccb)
+{
+	struct ufs_hba *hba = dev_get_uclass_priv(scsi_dev->parent);
+	struct scsi_cmd part = *pccb;
+	u8 *buf = pccb->pdata;
+	u64 lba;
+	u32 blocks, blksz, per_cmd, n;
+	u32 slots;
+	int tag, ret;
+
+	if (!ufs_scsi_get_rw(pccb, &lba, &blocks)) {
+		ufs_scsi_slot_prepare(hba, TASK_TAG, pccb, buf,
+				      pccb->datalen);
+		ret = ufs_scsi_run_slots(hba, BIT(TASK_TAG));
+		goto done;
+	}
+
+	/*
+	 * Split a large read or write evenly over all slots, so that the
+	 * device works on them in parallel, in pieces no larger than one
+	 * slot's PRDT can describe.
+	 */
+	blksz = pccb->datalen / blocks;
+	per_cmd = DIV_ROUND_UP(blocks, hba->nutrs);
+	per_cmd = max_t(u32, per_cmd, UFS_MIN_SPLIT_BYTES / blksz);
+	per_cmd = min_t(u32, per_cmd, UFS_MAX_BYTES / blksz);
+
+	ret = 0;
+	while (blocks && !ret) {
+		slots = 0;
+		for (tag = 0; tag < hba->nutrs && blocks; tag++) {
+			n = min(blocks, per_cmd);
+			ufs_scsi_set_rw(part.cmd, lba, n);
+			ufs_scsi_slot_prepare(hba, tag, &part, buf, n * blksz);
+			slots |= BIT(tag);
+
+			lba += n;
+			blocks -= n;
+			buf += n * blksz;
+		}
+		ret = ufs_scsi_run_slots(hba, slots);
+	}
+
+done:
+	if (pccb->dma_dir == DMA_FROM_DEVICE && pccb->datalen)
+		invalidate_dcache_range(rounddown((ulong)pccb->pdata,
+						  ARCH_DMA_MINALIGN),
+					roundup((ulong)pccb->pdata +
+						pccb->datalen,
+						ARCH_DMA_MINALIGN));
+
+	return ret;
+}
+
 static inline int ufshcd_read_desc(struct ufs_hba *hba, enum desc_idn desc_id,
 				   int desc_index, u8 *buf, u32 size)
 {
@@ -707,6 +707,8 @@ struct ufs_hba {
 	struct ufs_hba_ops	*ops;
 	struct ufs_desc_size	desc_size;
 	u32			capabilities;
+	/* Number of UTP transfer request slots */
+	int			nutrs;
 	u32			version;
 	u32			intr_mask;
 	u32			quirks;
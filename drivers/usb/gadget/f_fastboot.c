@@ -74,6 +74,9 @@ struct f_fastboot {
 	/* IN/OUT EP's and corresponding requests */
 	struct usb_ep *in_ep, *out_ep;
 	struct usb_request *in_req, *out_req;
+
+	/* buffer of out_req, which is pointed elsewhere during downloads */
+	void *out_buf;
 };
 
 static inline struct f_fastboot *func_to_fastboot(struct usb_function *f)
@@ -395,7 +398,7 @@ static void fastboot_disable(struct usb_function *f)
 	usb_ep_disable(f_fb->in_ep);
 
 	if (f_fb->out_req) {
-		free(f_fb->out_req->buf);
+		free(f_fb->out_buf);
 		usb_ep_free_request(f_fb->out_ep, f_fb->out_req);
 		f_fb->out_req = NULL;
 	}
@@ -452,6 +455,7 @@ static int fastboot_set_alt(struct usb_function *f,
 		goto err;
 	}
 	f_fb->out_req->complete = rx_handler_command;
+	f_fb->out_buf = f_fb->out_req->buf;
 
 	d = fb_ep_desc(gadget, &fs_ep_in, &hs_ep_in, &ss_ep_in,
 		       &ss_ep_in_comp_desc, f_fb->in_ep);
@@ -1539,7 +1543,7 @@ static void cb_getvar(struct usb_ep *ep, struct usb_request *req)
 	return;
 }
 
-static unsigned int rx_bytes_expected(struct usb_ep *ep)
+static unsigned int rx_bytes_expected(struct usb_ep *ep, unsigned int max)
 {
 	int rx_remain = download_size - download_bytes;
 	unsigned int rem;
@@ -1547,8 +1551,8 @@ static unsigned int rx_bytes_expected(struct usb_ep *ep)
 
 	if (rx_remain <= 0)
 		return 0;
-	else if (rx_remain > EP_BUFFER_SIZE)
-		return EP_BUFFER_SIZE;
+	else if (rx_remain > max)
+		return max;
 
 	/*
 	 * Some controllers e.g. DWC3 don't like OUT transfers to be
@@ -1563,6 +1567,29 @@ static unsigned int rx_bytes_expected(struct usb_ep *ep)
 	return rx_remain;
 }
 
+/*
+ * Download data is received straight into the download buffer, in
+ * requests of up to CONFIG_FASTBOOT_DL_CHUNK_SIZE bytes, instead of being
+ * copied out of the endpoint buffer 4 KiB at a time. The endpoint buffer
+ * is only used when the destination is not DMA aligned, or when the last
+ * request, rounded up to maxpacket, would run past the download buffer.
+ */
+static void rx_prepare_dl(struct usb_ep *ep, struct usb_request *req)
+{
+	void *dst = (void *)CONFIG_FASTBOOT_BUF_ADDR + download_bytes;
+	unsigned int length;
+
+	length = rx_bytes_expected(ep, CONFIG_FASTBOOT_DL_CHUNK_SIZE);
+	if (IS_ALIGNED((ulong)dst, ARCH_DMA_MINALIGN) &&
+	    download_bytes + length <= CONFIG_FASTBOOT_BUF_SIZE) {
+		req->buf = dst;
+	} else {
+		req->buf = fastboot_func->out_buf;
+		length = rx_bytes_expected(ep, EP_BUFFER_SIZE);
+	}
+	req->length = length;
+}
+
 #define BYTES_PER_DOT	0x20000
 static void rx_handler_dl_image(struct usb_ep *ep, struct usb_request *req)
 {
@@ -1580,8 +1607,9 @@ static void rx_handler_dl_image(struct usb_ep *ep, struct usb_request *req)
 	if (buffer_size < transfer_size)
 		transfer_size = buffer_size;
 
-	memcpy((void *)CONFIG_FASTBOOT_BUF_ADDR + download_bytes,
-	       buffer, transfer_size);
+	if (buffer == fastboot_func->out_buf)
+		memcpy((void *)CONFIG_FASTBOOT_BUF_ADDR + download_bytes,
+		       buffer, transfer_size);
 
 	pre_dot_num = download_bytes / BYTES_PER_DOT;
 	download_bytes += transfer_size;
@@ -1601,6 +1629,7 @@ static void rx_handler_dl_image(struct usb_ep *ep, struct usb_request *req)
 		 */
 		download_size = 0;
 		req->complete = rx_handler_command;
+		req->buf = fastboot_func->out_buf;
 		req->length = EP_BUFFER_SIZE;
 
 		strcpy(response, "OKAY");
@@ -1608,7 +1637,7 @@ static void rx_handler_dl_image(struct usb_ep *ep, struct usb_request *req)
 
 		printf("\ndownloading of %d bytes finished\n", download_bytes);
 	} else {
-		req->length = rx_bytes_expected(ep);
+		rx_prepare_dl(ep, req);
 	}
 
 	req->actual = 0;
@@ -1634,7 +1663,7 @@ static void cb_download(struct usb_ep *ep, struct usb_request *req)
 	} else {
 		sprintf(response, "DATA%08x", download_size);
 		req->complete = rx_handler_dl_image;
-		req->length = rx_bytes_expected(ep);
+		rx_prepare_dl(ep, req);
 	}
 
 	fastboot_tx_write_str(response);
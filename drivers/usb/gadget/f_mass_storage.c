@@ -658,6 +658,8 @@ static int sleep_thread(struct fsg_common *common)
 
 		if (++i == 20000) {
 			busy_indicator();
+			/* The host went quiet, write out buffered data */
+			rkusb_write_idle();
 			i = 0;
 			k++;
 		}
@@ -796,6 +796,19 @@ static int rkusb_cmd_process(struct fsg_common *common,
 		return RKUSB_RC_ERROR;
 	}
 
+	/*
+	 * Any command but a further write ends a run of buffered writes.
+	 * A failure to write them out fails this command.
+	 */
+	if (common->cmnd[0] != RKUSB_LBA_WRITE_10 &&
+	    common->cmnd[0] != SC_WRITE_10 &&
+	    common->cmnd[0] != SC_REQUEST_SENSE && rkusb_write_flush()) {
+		if (common->lun < common->nluns)
+			common->luns[common->lun].sense_data = SS_WRITE_ERROR;
+		*reply = -EIO;
+		return RKUSB_RC_ERROR;
+	}
+
 	switch (common->cmnd[0]) {
 	case RKUSB_TEST_UNIT_READY:
 		*reply = rkusb_do_test_unit_ready(common, bh);
@@ -910,6 +923,8 @@ int rkusb_do_check_parity(struct fsg_common *common)
 	if (common->cmnd[0] == SC_WRITE_10 && (usb_parity)) {
 		lba = get_unaligned_be32(&common->cmnd[2]);
 		len = common->data_size_from_cmnd >> 9;
+		if (rkusb_write_flush())
+			common->phase_error = 1;
 		rc = blk_dread(&ums[common->lun].block_dev, lba, len, usb_check_buffer);
 		parity = 0x000055aa;
 		for (i = 0; i < len * 128; i++)
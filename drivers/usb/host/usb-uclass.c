@@ -162,6 +162,24 @@ int usb_get_max_xfer_size(struct usb_device *udev, size_t *size)
 	return ops->get_max_xfer_size(bus, size);
 }
 
+int usb_bulk_batch(struct usb_device *udev, struct usb_bulk_xfer *xfers,
+		   int count)
+{
+	struct udevice *bus = udev->controller_dev;
+	struct dm_usb_ops *ops = usb_get_ops(bus);
+	int i;
+
+	if (!ops->bulk_batch)
+		return -ENOSYS;
+
+	for (i = 0; i < count; i++) {
+		xfers[i].actual = 0;
+		xfers[i].status = USB_ST_NOT_PROC;
+	}
+
+	return ops->bulk_batch(bus, udev, xfers, count);
+}
+
 int usb_stop(void)
 {
 	struct udevice *bus;
@@ -544,18 +544,61 @@ static void record_transfer_result(struct usb_device *udev,
 
 /**** Bulk and Control transfer methods ****/
 /**
- * Queues up the BULK Request
+ * Counts the TRBs needed for a bulk TD
+ *
+ * @param buffer	buffer of the TD
+ * @param length	length of the buffer
+ * @return number of TRBs
+ */
+static int xhci_bulk_num_trbs(void *buffer, int length)
+{
+	u64 val_64 = (uintptr_t)buffer;
+	int num_trbs = 0;
+	int running_total;
+
+	/*
+	 * How much data is (potentially) left before the 64KB boundary?
+	 * XHCI Spec puts restriction( TABLE 49 and 6.4.1 section of XHCI Spec)
+	 * that the buffer should not span 64KB boundary. if so
+	 * we send request in more than 1 TRB by chaining them.
+	 */
+	running_total = TRB_MAX_BUFF_SIZE -
+			(lower_32_bits(val_64) & (TRB_MAX_BUFF_SIZE - 1));
+	running_total &= TRB_MAX_BUFF_SIZE - 1;
+
+	/*
+	 * If there's some data on this 64KB chunk, or we have to send a
+	 * zero-length transfer, we need at least one TRB
+	 */
+	if (running_total != 0 || length == 0)
+		num_trbs++;
+
+	/* How many more 64KB chunks to transfer, how many more TRBs? */
+	while (running_total < length) {
+		num_trbs++;
+		running_total += TRB_MAX_BUFF_SIZE;
+	}
+
+	return num_trbs;
+}
+
+/**
+ * Queues up a BULK TD and rings the doorbell, without waiting for it
  *
  * @param udev		pointer to the USB device structure
  * @param pipe		contains the DIR_IN or OUT , devnum
  * @param length	length of the buffer
  * @param buffer	buffer to be read/written based on the request
- * @return returns 0 if successful else -1 on failure
+ * @param first		returns the first TRB of the TD
+ * @param last		returns the last TRB of the TD
+ * @return 0 if successful else error code on failure
  */
-int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
-			int length, void *buffer)
+static int xhci_queue_bulk_td(struct usb_device *udev, unsigned long pipe,
+			      int length, void *buffer,
+			      struct xhci_generic_trb **first,
+			      struct xhci_generic_trb **last)
 {
-	int num_trbs = 0;
+	int num_trbs;
 	struct xhci_generic_trb *start_trb;
 	bool first_trb = false;
 	int start_cycle;
@@ -567,7 +610,6 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 	struct xhci_virt_device *virt_dev;
 	struct xhci_ep_ctx *ep_ctx;
 	struct xhci_ring *ring;		/* EP transfer ring */
-	union xhci_trb *event;
 
 	int running_total, trb_buff_len;
 	unsigned int total_packet_count;
@@ -589,29 +631,9 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 	ep_ctx = xhci_get_ep_ctx(ctrl, virt_dev->out_ctx, ep_index);
 
 	ring = virt_dev->eps[ep_index].ring;
-	/*
-	 * How much data is (potentially) left before the 64KB boundary?
-	 * XHCI Spec puts restriction( TABLE 49 and 6.4.1 section of XHCI Spec)
-	 * that the buffer should not span 64KB boundary. if so
-	 * we send request in more than 1 TRB by chaining them.
-	 */
-	running_total = TRB_MAX_BUFF_SIZE -
-			(lower_32_bits(val_64) & (TRB_MAX_BUFF_SIZE - 1));
-	trb_buff_len = running_total;
-	running_total &= TRB_MAX_BUFF_SIZE - 1;
-
-	/*
-	 * If there's some data on this 64KB chunk, or we have to send a
-	 * zero-length transfer, we need at least one TRB
-	 */
-	if (running_total != 0 || length == 0)
-		num_trbs++;
-
-	/* How many more 64KB chunks to transfer, how many more TRBs? */
-	while (running_total < length) {
-		num_trbs++;
-		running_total += TRB_MAX_BUFF_SIZE;
-	}
+	num_trbs = xhci_bulk_num_trbs(buffer, length);
+	trb_buff_len = TRB_MAX_BUFF_SIZE -
+		       (lower_32_bits(val_64) & (TRB_MAX_BUFF_SIZE - 1));
 
 	/*
 	 * XXX: Calling routine prepare_ring() called in place of
@@ -699,7 +721,7 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 		trb_fields[2] = length_field;
 		trb_fields[3] = field | (TRB_NORMAL << TRB_TYPE_SHIFT);
 
-		queue_trb(ctrl, ring, (num_trbs > 1), trb_fields);
+		*last = queue_trb(ctrl, ring, (num_trbs > 1), trb_fields);
 
 		--num_trbs;
 
@@ -711,6 +733,34 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 	} while (running_total < length);
 
 	giveback_first_trb(udev, ep_index, start_cycle, start_trb);
+	*first = start_trb;
+
+	return 0;
+}
+
+/**
+ * Queues up the BULK Request
+ *
+ * @param udev		pointer to the USB device structure
+ * @param pipe		contains the DIR_IN or OUT , devnum
+ * @param length	length of the buffer
+ * @param buffer	buffer to be read/written based on the request
+ * @return returns 0 if successful else -1 on failure
+ */
+int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
+			int length, void *buffer)
+{
+	struct xhci_ctrl *ctrl = xhci_get_ctrl(udev);
+	struct xhci_generic_trb *first, *last;
+	int slot_id = udev->slot_id;
+	int ep_index = usb_pipe_ep_index(pipe);
+	union xhci_trb *event;
+	u32 field;
+	int ret;
+
+	ret = xhci_queue_bulk_td(udev, pipe, length, buffer, &first, &last);
+	if (ret < 0)
+		return ret;
 
 	event = xhci_wait_for_event(ctrl, TRB_TRANSFER);
 	if (!event) {
@@ -734,6 +784,256 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 	return (udev->status != USB_ST_NOT_PROC) ? 0 : -1;
 }
 
+/**
+ * Recovers a halted endpoint and throws away all unprocessed TRBs, like
+ * abort_td() does for a running one.
+ *
+ * @param udev		pointer to the USB device structure
+ * @param ep_index	index of the endpoint
+ * @return none
+ */
+static void reset_halted_ep(struct usb_device *udev, int ep_index)
+{
+	struct xhci_ctrl *ctrl = xhci_get_ctrl(udev);
+	struct xhci_ring *ring =  ctrl->devs[udev->slot_id]->eps[ep_index].ring;
+	union xhci_trb *event;
+
+	xhci_queue_command(ctrl, NULL, udev->slot_id, ep_index, TRB_RESET_EP);
+	event = xhci_wait_for_event(ctrl, TRB_COMPLETION);
+	BUG_ON(TRB_TO_SLOT_ID(le32_to_cpu(event->event_cmd.flags))
+		!= udev->slot_id || GET_COMP_CODE(le32_to_cpu(
+		event->event_cmd.status)) != COMP_SUCCESS);
+	xhci_acknowledge_event(ctrl);
+
+	xhci_queue_command(ctrl, (void *)((uintptr_t)ring->enqueue |
+		ring->cycle_state), udev->slot_id, ep_index, TRB_SET_DEQ);
+	event = xhci_wait_for_event(ctrl, TRB_COMPLETION);
+	BUG_ON(TRB_TO_SLOT_ID(le32_to_cpu(event->event_cmd.flags))
+		!= udev->slot_id || GET_COMP_CODE(le32_to_cpu(
+		event->event_cmd.status)) != COMP_SUCCESS);
+	xhci_acknowledge_event(ctrl);
+}
+
+/* Is @trb part of the TD from @first to @last, which may wrap around? */
+static bool trb_in_td(struct xhci_generic_trb *trb,
+		      struct xhci_generic_trb *first,
+		      struct xhci_generic_trb *last)
+{
+	if (first <= last)
+		return trb >= first && trb <= last;
+
+	return trb >= first || trb <= last;
+}
+
+/* How long TDs on endpoints that did not fail may take to finish */
+#define XHCI_BULK_DRAIN_MS	100
+
+/**
+ * Records the transfer event at the event ring dequeue pointer
+ *
+ * @param udev		pointer to the USB device structure
+ * @param event		transfer event to record and acknowledge
+ * @param xfers		requests of the batch
+ * @param count		number of requests queued
+ * @param first		first TRB of each request's TD
+ * @param last		last TRB of each request's TD
+ * @return index of the request that completed, -1 if there is none
+ */
+static int xhci_bulk_batch_event(struct usb_device *udev,
+				 union xhci_trb *event,
+				 struct usb_bulk_xfer *xfers, int count,
+				 struct xhci_generic_trb **first,
+				 struct xhci_generic_trb **last)
+{
+	struct xhci_ctrl *ctrl = xhci_get_ctrl(udev);
+	struct xhci_generic_trb *trb;
+	int i, ep_index;
+	u32 field;
+
+	field = le32_to_cpu(event->trans_event.flags);
+	BUG_ON(TRB_TO_SLOT_ID(field) != udev->slot_id);
+
+	ep_index = TRB_TO_EP_INDEX(field);
+	trb = (struct xhci_generic_trb *)(uintptr_t)
+		le64_to_cpu(event->trans_event.buffer);
+	for (i = 0; i < count; i++) {
+		if (usb_pipe_ep_index(xfers[i].pipe) == ep_index &&
+		    trb_in_td(trb, first[i], last[i]))
+			break;
+	}
+
+	/* Some hosts report a short TD twice, drop the second one */
+	if (i == count || xfers[i].status != USB_ST_NOT_PROC) {
+		xhci_acknowledge_event(ctrl);
+		return -1;
+	}
+
+	record_transfer_result(udev, event, xfers[i].length);
+	xhci_acknowledge_event(ctrl);
+	xhci_inval_cache((uintptr_t)xfers[i].buffer, xfers[i].length);
+	xfers[i].actual = udev->act_len;
+	xfers[i].status = udev->status;
+
+	return i;
+}
+
+/* Is a request still queued on an endpoint none of whose TDs failed? */
+static bool xhci_bulk_batch_busy(struct usb_bulk_xfer *xfers, int count)
+{
+	int i, j;
+
+	for (i = 0; i < count; i++) {
+		if (xfers[i].status != USB_ST_NOT_PROC)
+			continue;
+		for (j = 0; j < count; j++) {
+			if (usb_pipe_ep_index(xfers[j].pipe) ==
+			    usb_pipe_ep_index(xfers[i].pipe) &&
+			    xfers[j].status != USB_ST_NOT_PROC &&
+			    xfers[j].status)
+				break;
+		}
+		if (j == count)
+			return true;
+	}
+
+	return false;
+}
+
+/**
+ * Collects the TDs that complete after another one of the batch failed
+ *
+ * A mass storage device that STALLs bulk-out in the data phase sends its
+ * CSW right away, into the TD already waiting on bulk-in. Its event must
+ * be consumed here, or stopping the endpoint would mistake it for the
+ * stop event and the CSW would be lost.
+ *
+ * @param udev		pointer to the USB device structure
+ * @param xfers		requests of the batch
+ * @param count		number of requests queued
+ * @param first		first TRB of each request's TD
+ * @param last		last TRB of each request's TD
+ */
+static void xhci_bulk_batch_drain(struct usb_device *udev,
+				  struct usb_bulk_xfer *xfers, int count,
+				  struct xhci_generic_trb **first,
+				  struct xhci_generic_trb **last)
+{
+	struct xhci_ctrl *ctrl = xhci_get_ctrl(udev);
+	union xhci_trb *event;
+	ulong start = get_timer(0);
+
+	while (xhci_bulk_batch_busy(xfers, count) &&
+	       get_timer(start) < XHCI_BULK_DRAIN_MS) {
+		if (!event_ready(ctrl))
+			continue;
+
+		event = ctrl->event_ring->dequeue;
+		if (TRB_FIELD_TO_TYPE(le32_to_cpu(event->event_cmd.flags)) !=
+		    TRB_TRANSFER)
+			break;
+		xhci_bulk_batch_event(udev, event, xfers, count, first, last);
+	}
+}
+
+/**
+ * Queues up several BULK Requests before waiting for any of them
+ *
+ * Each request becomes a TD of its own and the doorbell is rung as soon
+ * as it is queued, so the device finds the next TD ready when it is done
+ * with one. TDs on different endpoints may complete in any order.
+ *
+ * @param udev		pointer to the USB device structure
+ * @param xfers		requests to queue, status and length are returned here
+ * @param count		number of requests, at most XHCI_BULK_BATCH_MAX
+ * @return 0 if all requests completed, else error code on failure
+ */
+int xhci_bulk_batch(struct usb_device *udev, struct usb_bulk_xfer *xfers,
+		    int count)
+{
+	struct xhci_ctrl *ctrl = xhci_get_ctrl(udev);
+	struct xhci_generic_trb *first[XHCI_BULK_BATCH_MAX];
+	struct xhci_generic_trb *last[XHCI_BULK_BATCH_MAX];
+	int ring_trbs[MAX_EP_CTX_NUM] = { 0 };
+	union xhci_trb *event;
+	int i, ep_index, queued, pending;
+	int ret = 0;
+
+	if (count > XHCI_BULK_BATCH_MAX)
+		return -E2BIG;
+
+	/* Nothing is dequeued until all TDs are done, they must all fit */
+	for (i = 0; i < count; i++) {
+		if (usb_pipetype(xfers[i].pipe) != PIPE_BULK)
+			return -EINVAL;
+		ep_index = usb_pipe_ep_index(xfers[i].pipe);
+		ring_trbs[ep_index] += xhci_bulk_num_trbs(xfers[i].buffer,
+							  xfers[i].length);
+		if (ring_trbs[ep_index] > TRBS_PER_SEGMENT - 2)
+			return -E2BIG;
+	}
+
+	for (queued = 0; queued < count; queued++) {
+		ret = xhci_queue_bulk_td(udev, xfers[queued].pipe,
+					 xfers[queued].length,
+					 xfers[queued].buffer,
+					 &first[queued], &last[queued]);
+		if (ret < 0)
+			goto abort;
+	}
+
+	for (pending = count; pending; ) {
+		event = xhci_wait_for_event(ctrl, TRB_TRANSFER);
+		if (!event) {
+			debug("XHCI bulk batch timed out, aborting...\n");
+			ret = -ETIMEDOUT;
+			goto abort;
+		}
+
+		i = xhci_bulk_batch_event(udev, event, xfers, count, first,
+					  last);
+		if (i < 0)
+			continue;
+		pending--;
+
+		if (xfers[i].status) {
+			ret = -EIO;
+			goto abort;
+		}
+	}
+
+	return 0;
+
+abort:
+	xhci_bulk_batch_drain(udev, xfers, queued, first, last);
+
+	/*
+	 * A failed TD halts its endpoint, others are merely stopped. Only
+	 * endpoints with TDs still queued need either.
+	 */
+	for (ep_index = 0; ep_index < MAX_EP_CTX_NUM; ep_index++) {
+		bool halted = false, busy = false;
+
+		for (i = 0; i < queued; i++) {
+			if (usb_pipe_ep_index(xfers[i].pipe) != ep_index)
+				continue;
+			if (xfers[i].status == USB_ST_NOT_PROC)
+				busy = true;
+			else if (xfers[i].status)
+				halted = true;
+		}
+
+		if (halted)
+			reset_halted_ep(udev, ep_index);
+		else if (busy)
+			abort_td(udev, ep_index);
+	}
+
+	if (ret == -ETIMEDOUT)
+		udev->status = USB_ST_NAK_REC;
+
+	return ret;
+}
+
 /**
  * Queues up the Control Transfer Request
  *
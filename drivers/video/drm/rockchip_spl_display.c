@@ -193,7 +193,7 @@ struct base2_disp_info *rockchip_get_disp_info(int type, int id)
 	ulong ret;
 
 	/* make sure the baseparameter is ready */
-	ret = mpb_post(6);
+	ret = mpb_post(MPB_POST_BASEPARAMETER);
 	printf("SPL read baseparameter %s\n", ret < 0 ? "failed" : "success");
 	memcpy(&base_parameter, bp_addr, sizeof(base_parameter));
 #endif
@@ -54,6 +54,27 @@ int ext4fs_devread(lbaint_t sector, int byte_offset, int byte_len,
 			  byte_len, buffer);
 }
 
+int ext4fs_devread_segs(struct blk_seg *segs, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		if (segs[i].start + segs[i].blkcnt > part_info->size) {
+			printf("%s read outside partition " LBAFU "\n",
+			       __func__, segs[i].start);
+			return 0;
+		}
+		segs[i].start += part_info->start;
+	}
+
+	if (blk_dread_segs(get_fs()->dev_desc, segs, count)) {
+		printf(" ** %s read error **\n", __func__);
+		return 0;
+	}
+
+	return 1;
+}
+
 int ext4_read_superblock(char *buffer)
 {
 	struct ext_filesystem *fs = get_fs();
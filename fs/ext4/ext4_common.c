@@ -1615,7 +1615,17 @@ int ext4fs_read_inode(struct ext2_data *data, int ino, struct ext2_inode *inode)
 	return 1;
 }
 
-long int read_allocated_block(struct ext2_inode *inode, int fileblock)
+/**
+ * read_allocated_run() - map a file block and the run following it
+ * @inode:	inode of the file
+ * @fileblock:	file block to map
+ * @count:	set to the number of blocks, starting at @fileblock, that
+ *		are contiguous on the device, or that are all holes
+ *
+ * Return:	device block of @fileblock, 0 for a hole, negative on error
+ */
+long int read_allocated_run(struct ext2_inode *inode, int fileblock,
+			    int *count)
 {
 	long int blknr;
 	int blksz;
@@ -1629,6 +1639,7 @@ long int read_allocated_block(struct ext2_inode *inode, int fileblock)
 	blksz = EXT2_BLOCK_SIZE(ext4fs_root);
 	log2_blksz = LOG2_BLOCK_SIZE(ext4fs_root)
 		- get_fs()->dev_desc->log2blksz;
+	*count = 1;
 
 	if (le32_to_cpu(inode->flags) & EXT4_EXTENTS_FL) {
 		long int startblock, endblock;
@@ -1657,6 +1668,7 @@ long int read_allocated_block(struct ext2_inode *inode, int fileblock)
 
 			if (startblock > fileblock) {
 				/* Sparse file */
+				*count = startblock - fileblock;
 				free(buf);
 				return 0;
 
@@ -1664,6 +1676,7 @@ long int read_allocated_block(struct ext2_inode *inode, int fileblock)
 				start = le16_to_cpu(extent[i].ee_start_hi);
 				start = (start << 32) +
 					le32_to_cpu(extent[i].ee_start_lo);
+				*count = endblock - fileblock;
 				free(buf);
 				return (fileblock - startblock) + start;
 			}
@@ -1958,6 +1971,73 @@ long int read_allocated_block(struct ext2_inode *inode, int fileblock)
 	return blknr;
 }
 
+long int read_allocated_block(struct ext2_inode *inode, int fileblock)
+{
+	int count;
+
+	return read_allocated_run(inode, fileblock, &count);
+}
+
+/*
+ * Last directory block read by ext4fs_iterate_dir(). Path lookups walk
+ * the same directories over and over; the block stays valid until the
+ * device is written or the filesystem is closed.
+ */
+static char *ext4fs_dirblk;
+static int ext4fs_dirblk_ino = -1;
+static unsigned int ext4fs_dirblk_pos;
+static unsigned int ext4fs_dirblk_len;
+static u32 ext4fs_dirblk_gen;
+
+static void ext4fs_dirblk_free(void)
+{
+	free(ext4fs_dirblk);
+	ext4fs_dirblk = NULL;
+	ext4fs_dirblk_ino = -1;
+}
+
+/*
+ * Set @blkp to the directory block holding byte @fpos of @diro, @off to
+ * the offset of @fpos and @len to the valid length in the block.
+ * Returns 0, -ENOMEM or -EIO.
+ */
+static int ext4fs_read_dirblk(struct ext2fs_node *diro, unsigned int fpos,
+			      char **blkp, unsigned int *off,
+			      unsigned int *len)
+{
+	struct blk_desc *dev_desc = get_fs()->dev_desc;
+	unsigned int blksz = EXT2_BLOCK_SIZE(diro->data);
+	unsigned int size = le32_to_cpu(diro->inode.size);
+	unsigned int pos = fpos - fpos % blksz;
+	loff_t actread;
+
+	if (!ext4fs_dirblk) {
+		ext4fs_dirblk = malloc(blksz);
+		if (!ext4fs_dirblk)
+			return -ENOMEM;
+		ext4fs_dirblk_ino = -1;
+	}
+
+	if (ext4fs_dirblk_ino != diro->ino || ext4fs_dirblk_pos != pos ||
+	    ext4fs_dirblk_gen != dev_desc->write_gen) {
+		ext4fs_dirblk_ino = -1;
+		ext4fs_dirblk_len = min(blksz, size - pos);
+		if (ext4fs_read_file(diro, pos, ext4fs_dirblk_len,
+				     ext4fs_dirblk, &actread) < 0 ||
+		    actread != ext4fs_dirblk_len)
+			return -EIO;
+		ext4fs_dirblk_ino = diro->ino;
+		ext4fs_dirblk_pos = pos;
+		ext4fs_dirblk_gen = dev_desc->write_gen;
+	}
+
+	*blkp = ext4fs_dirblk;
+	*off = fpos - pos;
+	*len = ext4fs_dirblk_len;
+
+	return 0;
+}
+
 /**
  * ext4fs_reinit_global() - Reinitialize values of ext4 write implementation's
  *			    global pointers
@@ -1990,6 +2070,7 @@ void ext4fs_reinit_global(void)
 		ext4fs_indir3_size = 0;
 		ext4fs_indir3_blkno = -1;
 	}
+	ext4fs_dirblk_free();
 }
 void ext4fs_close(void)
 {
@@ -2010,7 +2091,6 @@ int ext4fs_iterate_dir(struct ext2fs_node *dir, char *name,
 {
 	unsigned int fpos = 0;
 	int status;
-	loff_t actread;
 	struct ext2fs_node *diro = (struct ext2fs_node *) dir;
 
 #ifdef DEBUG
@@ -2025,14 +2105,20 @@ int ext4fs_iterate_dir(struct ext2fs_node *dir, char *name,
 	/* Search the file.  */
 	while (fpos < le32_to_cpu(diro->inode.size)) {
 		struct ext2_dirent dirent;
+		unsigned int off, len;
+		char *blk;
 
-		status = ext4fs_read_file(diro, fpos,
-					   sizeof(struct ext2_dirent),
-					   (char *)&dirent, &actread);
-		if (status < 0)
+		/* Entries never cross a block, so parse them in place */
+		if (ext4fs_read_dirblk(diro, fpos, &blk, &off, &len))
 			return 0;
 
-		if (dirent.direntlen == 0) {
+		if (off + sizeof(struct ext2_dirent) > len)
+			dirent.direntlen = 0;
+		else
+			memcpy(&dirent, blk + off, sizeof(struct ext2_dirent));
+
+		if (dirent.direntlen == 0 || off + sizeof(struct ext2_dirent) +
+		    dirent.namelen > len) {
 			printf("Failed to iterate over directory %s\n", name);
 			return 0;
 		}
@@ -2042,13 +2128,8 @@ int ext4fs_iterate_dir(struct ext2fs_node *dir, char *name,
 			struct ext2fs_node *fdiro;
 			int type = FILETYPE_UNKNOWN;
 
-			status = ext4fs_read_file(diro,
-						  fpos +
-						  sizeof(struct ext2_dirent),
-						  dirent.namelen, filename,
-						  &actread);
-			if (status < 0)
-				return 0;
+			memcpy(filename, blk + off + sizeof(struct ext2_dirent),
+			       dirent.namelen);
 
 			fdiro = zalloc(sizeof(struct ext2fs_node));
 			if (!fdiro)
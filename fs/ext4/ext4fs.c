@@ -41,6 +41,49 @@ void ext4fs_free_node(struct ext2fs_node *node, struct ext2fs_node *currroot)
 		free(node);
 }
 
+/* Whole-sector runs of a file are read in batches of this many */
+#define EXT4_READ_SEGS	32
+
+struct ext4_read_queue {
+	struct blk_seg segs[EXT4_READ_SEGS];
+	int count;
+};
+
+static int ext4fs_flush_reads(struct ext4_read_queue *q)
+{
+	int status = 1;
+
+	if (q->count)
+		status = ext4fs_devread_segs(q->segs, q->count);
+	q->count = 0;
+
+	return status;
+}
+
+/*
+ * Runs that do not depend on each other are queued so that devices able
+ * to keep several commands in flight get the whole set at once. Partial
+ * sectors still go through the bounce buffer in ext4fs_devread().
+ */
+static int ext4fs_queue_read(struct ext4_read_queue *q, lbaint_t sector,
+			     int skipfirst, int len, char *buf)
+{
+	struct blk_desc *blk = get_fs()->dev_desc;
+	struct blk_seg *seg;
+
+	if (skipfirst || (len & (blk->blksz - 1)))
+		return ext4fs_devread(sector, skipfirst, len, buf);
+
+	seg = &q->segs[q->count++];
+	seg->start = sector;
+	seg->blkcnt = len >> blk->log2blksz;
+	seg->buffer = buf;
+	if (q->count == EXT4_READ_SEGS)
+		return ext4fs_flush_reads(q);
+
+	return 1;
+}
+
 /*
  * Taken from openmoko-kernel mailing list: By Andy green
  * Optimized read file API : collects and defers contiguous sector
@@ -62,6 +105,9 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 	lbaint_t delayed_skipfirst = 0;
 	lbaint_t delayed_next = 0;
 	char *delayed_buf = NULL;
+	struct ext4_read_queue queue = { .count = 0 };
+	long int run_blknr = 0;
+	int run_left = 0;
 	short status;
 
 	if (blocksize <= 0)
@@ -78,9 +124,18 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 		int blockoff = pos - (blocksize * i);
 		int blockend = blocksize;
 		int skipfirst = 0;
-		blknr = read_allocated_block(&(node->inode), i);
-		if (blknr < 0)
-			return -1;
+
+		/* Map a whole extent at a time, not every block on its own */
+		if (!run_left) {
+			run_blknr = read_allocated_run(&node->inode, i,
+						       &run_left);
+			if (run_blknr < 0)
+				return -1;
+		}
+		blknr = run_blknr;
+		if (run_blknr)
+			run_blknr++;
+		run_left--;
 
 		blknr = blknr << log2_fs_blocksize;
 
@@ -106,7 +161,8 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 					delayed_extent += blockend;
 					delayed_next += blockend >> log2blksz;
 				} else {	/* spill */
-					status = ext4fs_devread(delayed_start,
+					status = ext4fs_queue_read(&queue,
+							delayed_start,
 							delayed_skipfirst,
 							delayed_extent,
 							delayed_buf);
@@ -133,10 +189,11 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 			int n;
 			if (previous_block_number != -1) {
 				/* spill */
-				status = ext4fs_devread(delayed_start,
-							delayed_skipfirst,
-							delayed_extent,
-							delayed_buf);
+				status = ext4fs_queue_read(&queue,
+							   delayed_start,
+							   delayed_skipfirst,
+							   delayed_extent,
+							   delayed_buf);
 				if (status == 0)
 					return -1;
 				previous_block_number = -1;
@@ -151,13 +208,15 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 	}
 	if (previous_block_number != -1) {
 		/* spill */
-		status = ext4fs_devread(delayed_start,
-					delayed_skipfirst, delayed_extent,
-					delayed_buf);
+		status = ext4fs_queue_read(&queue, delayed_start,
+					   delayed_skipfirst, delayed_extent,
+					   delayed_buf);
 		if (status == 0)
 			return -1;
 		previous_block_number = -1;
 	}
+	if (!ext4fs_flush_reads(&queue))
+		return -1;
 
 	*actread  = len;
 	return 0;
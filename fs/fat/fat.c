@@ -12,6 +12,7 @@
 #include <common.h>
 #include <blk.h>
 #include <config.h>
+#include <div64.h>
 #include <exports.h>
 #include <fat.h>
 #include <fs.h>
@@ -307,6 +308,88 @@ get_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer, unsigned long size)
 	return 0;
 }
 
+/*
+ * Cluster chain of the file read last, as runs of contiguous clusters.
+ * It is mapped once and then used for every read of the file, which
+ * would otherwise walk the FAT from the first cluster each time. A
+ * write to the device, a re-probe or a hardware partition switch drops
+ * it.
+ */
+struct fat_run {
+	__u32	clust;		/* first cluster of the run */
+	__u32	count;		/* number of clusters */
+};
+
+static struct {
+	struct blk_desc	*dev;
+	lbaint_t	part_start;
+	u32		write_gen;
+	__u32		start;		/* first cluster of the file */
+	__u32		nclust;		/* clusters mapped */
+	int		nruns;
+	int		size;		/* runs allocated */
+	struct fat_run	*runs;
+} fat_chain;
+
+/*
+ * Map the first 'nclust' clusters of the chain starting at 'start'.
+ * Return the number of clusters mapped, which is less than 'nclust' if
+ * the chain ends early, or -1 on allocation failure.
+ */
+static int fat_map_chain(fsdata *mydata, __u32 start, __u32 nclust)
+{
+	struct fat_run *run;
+	__u32 clust = start;
+
+	if (fat_chain.dev == cur_dev &&
+	    fat_chain.part_start == cur_part_info.start &&
+	    fat_chain.write_gen == cur_dev->write_gen &&
+	    fat_chain.start == start && fat_chain.nclust >= nclust)
+		return nclust;
+
+	fat_chain.dev = NULL;
+	fat_chain.nruns = 0;
+	fat_chain.nclust = 0;
+
+	while (fat_chain.nclust < nclust) {
+		if (CHECK_CLUST(clust, mydata->fatsize)) {
+			debug("curclust: 0x%x\n", clust);
+			break;
+		}
+
+		run = fat_chain.nruns ? &fat_chain.runs[fat_chain.nruns - 1] :
+			NULL;
+		if (run && run->clust + run->count == clust) {
+			run->count++;
+		} else {
+			if (fat_chain.nruns == fat_chain.size) {
+				int size = fat_chain.size ? fat_chain.size * 2 :
+					   16;
+
+				run = realloc(fat_chain.runs,
+					      size * sizeof(*run));
+				if (!run)
+					return -1;
+				fat_chain.runs = run;
+				fat_chain.size = size;
+			}
+			run = &fat_chain.runs[fat_chain.nruns++];
+			run->clust = clust;
+			run->count = 1;
+		}
+
+		if (++fat_chain.nclust < nclust)
+			clust = get_fatent(mydata, clust);
+	}
+
+	fat_chain.dev = cur_dev;
+	fat_chain.part_start = cur_part_info.start;
+	fat_chain.write_gen = cur_dev->write_gen;
+	fat_chain.start = start;
+
+	return fat_chain.nclust;
+}
+
 /*
  * Read at most 'maxsize' bytes from 'pos' in the file associated with 'dentptr'
  * into 'buffer'.
@@ -320,9 +403,10 @@ static int get_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos,
 {
 	loff_t filesize = FAT2CPU32(dentptr->size);
 	unsigned int bytesperclust = mydata->clust_size * mydata->sect_size;
-	__u32 curclust = START(dentptr);
-	__u32 endclust, newclust;
-	loff_t actsize;
+	struct fat_run *run;
+	__u32 idx, nclust;
+	loff_t actsize, offset;
+	int mapped;
 
 	*gotsize = 0;
 	debug("Filesize: %llu bytes\n", filesize);
@@ -337,92 +421,62 @@ static int get_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos,
 
 	debug("%llu bytes\n", filesize);
 
-	actsize = bytesperclust;
-
-	/* go to cluster at pos */
-	while (actsize <= pos) {
-		curclust = get_fatent(mydata, curclust);
-		if (CHECK_CLUST(curclust, mydata->fatsize)) {
-			debug("curclust: 0x%x\n", curclust);
-			debug("Invalid FAT entry\n");
+	nclust = lldiv(filesize + bytesperclust - 1, bytesperclust);
+	mapped = fat_map_chain(mydata, START(dentptr), nclust);
+	if (mapped < 0) {
+		printf("Error mapping cluster chain\n");
+		return -1;
+	}
+	if (mapped < nclust) {
+		/* Read up to the broken FAT entry */
+		debug("Invalid FAT entry\n");
+		filesize = min(filesize, (loff_t)mapped * bytesperclust);
+		if (pos >= filesize)
 			return 0;
-		}
-		actsize += bytesperclust;
 	}
 
-	/* actsize > pos */
-	actsize -= bytesperclust;
-	filesize -= actsize;
-	pos -= actsize;
-
-	/* align to beginning of next cluster if any */
-	if (pos) {
-		actsize = min(filesize, (loff_t)bytesperclust);
-		if (get_cluster(mydata, curclust, get_contents_vfatname_block,
-				(int)actsize) != 0) {
+	/* find the run and the cluster in it holding pos */
+	idx = lldiv(pos, bytesperclust);
+	offset = pos - (loff_t)idx * bytesperclust;
+	for (run = fat_chain.runs; idx >= run->count; run++)
+		idx -= run->count;
+
+	/* read a partial first cluster through the bounce buffer */
+	if (offset) {
+		actsize = min(filesize - (pos - offset), (loff_t)bytesperclust);
+		if (get_cluster(mydata, run->clust + idx,
+				get_contents_vfatname_block, actsize) != 0) {
 			printf("Error reading cluster\n");
 			return -1;
 		}
-		filesize -= actsize;
-		actsize -= pos;
-		memcpy(buffer, get_contents_vfatname_block + pos, actsize);
+		actsize -= offset;
+		memcpy(buffer, get_contents_vfatname_block + offset, actsize);
 		*gotsize += actsize;
-		if (!filesize)
-			return 0;
 		buffer += actsize;
-
-		curclust = get_fatent(mydata, curclust);
-		if (CHECK_CLUST(curclust, mydata->fatsize)) {
-			debug("curclust: 0x%x\n", curclust);
-			debug("Invalid FAT entry\n");
-			return 0;
+		pos += actsize;
+		if (++idx == run->count) {
+			run++;
+			idx = 0;
 		}
 	}
 
-	actsize = bytesperclust;
-	endclust = curclust;
-
-	do {
-		/* search for consecutive clusters */
-		while (actsize < filesize) {
-			newclust = get_fatent(mydata, endclust);
-			if ((newclust - 1) != endclust)
-				goto getit;
-			if (CHECK_CLUST(newclust, mydata->fatsize)) {
-				debug("curclust: 0x%x\n", newclust);
-				debug("Invalid FAT entry\n");
-				return 0;
-			}
-			endclust = newclust;
-			actsize += bytesperclust;
-		}
-
-		/* get remaining bytes */
-		actsize = filesize;
-		if (get_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
+	/* then one read per run of contiguous clusters */
+	while (pos < filesize) {
+		actsize = min(filesize - pos,
+			      (loff_t)(run->count - idx) * bytesperclust);
+		if (get_cluster(mydata, run->clust + idx, buffer,
+				actsize) != 0) {
 			printf("Error reading cluster\n");
 			return -1;
 		}
 		*gotsize += actsize;
-		return 0;
-getit:
-		if (get_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
-			printf("Error reading cluster\n");
-			return -1;
-		}
-		*gotsize += (int)actsize;
-		filesize -= actsize;
 		buffer += actsize;
+		pos += actsize;
+		run++;
+		idx = 0;
+	}
 
-		curclust = get_fatent(mydata, endclust);
-		if (CHECK_CLUST(curclust, mydata->fatsize)) {
-			debug("curclust: 0x%x\n", curclust);
-			printf("Invalid FAT entry\n");
-			return 0;
-		}
-		actsize = bytesperclust;
-		endclust = curclust;
-	} while (1);
+	return 0;
 }
 
 /*
@@ -969,6 +1023,60 @@ static int fat_itr_resolve(fat_itr *itr, const char *path, unsigned type)
 	return -ENOENT;
 }
 
+/*
+ * Directory entries of the files resolved last. Boot scripts tend to
+ * check, size and load the same file in a row; each of those would
+ * otherwise scan the directories from the root again.
+ */
+#define FAT_DENT_CACHE_SIZE	4
+#define FAT_DENT_CACHE_PATH	128
+
+static struct {
+	struct blk_desc	*dev;
+	lbaint_t	part_start;
+	u32		write_gen;
+	char		path[FAT_DENT_CACHE_PATH];
+	dir_entry	dent;
+} fat_dent_cache[FAT_DENT_CACHE_SIZE];
+static int fat_dent_cache_next;
+
+/*
+ * Resolve the regular file 'path' like fat_itr_resolve() and copy its
+ * directory entry to 'dent'.
+ */
+static int fat_resolve_file(fat_itr *itr, const char *path, dir_entry *dent)
+{
+	int i, ret;
+
+	for (i = 0; i < FAT_DENT_CACHE_SIZE; i++) {
+		if (fat_dent_cache[i].dev == cur_dev &&
+		    fat_dent_cache[i].part_start == cur_part_info.start &&
+		    fat_dent_cache[i].write_gen == cur_dev->write_gen &&
+		    !strcmp(fat_dent_cache[i].path, path)) {
+			*dent = fat_dent_cache[i].dent;
+			return 0;
+		}
+	}
+
+	ret = fat_itr_resolve(itr, path, TYPE_FILE);
+	if (ret)
+		return ret;
+
+	*dent = *itr->dent;
+
+	if (strlen(path) < FAT_DENT_CACHE_PATH) {
+		i = fat_dent_cache_next;
+		fat_dent_cache_next = (i + 1) % FAT_DENT_CACHE_SIZE;
+		fat_dent_cache[i].dev = cur_dev;
+		fat_dent_cache[i].part_start = cur_part_info.start;
+		fat_dent_cache[i].write_gen = cur_dev->write_gen;
+		strcpy(fat_dent_cache[i].path, path);
+		fat_dent_cache[i].dent = *dent;
+	}
+
+	return 0;
+}
+
 int file_fat_detectfs(void)
 {
 	boot_sector bs;
@@ -1055,6 +1163,7 @@ int fat_size(const char *filename, loff_t *size)
 {
 	fsdata fsdata;
 	fat_itr *itr;
+	dir_entry dent;
 	int ret;
 
 	itr = malloc_cache_aligned(sizeof(fat_itr));
@@ -1064,7 +1173,7 @@ int fat_size(const char *filename, loff_t *size)
 	if (ret)
 		goto out_free_itr;
 
-	ret = fat_itr_resolve(itr, filename, TYPE_FILE);
+	ret = fat_resolve_file(itr, filename, &dent);
 	if (ret) {
 		/*
 		 * Directories don't have size, but fs_size() is not
@@ -1079,7 +1188,7 @@ int fat_size(const char *filename, loff_t *size)
 		goto out_free_both;
 	}
 
-	*size = FAT2CPU32(itr->dent->size);
+	*size = FAT2CPU32(dent.size);
 out_free_both:
 	free(fsdata.fatbuf);
 out_free_itr:
@@ -1092,6 +1201,7 @@ int file_fat_read_at(const char *filename, loff_t pos, void *buffer,
 {
 	fsdata fsdata;
 	fat_itr *itr;
+	dir_entry dent;
 	int ret;
 
 	itr = malloc_cache_aligned(sizeof(fat_itr));
@@ -1101,12 +1211,12 @@ int file_fat_read_at(const char *filename, loff_t pos, void *buffer,
 	if (ret)
 		goto out_free_itr;
 
-	ret = fat_itr_resolve(itr, filename, TYPE_FILE);
+	ret = fat_resolve_file(itr, filename, &dent);
 	if (ret)
 		goto out_free_both;
 
 	printf("reading %s\n", filename);
-	ret = get_contents(&fsdata, itr->dent, pos, buffer, maxsize, actread);
+	ret = get_contents(&fsdata, &dent, pos, buffer, maxsize, actread);
 
 out_free_both:
 	free(fsdata.fatbuf);
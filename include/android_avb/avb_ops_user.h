@@ -63,6 +63,15 @@ AvbOps* avb_ops_user_new(void);
 /* Frees an AvbOps instance previously allocated with avb_ops_device_new(). */
 void avb_ops_user_free(AvbOps* ops);
 
+struct crypto_digest_key;
+
+/* Fills in the block device and first block of |partition| on the boot
+ * device, for looking up cached digests of its content. Returns 0 on
+ * success.
+ */
+int avb_ops_user_digest_key(const char* partition,
+                            struct crypto_digest_key* key);
+
 struct preloaded_partition {
 	uint8_t *addr;
 	size_t size; // 0 means the partition hasn't yet been preloaded
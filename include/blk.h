@@ -99,6 +99,10 @@ struct blk_desc {
 		uint32_t mbr_sig;	/* MBR integer signature */
 		efi_guid_t guid_sig;	/* GPT GUID Signature */
 	};
+#if CONFIG_IS_ENABLED(BLOCK_READAHEAD)
+	struct blk_readahead *ra;	/* sequential read-ahead state */
+#endif
+	u32		write_gen;	/* changed on every write, erase or re-probe */
 #if CONFIG_IS_ENABLED(BLK)
 	/*
 	 * For now we have a few functions which take struct blk_desc as a
@@ -137,7 +141,10 @@ struct blk_desc {
  * @param blksz - size in bytes of each block
  * @param buf - buffer to contain cached data
  *
- * @return - '1' if block returned from cache, '0' otherwise.
+ * The longest cached prefix of the request is copied to @buf, so that
+ * the caller only has to fetch the remaining tail from the device.
+ *
+ * @return - number of leading blocks returned from cache
  */
 int blkcache_read(int iftype, int dev,
 		  lbaint_t start, lbaint_t blkcnt,
@@ -171,29 +178,69 @@ void blkcache_invalidate(int iftype, int dev);
 /**
  * blkcache_configure() - configure block cache
  *
- * @param blocks - maximum blocks per entry
- * @param entries - maximum entries in cache
+ * @param blocks - blocks per entry (cache line), a power of two up to 32
+ * @param entries - maximum entries in cache, rounded down to a power of
+ *		    two number of sets
+ *
+ * @return - 0 if OK, -EINVAL if @blocks is not supported
  */
-void blkcache_configure(unsigned blocks, unsigned entries);
+int blkcache_configure(unsigned blocks, unsigned entries);
+
+/**
+ * blkcache_set_budget() - limit the cache memory used by one device
+ *
+ * @param iftype - IF_TYPE_x for type of device
+ * @param dev - device index of particular type
+ * @param mib - budget in MiB, 0 to stop caching the device
+ *
+ * @return - 0 if OK, -ENOMEM if the device record cannot be allocated
+ */
+int blkcache_set_budget(int iftype, int dev, unsigned mib);
 
 /*
  * statistics of the block cache
  */
 struct block_cache_stats {
 	unsigned hits;
+	unsigned partial_hits;
 	unsigned misses;
 	unsigned entries; /* current entry count */
 	unsigned max_blocks_per_entry;
 	unsigned max_entries;
 };
 
+/*
+ * per-device statistics of the block cache
+ */
+struct block_cache_dev_stats {
+	int iftype;
+	int devnum;
+	unsigned hits;
+	unsigned partial_hits;
+	unsigned misses;
+	unsigned long used;	/* bytes of cache held */
+	unsigned long budget;	/* bytes of cache allowed */
+};
+
 /**
  * get_blkcache_stats() - return statistics and reset
  *
+ * This resets the per-device counters as well.
+ *
  * @param stats - statistics are copied here
  */
 void blkcache_stats(struct block_cache_stats *stats);
 
+/**
+ * blkcache_dev_stats() - return statistics of one cached device
+ *
+ * @param index - index of the device, starting at 0
+ * @param stats - statistics are copied here
+ *
+ * @return - 0 if OK, -ENOENT if there is no device at @index
+ */
+int blkcache_dev_stats(int index, struct block_cache_dev_stats *stats);
+
 #else
 
 static inline int blkcache_read(int iftype, int dev,
@@ -211,6 +258,85 @@ static inline void blkcache_invalidate(int iftype, int dev) {}
 
 #endif
 
+typedef ulong (*blk_read_fn)(struct blk_desc *desc, lbaint_t start,
+			     lbaint_t blkcnt, void *buffer);
+
+#if CONFIG_IS_ENABLED(BLOCK_READAHEAD)
+/**
+ * blk_readahead_read() - read blocks through the sequential read-ahead
+ *
+ * Once consecutive requests are seen on @desc, each request that misses
+ * the read-ahead window is extended so that the following requests can be
+ * served from memory. Large requests bypass the window.
+ *
+ * @desc:	Block device descriptor
+ * @start:	First block to read
+ * @blkcnt:	Number of blocks to read
+ * @buffer:	Destination buffer
+ * @read:	Function performing the actual device read
+ * @return number of blocks read, or -ve error value from @read
+ */
+ulong blk_readahead_read(struct blk_desc *desc, lbaint_t start,
+			 lbaint_t blkcnt, void *buffer, blk_read_fn read);
+
+/**
+ * blk_readahead_invalidate() - discard the read-ahead window of a device
+ *
+ * This must be called before the device contents are changed.
+ *
+ * @desc:	Block device descriptor
+ */
+void blk_readahead_invalidate(struct blk_desc *desc);
+
+/**
+ * blk_readahead_release() - free the read-ahead state of a device
+ *
+ * @desc:	Block device descriptor
+ */
+void blk_readahead_release(struct blk_desc *desc);
+#else
+static inline ulong blk_readahead_read(struct blk_desc *desc, lbaint_t start,
+				       lbaint_t blkcnt, void *buffer,
+				       blk_read_fn read)
+{
+	return read(desc, start, blkcnt, buffer);
+}
+
+static inline void blk_readahead_invalidate(struct blk_desc *desc) {}
+static inline void blk_readahead_release(struct blk_desc *desc) {}
+#endif
+
+extern u32 blk_gen_counter;
+
+/**
+ * blk_bump_gen() - give a block device a new write generation
+ *
+ * Called on every write or erase, and whenever the device may show other
+ * data without having been written, e.g. after a re-probe or hardware
+ * partition switch. Generations come from a counter shared by all
+ * devices, so a device set up again at the address of a removed one
+ * never repeats a generation that its predecessor had.
+ *
+ * @desc:	Block device descriptor
+ */
+static inline void blk_bump_gen(struct blk_desc *desc)
+{
+	desc->write_gen = ++blk_gen_counter;
+}
+
+/**
+ * struct blk_seg - one piece of a scattered read
+ *
+ * @start:	Start block number (0=first)
+ * @blkcnt:	Number of blocks
+ * @buffer:	Destination buffer
+ */
+struct blk_seg {
+	lbaint_t start;
+	lbaint_t blkcnt;
+	void *buffer;
+};
+
 #if CONFIG_IS_ENABLED(BLK)
 struct udevice;
 
@@ -272,6 +398,20 @@ struct blk_ops {
 	 * @return 0 if OK, -ve on error
 	 */
 	int (*select_hwpart)(struct udevice *dev, int hwpart);
+
+	/**
+	 * read_segs() - read several independent runs of blocks
+	 *
+	 * Optional. Devices that can keep several commands in flight use
+	 * this to issue the whole list at once rather than one run after
+	 * the other.
+	 *
+	 * @dev:	Device to read from
+	 * @segs:	Runs to read, in any order
+	 * @count:	Number of runs
+	 * @return 0 if all runs were read, -ve error number otherwise
+	 */
+	int (*read_segs)(struct udevice *dev, struct blk_seg *segs, int count);
 };
 
 #define blk_get_ops(dev)	((struct blk_ops *)(dev)->driver->ops)
@@ -289,6 +429,35 @@ unsigned long blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
 unsigned long blk_derase(struct blk_desc *block_dev, lbaint_t start,
 			 lbaint_t blkcnt);
 
+/**
+ * blk_dread_direct() - read blocks straight from the device
+ *
+ * Bypasses the block cache and the read-ahead window, for large streams
+ * whose data ends up in @buffer anyway and would only be copied twice.
+ *
+ * @block_dev:	Block device to read from
+ * @start:	First block to read
+ * @blkcnt:	Number of blocks to read
+ * @buffer:	Destination buffer
+ * @return number of blocks read, or -ve error number on error
+ */
+unsigned long blk_dread_direct(struct blk_desc *block_dev, lbaint_t start,
+			       lbaint_t blkcnt, void *buffer);
+
+/**
+ * blk_dread_segs() - read several independent runs of blocks
+ *
+ * Devices without a read_segs() operation read the runs one at a time
+ * with blk_dread().
+ *
+ * @block_dev:	Block device to read from
+ * @segs:	Runs to read
+ * @count:	Number of runs
+ * @return 0 if all runs were read, -ve error number otherwise
+ */
+int blk_dread_segs(struct blk_desc *block_dev, struct blk_seg *segs,
+		   int count);
+
 /**
  * blk_find_device() - Find a block device
  *
@@ -423,6 +592,7 @@ int blk_get_from_parent(struct udevice *parent, struct udevice **devp);
 
 #else
 #include <errno.h>
+#include <linux/err.h>
 /*
  * These functions should take struct udevice instead of struct blk_desc,
  * but this is convenient for migration to driver model. Add a 'd' prefix
@@ -432,28 +602,60 @@ int blk_get_from_parent(struct udevice *parent, struct udevice **devp);
 static inline ulong blk_dread(struct blk_desc *block_dev, lbaint_t start,
 			      lbaint_t blkcnt, void *buffer)
 {
-	ulong blks_read;
-	if (blkcache_read(block_dev->if_type, block_dev->devnum,
-			  start, blkcnt, block_dev->blksz, buffer))
+	ulong blks_read, cached;
+
+	cached = blkcache_read(block_dev->if_type, block_dev->devnum,
+			       start, blkcnt, block_dev->blksz, buffer);
+	if (cached == blkcnt)
 		return blkcnt;
 
+	/* only fetch the tail the cache could not provide */
+	start += cached;
+	buffer = (char *)buffer + cached * block_dev->blksz;
+
 	/*
 	 * We could check if block_read is NULL and return -ENOSYS. But this
 	 * bloats the code slightly (cause some board to fail to build), and
 	 * it would be an error to try an operation that does not exist.
 	 */
-	blks_read = block_dev->block_read(block_dev, start, blkcnt, buffer);
-	if (blks_read == blkcnt)
-		blkcache_fill(block_dev->if_type, block_dev->devnum,
-			      start, blkcnt, block_dev->blksz, buffer);
+	blks_read = blk_readahead_read(block_dev, start, blkcnt - cached,
+				       buffer, block_dev->block_read);
+	if (blks_read != blkcnt - cached)
+		return IS_ERR_VALUE(blks_read) ? blks_read : cached + blks_read;
 
-	return blks_read;
+	blkcache_fill(block_dev->if_type, block_dev->devnum,
+		      start, blks_read, block_dev->blksz, buffer);
+
+	return blkcnt;
+}
+
+static inline ulong blk_dread_direct(struct blk_desc *block_dev,
+				     lbaint_t start, lbaint_t blkcnt,
+				     void *buffer)
+{
+	return block_dev->block_read(block_dev, start, blkcnt, buffer);
+}
+
+static inline int blk_dread_segs(struct blk_desc *block_dev,
+				 struct blk_seg *segs, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		if (blk_dread(block_dev, segs[i].start, segs[i].blkcnt,
+			      segs[i].buffer) != segs[i].blkcnt)
+			return -EIO;
+	}
+
+	return 0;
 }
 
 static inline ulong blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
 			       lbaint_t blkcnt, const void *buffer)
 {
 	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
+	blk_readahead_invalidate(block_dev);
+	blk_bump_gen(block_dev);
 	return block_dev->block_write(block_dev, start, blkcnt, buffer);
 }
 
@@ -461,6 +663,8 @@ static inline ulong blk_derase(struct blk_desc *block_dev, lbaint_t start,
 			       lbaint_t blkcnt)
 {
 	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
+	blk_readahead_invalidate(block_dev);
+	blk_bump_gen(block_dev);
 	return block_dev->block_erase(block_dev, start, blkcnt);
 }
 
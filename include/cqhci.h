@@ -0,0 +1,157 @@
+/*
+ * eMMC Command Queue Host Controller Interface (CQHCI)
+ *
+ * Register layout and descriptor formats follow JESD84-B51, appendix B.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __CQHCI_H__
+#define __CQHCI_H__
+
+#include <asm/io.h>
+
+/* registers */
+#define CQHCI_VER			0x00
+#define CQHCI_CAP			0x04
+#define CQHCI_CFG			0x08
+#define  CQHCI_ENABLE			BIT(0)
+#define  CQHCI_TASK_DESC_SZ		BIT(8)
+#define  CQHCI_DCMD			BIT(12)
+#define CQHCI_CTL			0x0c
+#define  CQHCI_HALT			BIT(0)
+#define  CQHCI_CLEAR_ALL_TASKS		BIT(8)
+#define CQHCI_IS			0x10
+#define  CQHCI_IS_HAC			BIT(0)
+#define  CQHCI_IS_TCC			BIT(1)
+#define  CQHCI_IS_RED			BIT(2)
+#define  CQHCI_IS_TCL			BIT(3)
+#define  CQHCI_IS_GCE			BIT(4)
+#define  CQHCI_IS_ICCE			BIT(5)
+#define  CQHCI_IS_ERR_MASK		(CQHCI_IS_RED | CQHCI_IS_GCE | \
+					 CQHCI_IS_ICCE)
+#define CQHCI_ISTE			0x14
+#define CQHCI_ISGE			0x18
+#define CQHCI_IC			0x1c
+#define CQHCI_TDLBA			0x20
+#define CQHCI_TDLBAU			0x24
+#define CQHCI_TDBR			0x28
+#define CQHCI_TCN			0x2c
+#define CQHCI_DQS			0x30
+#define CQHCI_DPT			0x34
+#define CQHCI_TCLR			0x38
+#define CQHCI_SSC1			0x40
+#define CQHCI_SSC2			0x44
+#define CQHCI_CRDCT			0x48
+#define CQHCI_RMEM			0x50
+#define CQHCI_TERRI			0x54
+#define CQHCI_CMDIDX			0x58
+#define CQHCI_CMDARG			0x5c
+#define CQHCI_CRA			0x60
+
+/* task descriptor fields */
+#define CQHCI_VALID(x)			(((x) & 1) << 0)
+#define CQHCI_END(x)			(((x) & 1) << 1)
+#define CQHCI_INT(x)			(((x) & 1) << 2)
+#define CQHCI_ACT(x)			(((x) & 0x7) << 3)
+#define CQHCI_FORCED_PROG(x)		(((x) & 1) << 6)
+#define CQHCI_CONTEXT(x)		(((x) & 0xf) << 7)
+#define CQHCI_DATA_TAG(x)		(((x) & 1) << 11)
+#define CQHCI_DATA_DIR(x)		(((x) & 1) << 12)
+#define CQHCI_PRIORITY(x)		(((x) & 1) << 13)
+#define CQHCI_QBAR(x)			(((x) & 1) << 14)
+#define CQHCI_REL_WRITE(x)		(((x) & 1) << 15)
+#define CQHCI_BLK_COUNT(x)		(((u64)(x) & 0xffff) << 16)
+#define CQHCI_BLK_ADDR(x)		(((u64)(x) & 0xffffffff) << 32)
+
+/* transfer descriptor fields */
+#define CQHCI_DAT_LENGTH(x)		(((x) & 0xffff) << 16)
+#define CQHCI_DAT_ADDR_LO(x)		(((u64)(x) & 0xffffffff) << 32)
+
+/*
+ * An ADMA2 descriptor moves at most 64 KiB, encoded as length 0. A task of
+ * MMC_CQE_MAX_BLOCKS takes 64 of them, plus one if it crosses a DMA boundary.
+ */
+#define CQHCI_MAX_SEG_SIZE		(64 * 1024)
+#define CQHCI_MAX_SEGS			65
+#define CQHCI_NUM_SLOTS			32
+
+struct mmc;
+struct mmc_cqe_task;
+
+/**
+ * struct cqhci_host - state of a command queue engine
+ *
+ * Only 32-bit DMA addressing is used, so task, link and transfer
+ * descriptors are all 64 bits wide.
+ *
+ * @mmio:	Base of the CQHCI register block
+ * @mmc:	MMC device the engine belongs to
+ * @desc:	Task descriptor list, a task and a link descriptor per slot
+ * @trans:	Transfer descriptors, CQHCI_MAX_SEGS per slot
+ * @boundary:	Power-of-two address boundary no transfer descriptor may
+ *		cross, 0 if the DMA engine has none
+ * @enabled:	true while the engine owns the bus
+ */
+struct cqhci_host {
+	void __iomem *mmio;
+	struct mmc *mmc;
+	u64 *desc;
+	u64 *trans;
+	ulong boundary;
+	bool enabled;
+};
+
+static inline void cqhci_writel(struct cqhci_host *cq, u32 val, int reg)
+{
+	writel(val, cq->mmio + reg);
+}
+
+static inline u32 cqhci_readl(struct cqhci_host *cq, int reg)
+{
+	return readl(cq->mmio + reg);
+}
+
+/**
+ * cqhci_init() - set up a command queue engine
+ *
+ * Allocates the descriptor lists. The engine stays disabled.
+ *
+ * @cq:		Engine to set up
+ * @mmc:	MMC device it belongs to
+ * @mmio:	Base of its register block
+ * @return 0 if OK, -ENOMEM if the descriptors cannot be allocated below
+ *	4 GiB
+ */
+int cqhci_init(struct cqhci_host *cq, struct mmc *mmc, void __iomem *mmio);
+
+/**
+ * cqhci_enable() - start the engine
+ *
+ * The host controller must already be set up for ADMA2 transfers of
+ * 512-byte blocks and the card must be in command queue mode.
+ */
+int cqhci_enable(struct cqhci_host *cq);
+
+/**
+ * cqhci_disable() - halt the engine and hand the bus back
+ */
+int cqhci_disable(struct cqhci_host *cq);
+
+/**
+ * cqhci_request() - run a batch of tasks
+ *
+ * All tasks are queued with a single doorbell write and the call returns
+ * once every one of them has completed.
+ *
+ * @cq:		Enabled engine
+ * @tasks:	Tasks to run
+ * @count:	Number of tasks, at most the card's queue depth
+ * @return 0 if all tasks completed, -EINVAL if a buffer lies above 4 GiB,
+ *	-E2BIG if a task needs too many descriptors, -EIO on a task error,
+ *	-ETIMEDOUT
+ */
+int cqhci_request(struct cqhci_host *cq, struct mmc_cqe_task *tasks,
+		  int count);
+
+#endif /* __CQHCI_H__ */
@@ -7,6 +7,7 @@
 #define _CORE_CRYPTO_H_
 
 #include <common.h>
+#include <blk.h>
 #include <dm.h>
 #include <image.h>
 #include <u-boot/sha1.h>
@@ -275,4 +276,70 @@ int crypto_ae(struct udevice *dev, cipher_context *ctx,
 	      const u8 *in, u32 len, const u8 *aad, u32 aad_len,
 	      u8 *out, u8 *tag);
 
+/**
+ * struct crypto_digest_key - the data a cached digest was computed over
+ *
+ * @dev: block device holding the data
+ * @start: first block of the data on @dev
+ * @len: data length in bytes
+ * @algo: hash algorithm, CRYPTO_SHA256...
+ * @salt: bytes hashed ahead of the data, may be NULL
+ * @salt_len: length of @salt
+ */
+struct crypto_digest_key {
+	struct blk_desc	*dev;
+	lbaint_t	start;
+	u64		len;
+	u32		algo;
+	const u8	*salt;
+	u32		salt_len;
+};
+
+#if CONFIG_IS_ENABLED(CRYPTO_DIGEST_CACHE)
+/**
+ * crypto_digest_cache_get() - Look up the digest of unchanged data
+ *
+ * @key: data description
+ * @digest: output digest, crypto_algo_nbits(@key->algo) bits
+ *
+ * @return 0 if a digest was stored for @key and @key->dev has not been
+ * written since, -ENOENT otherwise
+ */
+int crypto_digest_cache_get(const struct crypto_digest_key *key, u8 *digest);
+
+/**
+ * crypto_digest_cache_put() - Remember the digest of verified data
+ *
+ * @key: data description
+ * @digest: digest of the data
+ */
+void crypto_digest_cache_put(const struct crypto_digest_key *key,
+			     const u8 *digest);
+
+/**
+ * crypto_digest_cache_invalidate() - Forget all digests of a block device
+ *
+ * Called when the device may show other data without having been written
+ * through U-Boot, i.e. after a re-probe or a hardware partition switch.
+ *
+ * @dev: block device
+ */
+void crypto_digest_cache_invalidate(struct blk_desc *dev);
+#else
+static inline int crypto_digest_cache_get(const struct crypto_digest_key *key,
+					  u8 *digest)
+{
+	return -ENOENT;
+}
+
+static inline void crypto_digest_cache_put(const struct crypto_digest_key *key,
+					   const u8 *digest)
+{
+}
+
+static inline void crypto_digest_cache_invalidate(struct blk_desc *dev)
+{
+}
+#endif
+
 #endif
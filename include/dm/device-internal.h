@@ -91,6 +91,29 @@ int device_bind_by_name(struct udevice *parent, bool pre_reloc_only,
  */
 int device_probe(struct udevice *dev);
 
+/**
+ * device_probe_start() - Start probing a device without waiting for it
+ *
+ * Like device_probe(), but for a driver with a probe_finish() method this
+ * returns as soon as probe() has started the hardware, leaving the device
+ * with DM_FLAG_PROBE_PENDING set. Complete it with device_probe_step() or
+ * device_probe(); the latter is what any normal lookup of the device does,
+ * so users never see a half-probed device.
+ *
+ * @dev: Pointer to device to probe
+ * @return 0 if OK, -ve on error
+ */
+int device_probe_start(struct udevice *dev);
+
+/**
+ * device_probe_step() - Try to complete a pending probe
+ *
+ * @dev: Pointer to device started with device_probe_start()
+ * @return 0 if the device is now active, -EAGAIN if it is still waiting
+ * for its hardware, other -ve on error
+ */
+int device_probe_step(struct udevice *dev);
+
 /**
  * device_remove() - Remove a device, de-activating it
  *
@@ -62,6 +62,9 @@ struct driver_info;
  */
 #define DM_FLAG_OS_PREPARE		(1 << 10)
 
+/* Driver probe() has run, probe_finish() has not completed yet */
+#define DM_FLAG_PROBE_PENDING		(1 << 11)
+
 /* Device is from kernel dtb */
 #define DM_FLAG_KNRL_DTB		(1 << 31)
 
@@ -211,6 +214,12 @@ struct udevice_id {
  * for each.
  * @bind: Called to bind a device to its driver
  * @probe: Called to probe a device, i.e. activate it
+ * @probe_finish: Optional second half of probe. A driver whose probe has
+ * to wait for hardware (link training, power and reset timings) starts
+ * the hardware in @probe and completes here. This is called repeatedly
+ * and returns -EAGAIN while the hardware is not ready yet, so it must not
+ * block; that lets several devices started with device_probe_start() wait
+ * at the same time. The uclass post_probe() method runs after it.
  * @remove: Called to remove a device, i.e. de-activate it
  * @unbind: Called to unbind a device from its driver
  * @ofdata_to_platdata: Called before probe to decode device tree data
@@ -244,6 +253,7 @@ struct driver {
 	const struct udevice_id *of_match;
 	int (*bind)(struct udevice *dev);
 	int (*probe)(struct udevice *dev);
+	int (*probe_finish)(struct udevice *dev);
 	int (*remove)(struct udevice *dev);
 	int (*unbind)(struct udevice *dev);
 	int (*ofdata_to_platdata)(struct udevice *dev);
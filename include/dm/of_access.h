@@ -243,6 +243,20 @@ struct device_node *of_find_compatible_node(struct device_node *from,
  */
 struct device_node *of_find_node_by_phandle(phandle handle);
 
+/**
+ * of_phandle_index_build() - Build the phandle lookup table for a tree
+ *
+ * Called once a live tree has been created so that of_find_node_by_phandle()
+ * does not have to walk the whole tree. Nodes whose phandle changes later
+ * are still found, just without the benefit of the table. This does nothing
+ * unless CONFIG_DM_OF_INDEX is enabled.
+ *
+ * @root:	Root node of the tree
+ * @return 0 if OK (including if the tree's phandles are too sparse to be
+ * worth a table), -ENOMEM if out of memory
+ */
+int of_phandle_index_build(struct device_node *root);
+
 /**
  * of_read_u32() - Find and read a 32-bit integer from a property
  *
@@ -263,6 +263,19 @@ int uclass_get_device_by_phandle(enum uclass_id id, struct udevice *parent,
 int uclass_get_device_by_driver(enum uclass_id id, const struct driver *drv,
 				struct udevice **devp);
 
+/**
+ * uclass_probe_all() - Probe all devices in a uclass
+ *
+ * All devices are started before any is finished, so the hardware waits
+ * of drivers with a probe_finish() method overlap instead of adding up.
+ * Devices bound while probing are probed afterwards, one by one. A device
+ * that failed to probe is not tried again.
+ *
+ * @id: Uclass ID to probe
+ * @return 0 if OK, else the first error seen; all devices are still tried
+ */
+int uclass_probe_all(enum uclass_id id);
+
 /**
  * uclass_first_device() - Get the first device in a uclass
  *
@@ -200,6 +200,11 @@ struct dwmci_host {
 	 */
 	unsigned int (*get_mmc_clk)(struct dwmci_host *host, uint freq);
 	int (*execute_tuning)(struct dwmci_host *host, u32 opcode);
+#if CONFIG_IS_ENABLED(MMC_TUNING_CACHE)
+	/* Read back and force the sample point found by execute_tuning() */
+	int (*get_tuning)(struct dwmci_host *host, u32 *phase);
+	int (*set_tuning)(struct dwmci_host *host, u32 phase);
+#endif
 #ifndef CONFIG_BLK
 	struct mmc_config cfg;
 #endif
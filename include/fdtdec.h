@@ -661,6 +661,20 @@ const char *fdtdec_get_compatible(enum fdt_compat_id id);
  */
 int fdtdec_lookup_phandle(const void *blob, int node, const char *prop_name);
 
+/**
+ * fdtdec_phandle_to_offset() - Find the node with a given phandle
+ *
+ * This is fdt_node_offset_by_phandle() with a lookup table: after
+ * relocation, and with CONFIG_DM_OF_INDEX, the first call scans the blob
+ * once and later calls are answered from the table. The table is checked
+ * against the blob on each hit and rebuilt if the blob has changed.
+ *
+ * @param blob		FDT blob
+ * @param phandle	phandle to look for
+ * @return node offset if found, -ve FDT_ERR_... on error
+ */
+int fdtdec_phandle_to_offset(const void *blob, uint32_t phandle);
+
 /**
  * Look up a property in a node and return its contents in an integer
  * array of given length. The property must have at least enough data for
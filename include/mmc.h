@@ -61,6 +61,7 @@
 #define MMC_MODE_HS200		(1 << 6)
 #define MMC_MODE_HS400		(1 << 7)
 #define MMC_MODE_HS400ES	(1 << 8)
+#define MMC_MODE_CQE		(1 << 9)
 
 #define SD_DATA_4BIT	0x00040000
 
@@ -93,6 +94,7 @@
 #define MMC_CMD_ERASE_GROUP_START	35
 #define MMC_CMD_ERASE_GROUP_END		36
 #define MMC_CMD_ERASE			38
+#define MMC_CMD_CMDQ_TASK_MGMT		48
 #define MMC_CMD_APP_CMD			55
 #define MMC_CMD_SPI_READ_OCR		58
 #define MMC_CMD_SPI_CRC_ON_OFF		59
@@ -101,6 +103,8 @@
 #define MMC_CMD62_ARG1			0xefac62ec
 #define MMC_CMD62_ARG2			0xcbaea7
 
+#define MMC_CMDQ_DISCARD_QUEUE		0x1
+
 
 #define SD_CMD_SEND_RELATIVE_ADDR	3
 #define SD_CMD_SWITCH_FUNC		6
@@ -172,6 +176,7 @@
 /*
  * EXT_CSD fields
  */
+#define EXT_CSD_CMDQ_MODE_EN		15	/* R/W */
 #define EXT_CSD_ENH_START_ADDR		136	/* R/W */
 #define EXT_CSD_ENH_SIZE_MULT		140	/* R/W */
 #define EXT_CSD_GP_SIZE_MULT		143	/* R/W */
@@ -199,6 +204,8 @@
 #define EXT_CSD_HC_ERASE_GRP_SIZE	224	/* RO */
 #define EXT_CSD_BOOT_MULT		226	/* RO */
 #define EXT_CSD_SEC_FEATURE_SUPPORT     231     /* RO */
+#define EXT_CSD_CMDQ_DEPTH		307	/* RO */
+#define EXT_CSD_CMDQ_SUPPORT		308	/* RO */
 #define EXT_CSD_BKOPS_SUPPORT		502	/* RO */
 
 /*
@@ -406,6 +413,26 @@ struct mmc_data {
 /* forward decl. */
 struct mmc;
 
+/**
+ * struct mmc_cqe_task - one queued read or write for the command queue
+ *
+ * @blk:	First block on the card
+ * @blocks:	Number of 512-byte blocks, at most MMC_CQE_MAX_BLOCKS
+ * @buf:	DMA-able buffer, aligned to ARCH_DMA_MINALIGN
+ * @write:	true to write @buf to the card, false to read into it
+ */
+struct mmc_cqe_task {
+	u32 blk;
+	u32 blocks;
+	void *buf;
+	bool write;
+};
+
+/* 64 ADMA2 descriptors of 64 KiB each */
+#define MMC_CQE_MAX_BLOCKS	8192
+/* EXT_CSD_CMDQ_DEPTH is a 5-bit field */
+#define MMC_CQE_MAX_DEPTH	32
+
 #if CONFIG_IS_ENABLED(DM_MMC)
 struct dm_mmc_ops {
 	/**
@@ -475,6 +502,61 @@ struct dm_mmc_ops {
 	int (*execute_tuning)(struct udevice *dev, u32 opcode);
 	/* set_enhanced_strobe() - set HS400 enhanced strobe */
 	int (*set_enhanced_strobe)(struct udevice *dev);
+#if CONFIG_IS_ENABLED(MMC_CQE)
+	/**
+	 * cqe_enable() - hand the bus to the command queue engine
+	 *
+	 * Called once the card has been switched to command queue mode.
+	 *
+	 * @dev:	Device to update
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*cqe_enable)(struct udevice *dev);
+
+	/**
+	 * cqe_disable() - halt the command queue engine
+	 *
+	 * Afterwards legacy commands can be sent again.
+	 *
+	 * @dev:	Device to update
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*cqe_disable)(struct udevice *dev);
+
+	/**
+	 * cqe_request() - queue a batch of tasks and wait for all of them
+	 *
+	 * @dev:	Device to use
+	 * @tasks:	Tasks to run
+	 * @count:	Number of tasks, at most the card's queue depth
+	 * @return 0 if all tasks completed, -ve on error
+	 */
+	int (*cqe_request)(struct udevice *dev, struct mmc_cqe_task *tasks,
+			   int count);
+#endif
+#if CONFIG_IS_ENABLED(MMC_TUNING_CACHE)
+	/**
+	 * get_tuning() - read back the result of execute_tuning()
+	 *
+	 * @dev:	Device to check
+	 * @phase:	Returns a host-specific value for set_tuning()
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*get_tuning)(struct udevice *dev, u32 *phase);
+
+	/**
+	 * set_tuning() - apply an earlier tuning result instead of tuning
+	 *
+	 * The result stays in force until the next execute_tuning(), which
+	 * starts from scratch.
+	 *
+	 * @dev:	Device to update
+	 * @phase:	Value returned by get_tuning() for the same card,
+	 *		timing and clock
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*set_tuning)(struct udevice *dev, u32 phase);
+#endif
 };
 
 #define mmc_get_ops(dev)        ((struct dm_mmc_ops *)(dev)->driver->ops)
@@ -606,6 +688,10 @@ struct mmc {
 	struct udevice *dev;	/* Device for this MMC controller */
 #endif
 	u8 raw_driver_strength;
+#if CONFIG_IS_ENABLED(MMC_CQE)
+	u8 cmdq_depth;		/* tasks the card can queue, 0 if none */
+	bool cmdq_en;		/* card is in command queue mode */
+#endif
 };
 
 struct mmc_hwpart_conf {
@@ -665,6 +751,69 @@ static inline bool mmc_card_hs400es(struct mmc *mmc)
 
 int mmc_send_tuning(struct mmc *mmc, u32 opcode);
 
+#if CONFIG_IS_ENABLED(MMC_TUNING_CACHE)
+/* Records kept by the tuning cache, one per card, timing and clock */
+#define MMC_TUNING_RECS		4
+
+/**
+ * struct mmc_tuning_rec - a validated tuning result
+ *
+ * @cid:	CID of the card
+ * @host:	Base address of the controller
+ * @clock:	Card clock in Hz
+ * @timing:	MMC_TIMING_* the result applies to
+ * @phase:	Host-specific value from the get_tuning() operation
+ */
+struct mmc_tuning_rec {
+	u32 cid[4];
+	u32 host;
+	u32 clock;
+	u32 timing;
+	u32 phase;
+};
+
+/**
+ * mmc_tuning_get() - get the records of the tuning cache
+ *
+ * @recs:	Returns the records
+ * @return number of records
+ */
+int mmc_tuning_get(const struct mmc_tuning_rec **recs);
+
+/**
+ * mmc_tuning_merge() - add records saved elsewhere to the tuning cache
+ *
+ * Records for a card, timing and clock the cache already knows about are
+ * ignored, the cache holds the newer result.
+ *
+ * @recs:	Records to add
+ * @count:	Number of records
+ */
+void mmc_tuning_merge(const struct mmc_tuning_rec *recs, int count);
+
+/**
+ * mmc_tuning_load() - board hook to fill the tuning cache
+ *
+ * Called once, before the first tuning.
+ *
+ * @recs:	Records to fill in
+ * @max:	Size of @recs
+ * @return number of records filled in
+ */
+int mmc_tuning_load(struct mmc_tuning_rec *recs, int max);
+
+/**
+ * mmc_tuning_save() - board hook to keep the tuning cache
+ *
+ * Called after a card finished initialising if the cache changed while
+ * bringing it up, never in the middle of an initialisation.
+ *
+ * @recs:	All records of the cache
+ * @count:	Number of records
+ */
+void mmc_tuning_save(const struct mmc_tuning_rec *recs, int count);
+#endif
+
 struct mmc *mmc_create(const struct mmc_config *cfg, void *priv);
 
 /**
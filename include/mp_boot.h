@@ -17,6 +17,27 @@ struct task_data {
 	ulong boot_size;
 };
 
+/*
+ * Events of the rk3528 multi-core boot protocol. The numbers are fixed by
+ * the prebuilt mp_boot_rk3528 object and must not be changed. New code
+ * should use the generic task queue in <smp_task.h> instead.
+ */
+enum mpb_init_evt {
+	MPB_INIT_SPL		= 0,	/* SPL: board_init_r() */
+	MPB_INIT_SPL_EXIT	= 2,	/* SPL: about to jump to next stage */
+	MPB_INIT_UBOOT		= 3,	/* U-Boot: pre-relocation init */
+};
+
+enum mpb_post_evt {
+	MPB_POST_BOOTDEV	= 0,	/* boot device about to be set up */
+	MPB_POST_BOOT_ADDR	= 1,	/* returns preloaded boot image addr */
+	MPB_POST_BOOT_SIZE	= 2,	/* returns preloaded boot image size */
+	MPB_POST_VERIFY		= 3,	/* returns !0 if hash is still needed */
+	MPB_POST_KERNEL		= 4,	/* about to jump to the kernel */
+	MPB_POST_BOOTM		= 5,	/* boot_android command entry */
+	MPB_POST_BASEPARAMETER	= 6,	/* wait for baseparameter to be read */
+};
+
 void mpb_init_1(struct spl_load_info info);
 void mpb_init_x(int evt);
 ulong mpb_post(int evt);
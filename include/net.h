@@ -353,6 +353,7 @@ struct vlan_ethernet_hdr {
 #define PROT_PPP_SES	0x8864		/* PPPoE session messages	*/
 
 #define IPPROTO_ICMP	 1	/* Internet Control Message Protocol	*/
+#define IPPROTO_TCP	 6	/* Transmission Control Protocol	*/
 #define IPPROTO_UDP	17	/* User Datagram Protocol		*/
 
 /*
@@ -538,7 +539,7 @@ extern int		net_restart_wrap;	/* Tried all network devices */
 
 enum proto_t {
 	BOOTP, RARP, ARP, TFTPGET, DHCP, PING, DNS, NFS, CDP, NETCONS, SNTP,
-	TFTPSRV, TFTPPUT, LINKLOCAL, FASTBOOT
+	TFTPSRV, TFTPPUT, LINKLOCAL, FASTBOOT, WGET
 };
 
 extern char	net_boot_file_name[1024];/* Boot File name */
@@ -677,6 +678,17 @@ static inline void net_send_packet(uchar *pkt, int len)
 int net_send_udp_packet(uchar *ether, struct in_addr dest, int dport,
 			int sport, int payload_len);
 
+/*
+ * Transmit the IP packet already built after the ethernet header in
+ * "net_tx_packet", performing ARP request if needed (ether will be
+ * populated)
+ *
+ * @param ether Raw packet buffer
+ * @param dest IP address to send the packet to
+ * @param ip_len Length of the packet, starting at the IP header
+ */
+int net_send_ip_packet(uchar *ether, struct in_addr dest, int ip_len);
+
 /* Processes a received packet */
 void net_process_received_packet(uchar *in_packet, int len);
 
@@ -0,0 +1,117 @@
+/*
+ * Minimal TCP client for network boot
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __TCP_H__
+#define __TCP_H__
+
+/*
+ *	Internet Protocol (IP) + TCP header, without options.
+ */
+struct ip_tcp_hdr {
+	u8		ip_hl_v;	/* header length and version	*/
+	u8		ip_tos;		/* type of service		*/
+	u16		ip_len;		/* total length			*/
+	u16		ip_id;		/* identification		*/
+	u16		ip_off;		/* fragment offset field	*/
+	u8		ip_ttl;		/* time to live			*/
+	u8		ip_p;		/* protocol			*/
+	u16		ip_sum;		/* checksum			*/
+	struct in_addr	ip_src;		/* Source IP address		*/
+	struct in_addr	ip_dst;		/* Destination IP address	*/
+	u16		tcp_src;	/* TCP source port		*/
+	u16		tcp_dst;	/* TCP destination port		*/
+	u32		tcp_seq;	/* Sequence number		*/
+	u32		tcp_ack;	/* Acknowledgment number	*/
+	u8		tcp_hlen;	/* 4 bits header length		*/
+	u8		tcp_flags;	/* FIN, SYN, RST, PSH, ACK	*/
+	u16		tcp_win;	/* Receive window		*/
+	u16		tcp_xsum;	/* Checksum			*/
+	u16		tcp_urg;	/* Urgent pointer		*/
+} __attribute__((packed));
+
+#define IP_TCP_HDR_SIZE		(sizeof(struct ip_tcp_hdr))
+#define TCP_HDR_SIZE		(IP_TCP_HDR_SIZE - IP_HDR_SIZE)
+
+#define TCP_FIN		0x01
+#define TCP_SYN		0x02
+#define TCP_RST		0x04
+#define TCP_PSH		0x08
+#define TCP_ACK		0x10
+
+/* Largest segment that fits an Ethernet frame without IP options */
+#define TCP_MSS		(1500 - IP_TCP_HDR_SIZE)
+
+/*
+ * Segments are copied to their final place as soon as they are polled,
+ * so the only buffering in front of us is the Ethernet RX ring. Never
+ * advertise more than it can hold or the tail of each burst is dropped.
+ */
+#ifdef CONFIG_PROT_TCP_RX_SEGS
+#define TCP_RCV_SEGS	CONFIG_PROT_TCP_RX_SEGS
+#else
+#define TCP_RCV_SEGS	PKTBUFSRX
+#endif
+/* No window scaling, so the window must fit the 16-bit header field */
+#define TCP_RCV_WND	(TCP_RCV_SEGS * TCP_MSS > 0xffff ? 0xffff : \
+			 TCP_RCV_SEGS * TCP_MSS)
+
+/**
+ * struct tcp_ops - callbacks of the application using the connection
+ *
+ * @connected:	The three-way handshake completed
+ * @rx:		Data arrived. @offset is the position of @data in the
+ *		stream, 0 being the first byte sent by the peer. Data may
+ *		arrive out of order when SACK is in use; return 0 if it
+ *		was consumed, or a negative value to drop it and have the
+ *		peer send it again later.
+ * @closed:	The connection is gone: 0 when the peer closed it after
+ *		sending all of its data, -ve error otherwise
+ */
+struct tcp_ops {
+	void (*connected)(void);
+	int (*rx)(u32 offset, uchar *data, unsigned int len);
+	void (*closed)(int err);
+};
+
+/**
+ * tcp_connect() - open a connection
+ *
+ * Only one connection exists at a time. This takes over the net_loop()
+ * timeout handler for retransmissions until the connection is closed.
+ *
+ * @dest:	Server address
+ * @dport:	Server port
+ * @ops:	Application callbacks
+ */
+void tcp_connect(struct in_addr dest, int dport, const struct tcp_ops *ops);
+
+/**
+ * tcp_send() - send data on the connection
+ *
+ * Only one segment may be in flight; it is retransmitted until acked.
+ *
+ * @data:	Data to send
+ * @len:	Length of @data, at most TCP_MSS
+ * @return 0 if OK, -EBUSY if a segment is still in flight, -ENOTCONN
+ * if the connection is not established, -E2BIG if @len is too large
+ */
+int tcp_send(const void *data, unsigned int len);
+
+/**
+ * tcp_abort() - reset the connection
+ *
+ * Sends a RST and forgets the connection; @closed is not called.
+ */
+void tcp_abort(void);
+
+/* Reset all connection state */
+void tcp_init(void);
+
+/* Process a received TCP segment; @len is the IP total length */
+void tcp_receive(struct ip_tcp_hdr *ip, unsigned int len,
+		 struct in_addr src);
+
+#endif /* __TCP_H__ */
@@ -0,0 +1,13 @@
+/*
+ * HTTP download over TCP
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __WGET_H__
+#define __WGET_H__
+
+/* wget.c */
+void wget_start(void);	/* Begin HTTP GET of net_boot_file_name */
+
+#endif /* __WGET_H__ */
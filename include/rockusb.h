@@ -54,10 +54,38 @@ enum rkusb_rc {
 
 struct fsg_common;
 
+/* Throughput counters of the last rockusb session */
+struct rkusb_stats {
+	u64 read_bytes;
+	u64 write_bytes;
+	u32 read_xfers;
+	u32 write_xfers;
+	u32 storage_writes;	/* blk_dwrite() calls */
+	u64 read_us;		/* time spent in blk_dread() */
+	u64 write_us;		/* time spent in blk_dwrite() */
+	u64 session_us;
+};
+
 #ifdef CONFIG_CMD_ROCKUSB
 #define IS_RKUSB_UMS_DNL(name)	(!strncmp((name), "rkusb_ums_dnl", 13))
 
 int rkusb_do_check_parity(struct fsg_common *common);
+
+/**
+ * rkusb_write_flush() - write out the write-behind buffer
+ *
+ * Return: 0 if all buffered writes since the last call succeeded, -EIO
+ * otherwise. The error is cleared.
+ */
+int rkusb_write_flush(void);
+
+/**
+ * rkusb_write_idle() - write out the write-behind buffer while idle
+ *
+ * Like rkusb_write_flush(), but keeps a failure pending so that it is
+ * reported on the next command.
+ */
+void rkusb_write_idle(void);
 #else
 #define IS_RKUSB_UMS_DNL(name)	0
 
@@ -79,6 +107,15 @@ static inline int rkusb_do_check_parity(struct fsg_common *common)
 {
 	return -EOPNOTSUPP;
 }
+
+static inline int rkusb_write_flush(void)
+{
+	return 0;
+}
+
+static inline void rkusb_write_idle(void)
+{
+}
 #endif
 
 /* Wait at maximum 60 seconds for cable connection */
@@ -121,6 +121,7 @@
 #define  SDHCI_INT_CARD_INSERT	BIT(6)
 #define  SDHCI_INT_CARD_REMOVE	BIT(7)
 #define  SDHCI_INT_CARD_INT	BIT(8)
+#define  SDHCI_INT_CQE		BIT(14)
 #define  SDHCI_INT_ERROR	BIT(15)
 #define  SDHCI_INT_TIMEOUT	BIT(16)
 #define  SDHCI_INT_CRC		BIT(17)
@@ -242,6 +243,8 @@ struct sdhci_host;
  */
 #define SDHCI_DEFAULT_BOUNDARY_SIZE	(512 * 1024)
 #define SDHCI_DEFAULT_BOUNDARY_ARG	(7)
+struct cqhci_host;
+
 struct sdhci_ops {
 #ifdef CONFIG_MMC_SDHCI_IO_ACCESSORS
 	u32	(*read_l)(struct sdhci_host *host, int reg);
@@ -268,6 +271,35 @@ struct sdhci_ops {
 	 * Return: 0 if successful, -ve on error
 	 */
 	int	(*set_enhanced_strobe)(struct sdhci_host *host);
+
+#if CONFIG_IS_ENABLED(MMC_TUNING_CACHE)
+	/**
+	 * get_tuning() - Read back the sample point found by tuning
+	 *
+	 * @host: SDHCI host structure
+	 * @phase: Returns a host-specific value for set_tuning()
+	 * Return: 0 if successful, -ve on error
+	 */
+	int	(*get_tuning)(struct sdhci_host *host, u32 *phase);
+
+	/**
+	 * set_tuning() - Force a sample point found by an earlier tuning
+	 *
+	 * @host: SDHCI host structure
+	 * @phase: Value from get_tuning()
+	 * Return: 0 if successful, -ve on error
+	 */
+	int	(*set_tuning)(struct sdhci_host *host, u32 phase);
+
+	/**
+	 * reset_tuning() - Hand the sample point back to the tuning circuit
+	 *
+	 * This is called before tuning, to undo set_tuning().
+	 *
+	 * @host: SDHCI host structure
+	 */
+	void	(*reset_tuning)(struct sdhci_host *host);
+#endif
 };
 
 struct sdhci_host {
@@ -290,6 +322,9 @@ struct sdhci_host {
 	uint	voltages;
 
 	struct mmc_config cfg;
+#if CONFIG_IS_ENABLED(MMC_CQHCI)
+	struct cqhci_host *cqe;	/* Command queue engine, NULL if none */
+#endif
 };
 
 void sdhci_enable_clk(struct sdhci_host *host, u16 clk);
@@ -0,0 +1,156 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * (C) Copyright 2026 Rockchip Electronics Co., Ltd
+ */
+
+#ifndef _SMP_TASK_H_
+#define _SMP_TASK_H_
+
+#include <errno.h>
+
+/*
+ * Small work queue that runs boot tasks on the secondary cores.
+ *
+ * Tasks are submitted from the boot CPU only. A task function runs with
+ * the MMU and caches enabled on a private stack, but it must not use
+ * anything that is not safe against the boot CPU running concurrently:
+ * no malloc()/free(), no console output and no driver model calls. Any
+ * memory it works on must be owned by the task until it completes.
+ *
+ * A submitted task, and everything its function uses, must stay valid
+ * until smp_task_wait() returned something other than -ETIMEDOUT: until
+ * then a core may still look at it.
+ *
+ * If no secondary core is available, tasks run on the boot CPU inside
+ * smp_task_submit(), so callers need no separate single-core path.
+ */
+
+#define SMP_TASK_ANY_CPU	(-1)
+
+enum smp_task_state {
+	SMP_TASK_IDLE = 0,
+	SMP_TASK_QUEUED,
+	SMP_TASK_RUNNING,
+	SMP_TASK_DONE,
+};
+
+struct smp_task {
+	const char *name;
+	int (*fn)(void *arg);
+	void *arg;
+
+	/* private to the scheduler */
+	int state;
+	int ret;
+	int cpu;
+	u32 slot;
+};
+
+/**
+ * smp_task_init() - prepare a task object before submitting it
+ *
+ * @task:	Task to initialise
+ * @name:	Name, used for debugging only
+ * @fn:		Function to run, its return value becomes the task result
+ * @arg:	Argument passed to @fn
+ */
+static inline void smp_task_init(struct smp_task *task, const char *name,
+				 int (*fn)(void *arg), void *arg)
+{
+	task->name = name;
+	task->fn = fn;
+	task->arg = arg;
+	task->state = SMP_TASK_IDLE;
+	task->ret = 0;
+	task->cpu = -1;
+	task->slot = 0;
+}
+
+#ifdef CONFIG_SMP_TASK
+/**
+ * smp_task_submit() - queue a task on a secondary core
+ *
+ * The secondary cores are brought up on the first call. If @cpu is
+ * SMP_TASK_ANY_CPU, the core with the shortest queue is chosen. When no
+ * core can take the task it runs on the calling CPU before returning.
+ *
+ * @task:	Task initialised with smp_task_init()
+ * @cpu:	Index of the secondary core, or SMP_TASK_ANY_CPU
+ * @return 0 if OK, -EBUSY if @task is still pending, -EINVAL if @cpu
+ *	   does not exist
+ */
+int smp_task_submit(struct smp_task *task, int cpu);
+
+/**
+ * smp_task_poll() - check whether a task has completed
+ *
+ * @task:	Submitted task
+ * @return -EINPROGRESS while the task is pending, otherwise its result
+ */
+int smp_task_poll(struct smp_task *task);
+
+/**
+ * smp_task_wait() - wait for a task to complete
+ *
+ * A task that no core has started yet is run on the calling CPU instead
+ * of waiting for it. Once this returns anything but -ETIMEDOUT no core
+ * touches @task any more and it may be freed. After a timeout the task
+ * may still be running: wait for it again, or never free it.
+ *
+ * @task:	Submitted task
+ * @timeout_ms:	Time to wait, 0 to wait forever
+ * @return result of the task, -ETIMEDOUT, or -EINVAL if @task was never
+ *	   submitted
+ */
+int smp_task_wait(struct smp_task *task, ulong timeout_ms);
+
+/**
+ * smp_task_cpu_count() - get the number of secondary cores in use
+ *
+ * @return number of online secondary cores, bringing them up if needed
+ */
+int smp_task_cpu_count(void);
+
+/**
+ * smp_task_stop_all() - power off all secondary cores
+ *
+ * Waits for all queued tasks, then returns the cores to the firmware so
+ * that the OS can bring them up again. Must be called before jumping to
+ * the OS.
+ */
+void smp_task_stop_all(void);
+
+/* Arch hooks, see arch/arm/cpu/armv8/smp_task.c */
+int smp_task_arch_cpu_on(u64 mpidr, void *ctx);
+void smp_task_arch_secondary_init(ulong tlb_addr);
+void __noreturn smp_task_arch_cpu_off(void);
+bool smp_task_arch_cpu_is_off(u64 mpidr);
+#else
+static inline int smp_task_submit(struct smp_task *task, int cpu)
+{
+	task->cpu = -1;
+	task->ret = task->fn(task->arg);
+	task->state = SMP_TASK_DONE;
+
+	return 0;
+}
+
+static inline int smp_task_poll(struct smp_task *task)
+{
+	return task->state == SMP_TASK_DONE ? task->ret : -EINPROGRESS;
+}
+
+static inline int smp_task_wait(struct smp_task *task, ulong timeout_ms)
+{
+	return task->ret;
+}
+
+static inline int smp_task_cpu_count(void)
+{
+	return 0;
+}
+
+static inline void smp_task_stop_all(void) {}
+#endif
+
+#endif
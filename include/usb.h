@@ -664,6 +664,24 @@ struct usb_emul_platdata {
 	int port1;	/* Port number (numbered from 1) */
 };
 
+/**
+ * struct usb_bulk_xfer - one bulk message of a batch
+ *
+ * @pipe:	Bulk pipe
+ * @buffer:	Buffer to send or receive. This should be DMA-aligned.
+ * @length:	Buffer length in bytes
+ * @actual:	Returns the number of bytes transferred
+ * @status:	Returns the USB_ST_... status, 0 if OK and USB_ST_NOT_PROC
+ *		if the message never completed
+ */
+struct usb_bulk_xfer {
+	unsigned long pipe;
+	void *buffer;
+	int length;
+	int actual;
+	unsigned long status;
+};
+
 /**
  * struct dm_usb_ops - USB controller operations
  *
@@ -786,6 +804,23 @@ struct dm_usb_ops {
 	 * in a USB transfer. USB class driver needs to be aware of this.
 	 */
 	int (*get_max_xfer_size)(struct udevice *bus, size_t *size);
+
+	/**
+	 * bulk_batch() - Queue several bulk messages at once
+	 *
+	 * All messages are handed to the controller before waiting for the
+	 * first one, so the device never waits for the host between them.
+	 * Messages on the same endpoint complete in order. This returns
+	 * once all of them completed, or as soon as one failed. Messages
+	 * on other endpoints that complete right after the failure are
+	 * still reported, those still queued then are dropped.
+	 *
+	 * @xfers:	Messages to queue
+	 * @count:	Number of messages
+	 * @return 0 if all completed, -ve on error
+	 */
+	int (*bulk_batch)(struct udevice *bus, struct usb_device *udev,
+			  struct usb_bulk_xfer *xfers, int count);
 };
 
 #define usb_get_ops(dev)	((struct dm_usb_ops *)(dev)->driver->ops)
@@ -981,6 +1016,21 @@ int usb_update_hub_device(struct usb_device *dev);
  */
 int usb_get_max_xfer_size(struct usb_device *dev, size_t *size);
 
+/**
+ * usb_bulk_batch() - Queue several bulk messages at once
+ *
+ * See bulk_batch() in struct dm_usb_ops. The status of each message is
+ * returned in @xfers, even on error.
+ *
+ * @dev:		USB device
+ * @xfers:		Messages to queue
+ * @count:		Number of messages
+ * @return 0 if OK, -ENOSYS if the HCD cannot queue messages (nothing was
+ * sent then), other -ve value on error
+ */
+int usb_bulk_batch(struct usb_device *dev, struct usb_bulk_xfer *xfers,
+		   int count);
+
 /**
  * usb_emul_setup_device() - Set up a new USB device emulation
  *
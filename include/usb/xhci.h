@@ -1257,6 +1257,10 @@ void xhci_acknowledge_event(struct xhci_ctrl *ctrl);
 union xhci_trb *xhci_wait_for_event(struct xhci_ctrl *ctrl, trb_type expected);
 int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 		 int length, void *buffer);
+/* Most bulk TDs queued at once by xhci_bulk_batch() */
+#define XHCI_BULK_BATCH_MAX	8
+int xhci_bulk_batch(struct usb_device *udev, struct usb_bulk_xfer *xfers,
+		    int count);
 int xhci_ctrl_tx(struct usb_device *udev, unsigned long pipe,
 		 struct devrequest *req, int length, void *buffer);
 int xhci_check_maxpacket(struct usb_device *udev);
@@ -35,6 +35,7 @@
 #include <android_avb/avb_util.h>
 #include <android_avb/avb_vbmeta_image.h>
 #include <android_avb/avb_version.h>
+#include <crypto.h>
 
 /* Maximum number of partitions that can be loaded with avb_slot_verify(). */
 #define MAX_NUMBER_OF_LOADED_PARTITIONS 32
@@ -404,6 +405,36 @@ static AvbSlotVerifyResult load_and_verify_hash_partition(
   if (image_size_to_hash > image_size) {
     image_size_to_hash = image_size;
   }
+#if CONFIG_IS_ENABLED(CRYPTO_DIGEST_CACHE)
+  /* Data that verified before and whose device was not written since
+   * does not need to be hashed again, e.g. on a retry or A/B fallback.
+   * This only holds for data just read from the device: a preloaded
+   * image lives in RAM that nothing ties to the cached digest.
+   */
+  uint8_t cached_digest[AVB_SHA512_DIGEST_SIZE];
+  struct crypto_digest_key digest_key = {
+      .len = image_size_to_hash,
+      .salt = desc_salt,
+      .salt_len = hash_desc.salt_len,
+  };
+  bool digest_key_valid = false;
+
+  if (avb_strcmp((const char*)hash_desc.hash_algorithm, "sha256") == 0) {
+    digest_key.algo = CRYPTO_SHA256;
+  } else if (avb_strcmp((const char*)hash_desc.hash_algorithm, "sha512") ==
+             0) {
+    digest_key.algo = CRYPTO_SHA512;
+  }
+  if (digest_key.algo && hash_desc.digest_len != 0 && !image_preloaded) {
+    digest_key_valid = avb_ops_user_digest_key(part_name, &digest_key) == 0;
+  }
+  if (digest_key_valid &&
+      crypto_digest_cache_get(&digest_key, cached_digest) == 0) {
+    avb_debugv(part_name, ": Using cached digest.\n", NULL);
+    digest = cached_digest;
+    digest_len = BITS2BYTE(crypto_algo_nbits(digest_key.algo));
+  } else
+#endif
   if (avb_strcmp((const char*)hash_desc.hash_algorithm, "sha256") == 0) {
     sha256_ctx.tot_len = hash_desc.salt_len + image_size_to_hash;
     avb_sha256_init(&sha256_ctx);
@@ -459,6 +490,12 @@ static AvbSlotVerifyResult load_and_verify_hash_partition(
     goto out;
   }
 
+#if CONFIG_IS_ENABLED(CRYPTO_DIGEST_CACHE)
+  if (digest_key_valid) {
+    crypto_digest_cache_put(&digest_key, digest);
+  }
+#endif
+
   ret = AVB_SLOT_VERIFY_RESULT_OK;
 
 out:
@@ -25,6 +25,7 @@
 #include <common.h>
 #include <image.h>
 #include <android_image.h>
+#include <crypto.h>
 #include <malloc.h>
 #include <mapmem.h>
 #include <errno.h>
@@ -123,8 +124,9 @@ static AvbIOResult read_from_partition(AvbOps *ops,
 	}
 
 	if ((offset % 512 == 0) && (num_bytes % 512 == 0)) {
-		blk_dread(dev_desc, part_info.start + offset_blk,
-			  blkcnt, buffer);
+		if (blk_dread(dev_desc, part_info.start + offset_blk,
+			      blkcnt, buffer) != blkcnt)
+			return AVB_IO_RESULT_ERROR_IO;
 		*out_num_read = blkcnt * 512;
 	} else {
 		char *buffer_temp;
@@ -134,8 +136,11 @@ static AvbIOResult read_from_partition(AvbOps *ops,
 			printf("malloc error!\n");
 			return AVB_IO_RESULT_ERROR_OOM;
 		}
-		blk_dread(dev_desc, part_info.start + offset_blk,
-			  blkcnt, buffer_temp);
+		if (blk_dread(dev_desc, part_info.start + offset_blk,
+			      blkcnt, buffer_temp) != blkcnt) {
+			free(buffer_temp);
+			return AVB_IO_RESULT_ERROR_IO;
+		}
 		memcpy(buffer, buffer_temp + (offset % 512), num_bytes);
 		*out_num_read = num_bytes;
 		free(buffer_temp);
@@ -648,3 +653,24 @@ void avb_ops_user_free(AvbOps *ops)
 	free(ops->atx_ops);
 	free(ops);
 }
+
+#if CONFIG_IS_ENABLED(CRYPTO_DIGEST_CACHE)
+int avb_ops_user_digest_key(const char *partition,
+			    struct crypto_digest_key *key)
+{
+	struct blk_desc *dev_desc;
+	disk_partition_t part_info;
+
+	dev_desc = rockchip_get_bootdev();
+	if (!dev_desc)
+		return -ENODEV;
+
+	if (part_get_info_by_name(dev_desc, partition, &part_info) < 0)
+		return -ENOENT;
+
+	key->dev = dev_desc;
+	key->start = part_info.start;
+
+	return 0;
+}
+#endif
@@ -14,8 +14,14 @@
 #include <common.h>
 #endif
 #include <compiler.h>
+#include <linux/compiler.h>
 #include <u-boot/crc.h>
 
+#ifdef USE_HOSTCC
+#undef __weak
+#define __weak
+#endif
+
 #if defined(CONFIG_HW_WATCHDOG) || defined(CONFIG_WATCHDOG)
 #include <watchdog.h>
 #endif
@@ -176,7 +182,7 @@ const uint32_t * ZEXPORT get_crc_table()
 /* No ones complement version. JFFS2 (and other things ?)
  * don't use ones compliment in their CRC calculations.
  */
-uint32_t ZEXPORT crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
+__weak uint32_t ZEXPORT crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
 {
     const uint32_t *tab = crc_table;
     const uint32_t *b =(const uint32_t *)buf;
@@ -13,8 +13,8 @@
 #include <common.h>
 #include <compiler.h>
 
-uint32_t crc32c_cal(uint32_t crc, const char *data, int length,
-		    uint32_t *crc32c_table)
+__weak uint32_t crc32c_cal(uint32_t crc, const char *data, int length,
+			   uint32_t *crc32c_table)
 {
 	while (length--)
 		crc = crc32c_table[(u8)(crc ^ *data++)] ^ (crc >> 8);
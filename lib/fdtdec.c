@@ -16,6 +16,7 @@
 #include <asm/sections.h>
 #include <linux/ctype.h>
 #include <linux/lzo.h>
+#include <malloc.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -604,6 +605,81 @@ int fdtdec_prepare_fdt(void)
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(DM_OF_INDEX)
+/* phandle lookup table of a flat tree, see fdtdec_phandle_to_offset() */
+static struct {
+	const void *blob;
+	int *offsets;		/* node offset + 1, 0 if no node */
+	uint32_t max;
+} fdt_phandle_idx;
+
+static void fdtdec_phandle_index_build(const void *blob)
+{
+	uint32_t phandle, top = 0;
+	int count = 0;
+	int node;
+
+	free(fdt_phandle_idx.offsets);
+	fdt_phandle_idx.offsets = NULL;
+	fdt_phandle_idx.max = 0;
+	/* Remember the blob even if it gets no table, so it is not rescanned */
+	fdt_phandle_idx.blob = blob;
+
+	for (node = fdt_next_node(blob, -1, NULL); node >= 0;
+	     node = fdt_next_node(blob, node, NULL)) {
+		phandle = fdt_get_phandle(blob, node);
+		if (phandle && phandle != (uint32_t)-1) {
+			top = max(top, phandle);
+			count++;
+		}
+	}
+	if (!count || top > count * 4 + 64)
+		return;
+
+	fdt_phandle_idx.offsets = calloc(top + 1, sizeof(int));
+	if (!fdt_phandle_idx.offsets)
+		return;
+	for (node = fdt_next_node(blob, -1, NULL); node >= 0;
+	     node = fdt_next_node(blob, node, NULL)) {
+		phandle = fdt_get_phandle(blob, node);
+		if (phandle && phandle <= top &&
+		    !fdt_phandle_idx.offsets[phandle])
+			fdt_phandle_idx.offsets[phandle] = node + 1;
+	}
+	fdt_phandle_idx.max = top;
+}
+
+int fdtdec_phandle_to_offset(const void *blob, uint32_t phandle)
+{
+	int node;
+
+	/* BSS and the full heap only exist after relocation */
+	if (!(gd->flags & GD_FLG_RELOC) || !phandle || phandle == (uint32_t)-1)
+		return fdt_node_offset_by_phandle(blob, phandle);
+
+	if (fdt_phandle_idx.blob != blob)
+		fdtdec_phandle_index_build(blob);
+	if (phandle > fdt_phandle_idx.max)
+		return fdt_node_offset_by_phandle(blob, phandle);
+
+	node = fdt_phandle_idx.offsets[phandle] - 1;
+	if (node >= 0 && fdt_get_phandle(blob, node) == phandle)
+		return node;
+
+	/* The blob was edited in place, so offsets have moved */
+	node = fdt_node_offset_by_phandle(blob, phandle);
+	if (node >= 0)
+		fdtdec_phandle_index_build(blob);
+
+	return node;
+}
+#else
+int fdtdec_phandle_to_offset(const void *blob, uint32_t phandle)
+{
+	return fdt_node_offset_by_phandle(blob, phandle);
+}
+#endif
+
 int fdtdec_lookup_phandle(const void *blob, int node, const char *prop_name)
 {
 	const u32 *phandle;
@@ -614,7 +690,7 @@ int fdtdec_lookup_phandle(const void *blob, int node, const char *prop_name)
 	if (!phandle)
 		return -FDT_ERR_NOTFOUND;
 
-	lookup = fdt_node_offset_by_phandle(blob, fdt32_to_cpu(*phandle));
+	lookup = fdtdec_phandle_to_offset(blob, fdt32_to_cpu(*phandle));
 	return lookup;
 }
 
@@ -742,8 +818,7 @@ int fdtdec_parse_phandle_with_args(const void *blob, int src_node,
 			 * below.
 			 */
 			if (cells_name || cur_index == index) {
-				node = fdt_node_offset_by_phandle(blob,
-								  phandle);
+				node = fdtdec_phandle_to_offset(blob, phandle);
 				if (!node) {
 					debug("%s: could not find phandle\n",
 					      fdt_get_name(blob, src_node,
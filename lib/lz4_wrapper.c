@@ -6,7 +6,9 @@
 
 #include <common.h>
 #include <compiler.h>
+#include <malloc.h>
 #include <misc.h>
+#include <smp_task.h>
 #include <linux/kernel.h>
 #include <linux/types.h>
 #include <asm/unaligned.h>
@@ -49,12 +51,205 @@ bool lz4_is_valid_header(const unsigned char *h)
 	return true;
 }
 
+/*
+ * Decompress up to @nblocks blocks from *@inp to *@outp, stopping early at
+ * the end mark. Both pointers are advanced past the data processed.
+ */
+static int ulz4_blocks(const void **inp, const void *in_end, void **outp,
+		       const void *end, int has_block_checksum, size_t nblocks)
+{
+	const void *in = *inp;
+	void *out = *outp;
+	int ret = 0;
+
+	while (nblocks--) {
+		struct lz4_block_header b;
+
+		b.raw = le32_to_cpu(*(u32 *)in);
+		in += sizeof(struct lz4_block_header);
+
+		if (b.size > in_end - in) {
+			ret = -EINVAL;		/* input overrun */
+			break;
+		}
+
+		if (!b.size) {
+			ret = 0;	/* decompression successful */
+			break;
+		}
+
+		if (b.not_compressed) {
+			size_t size = min((ptrdiff_t)b.size, end - out);
+			memcpy(out, in, size);
+			out += size;
+			if (size < b.size) {
+				ret = -ENOBUFS;	/* output overrun */
+				break;
+			}
+		} else {
+			/* constant folding essential, do not touch params! */
+			ret = LZ4_decompress_generic(in, out, b.size,
+					end - out, endOnInputSize,
+					full, 0, noDict, out, NULL, 0);
+			if (ret < 0) {
+				ret = -EPROTO;	/* decompression error */
+				break;
+			}
+			out += ret;
+			ret = 0;
+		}
+
+		in += b.size;
+		if (has_block_checksum)
+			in += sizeof(u32);
+	}
+
+	*inp = in;
+	*outp = out;
+	return ret;
+}
+
+#ifdef CONFIG_LZ4_PARALLEL
+/*
+ * With independent blocks, every block but the last one decompresses to
+ * exactly the maximum block size when the frame was written by the lz4
+ * tool, so the output offset of each block is known up front. The block
+ * list is cut into one run per core and the runs are decompressed
+ * concurrently. A frame that does not follow this layout is detected and
+ * left to the serial decompressor.
+ */
+struct ulz4_part {
+	struct smp_task task;
+	const void *in;
+	const void *in_end;
+	void *out;
+	const void *end;
+	size_t nblocks;
+	size_t bmax;
+	int has_block_checksum;
+	bool last;
+};
+
+static int ulz4_part_fn(void *arg)
+{
+	struct ulz4_part *p = arg;
+	size_t i;
+	int ret;
+
+	for (i = 0; i < p->nblocks; i++) {
+		void *start = p->out;
+
+		ret = ulz4_blocks(&p->in, p->in_end, &p->out, p->end,
+				  p->has_block_checksum, 1);
+		if (ret)
+			return ret;
+		if (p->out - start != p->bmax &&
+		    !(p->last && i == p->nblocks - 1))
+			return -EAGAIN;
+	}
+
+	return 0;
+}
+
+static int ulz4fn_parallel(const void *in, const void *src, size_t srcn,
+			   void *dst, size_t *dstn, int has_block_checksum,
+			   size_t bmax)
+{
+	const void *in_end = src + srcn;
+	const void *end = dst + *dstn;
+	struct ulz4_part *parts;
+	size_t nblocks = 0, blk = 0;
+	const void *p;
+	int nparts, i, ret, err;
+
+	nparts = smp_task_cpu_count() + 1;
+	if (nparts < 2)
+		return -ENOSYS;
+
+	/* runs read the input while others write the output */
+	if ((const void *)dst < in_end && src < end)
+		return -ENOSYS;
+
+	for (p = in; ; nblocks++) {
+		struct lz4_block_header b;
+
+		if ((size_t)(in_end - p) < sizeof(b))
+			return -EINVAL;
+		b.raw = le32_to_cpu(get_unaligned((u32 *)p));
+		if (!b.size)
+			break;
+		p += sizeof(b) + b.size;
+		if (has_block_checksum)
+			p += sizeof(u32);
+		if (p > in_end)
+			return -EINVAL;
+	}
+
+	if (nblocks < nparts)
+		nparts = nblocks;
+	if (nparts < 2 || (nblocks - 1) * bmax > end - (const void *)dst)
+		return -ENOSYS;
+
+	parts = calloc(nparts, sizeof(*parts));
+	if (!parts)
+		return -ENOMEM;
+
+	for (i = 0, p = in; i < nparts; i++) {
+		struct ulz4_part *part = &parts[i];
+		size_t n = nblocks / nparts + (i < nblocks % nparts);
+		size_t k;
+
+		part->in = p;
+		part->in_end = in_end;
+		part->out = dst + blk * bmax;
+		part->nblocks = n;
+		part->bmax = bmax;
+		part->has_block_checksum = has_block_checksum;
+		part->last = (i == nparts - 1);
+
+		for (k = 0; k < n; k++) {
+			struct lz4_block_header b;
+
+			b.raw = le32_to_cpu(get_unaligned((u32 *)p));
+			p += sizeof(b) + b.size;
+			if (has_block_checksum)
+				p += sizeof(u32);
+		}
+		blk += n;
+		part->end = part->last ? end : dst + blk * bmax;
+	}
+
+	for (i = 1; i < nparts; i++) {
+		smp_task_init(&parts[i].task, "ulz4", ulz4_part_fn, &parts[i]);
+		smp_task_submit(&parts[i].task, SMP_TASK_ANY_CPU);
+	}
+
+	ret = ulz4_part_fn(&parts[0]);
+	for (i = 1; i < nparts; i++) {
+		/*
+		 * No timeout: only once the wait returned may parts[] be
+		 * freed, a core could still be decompressing into it.
+		 */
+		err = smp_task_wait(&parts[i].task, 0);
+		if (!ret)
+			ret = err;
+	}
+
+	if (!ret)
+		*dstn = parts[nparts - 1].out - dst;
+	free(parts);
+
+	return ret;
+}
+#endif
+
 int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 {
 	const void *end = dst + *dstn;
 	const void *in = src;
 	void *out = dst;
 	int has_block_checksum;
+	__maybe_unused size_t bmax;
 	int ret;
 	*dstn = 0;
 
@@ -84,6 +279,7 @@ int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 		if (!h->independent_blocks)
 			return -EPROTONOSUPPORT; /* we can't support this yet */
 		has_block_checksum = h->has_block_checksum;
+		bmax = 1 << (8 + 2 * h->max_block_size);
 
 		in += sizeof(*h);
 		if (h->has_content_size)
@@ -91,46 +287,20 @@ int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 		in += sizeof(u8);
 	}
 
-	while (1) {
-		struct lz4_block_header b;
-
-		b.raw = le32_to_cpu(*(u32 *)in);
-		in += sizeof(struct lz4_block_header);
+#ifdef CONFIG_LZ4_PARALLEL
+	{
+		size_t size = end - (const void *)dst;
 
-		if (in - src + b.size > srcn) {
-			ret = -EINVAL;		/* input overrun */
-			break;
+		if (!ulz4fn_parallel(in, src, srcn, dst, &size,
+				     has_block_checksum, bmax)) {
+			*dstn = size;
+			return 0;
 		}
-
-		if (!b.size) {
-			ret = 0;	/* decompression successful */
-			break;
-		}
-
-		if (b.not_compressed) {
-			size_t size = min((ptrdiff_t)b.size, end - out);
-			memcpy(out, in, size);
-			out += size;
-			if (size < b.size) {
-				ret = -ENOBUFS;	/* output overrun */
-				break;
-			}
-		} else {
-			/* constant folding essential, do not touch params! */
-			ret = LZ4_decompress_generic(in, out, b.size,
-					end - out, endOnInputSize,
-					full, 0, noDict, out, NULL, 0);
-			if (ret < 0) {
-				ret = -EPROTO;	/* decompression error */
-				break;
-			}
-			out += ret;
-		}
-
-		in += b.size;
-		if (has_block_checksum)
-			in += sizeof(u32);
 	}
+#endif
+
+	ret = ulz4_blocks(&in, src + srcn, &out, end, has_block_checksum,
+			  SIZE_MAX);
 
 	*dstn = out - dst;
 	return ret;
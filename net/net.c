@@ -90,7 +90,13 @@
 #if defined(CONFIG_UDP_FUNCTION_FASTBOOT)
 #include <net/fastboot.h>
 #endif
+#if defined(CONFIG_PROT_TCP)
+#include <net/tcp.h>
+#endif
 #include <net/tftp.h>
+#if defined(CONFIG_CMD_WGET)
+#include <net/wget.h>
+#endif
 #if defined(CONFIG_LED_STATUS)
 #include <miiphy.h>
 #include <status_led.h>
@@ -356,6 +362,9 @@ static void net_clear_handlers(void)
 	net_set_udp_handler(NULL);
 	net_set_arp_handler(NULL);
 	net_set_timeout_handler(0, NULL);
+#if defined(CONFIG_PROT_TCP)
+	tcp_init();
+#endif
 }
 
 static void net_cleanup_loop(void)
@@ -492,6 +501,11 @@ restart:
 			nfs_start();
 			break;
 #endif
+#if defined(CONFIG_CMD_WGET)
+		case WGET:
+			wget_start();
+			break;
+#endif
 #if defined(CONFIG_CMD_CDP)
 		case CDP:
 			cdp_start();
@@ -787,10 +801,6 @@ void net_set_timeout_handler(ulong iv, thand_f *f)
 int net_send_udp_packet(uchar *ether, struct in_addr dest, int dport, int sport,
 		int payload_len)
 {
-	uchar *pkt;
-	int eth_hdr_size;
-	int pkt_hdr_size;
-
 	/* make sure the net_tx_packet is initialized (net_init() was called) */
 	assert(net_tx_packet != NULL);
 	if (net_tx_packet == NULL)
@@ -800,16 +810,26 @@ int net_send_udp_packet(uchar *ether, struct in_addr dest, int dport, int sport,
 	if (dest.s_addr == 0)
 		dest.s_addr = 0xFFFFFFFF;
 
+	net_set_udp_header(net_tx_packet + net_eth_hdr_size(), dest, dport,
+			   sport, payload_len);
+
+	return net_send_ip_packet(ether, dest, IP_UDP_HDR_SIZE + payload_len);
+}
+
+int net_send_ip_packet(uchar *ether, struct in_addr dest, int ip_len)
+{
+	int eth_hdr_size;
+
+	/* make sure the net_tx_packet is initialized (net_init() was called) */
+	assert(net_tx_packet != NULL);
+	if (net_tx_packet == NULL)
+		return -1;
+
 	/* if broadcast, make the ether address a broadcast and don't do ARP */
 	if (dest.s_addr == 0xFFFFFFFF)
 		ether = (uchar *)net_bcast_ethaddr;
 
-	pkt = (uchar *)net_tx_packet;
-
-	eth_hdr_size = net_set_ether(pkt, ether, PROT_IP);
-	pkt += eth_hdr_size;
-	net_set_udp_header(pkt, dest, dport, sport, payload_len);
-	pkt_hdr_size = eth_hdr_size + IP_UDP_HDR_SIZE;
+	eth_hdr_size = net_set_ether(net_tx_packet, ether, PROT_IP);
 
 	/* if MAC address was not discovered yet, do an ARP request */
 	if (memcmp(ether, net_null_ethaddr, 6) == 0) {
@@ -820,7 +840,7 @@ int net_send_udp_packet(uchar *ether, struct in_addr dest, int dport, int sport,
 		arp_wait_packet_ethaddr = ether;
 
 		/* size of the waiting packet */
-		arp_wait_tx_packet_size = pkt_hdr_size + payload_len;
+		arp_wait_tx_packet_size = eth_hdr_size + ip_len;
 
 		/* and do the ARP request */
 		arp_wait_try = 1;
@@ -828,9 +848,9 @@ int net_send_udp_packet(uchar *ether, struct in_addr dest, int dport, int sport,
 		arp_request();
 		return 1;	/* waiting */
 	} else {
-		debug_cond(DEBUG_DEV_PKT, "sending UDP to %pI4/%pM\n",
+		debug_cond(DEBUG_DEV_PKT, "sending IP to %pI4/%pM\n",
 			   &dest, ether);
-		net_send_packet(net_tx_packet, pkt_hdr_size + payload_len);
+		net_send_packet(net_tx_packet, eth_hdr_size + ip_len);
 		return 0;	/* transmitted */
 	}
 }
@@ -1216,6 +1236,11 @@ void net_process_received_packet(uchar *in_packet, int len)
 		if (ip->ip_p == IPPROTO_ICMP) {
 			receive_icmp(ip, len, src_ip, et);
 			return;
+#if defined(CONFIG_PROT_TCP)
+		} else if (ip->ip_p == IPPROTO_TCP) {
+			tcp_receive((struct ip_tcp_hdr *)ip, len, src_ip);
+			return;
+#endif
 		} else if (ip->ip_p != IPPROTO_UDP) {	/* Only UDP packets */
 			return;
 		}
@@ -1317,6 +1342,9 @@ static int net_check_prereq(enum proto_t protocol)
 #endif
 #if defined(CONFIG_CMD_NFS)
 	case NFS:
+#endif
+#if defined(CONFIG_CMD_WGET)
+	case WGET:
 #endif
 		/* Fall through */
 	case TFTPGET:
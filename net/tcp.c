@@ -0,0 +1,493 @@
+/*
+ * Minimal TCP client for network boot
+ *
+ * One active-open connection at a time, enough for a download: the
+ * request is a single segment, and the payload the server sends back
+ * is handed to the application at its stream offset as soon as it is
+ * polled. Out-of-order segments are accepted in place and reported to
+ * the server with selective acknowledgments (RFC 2018), so a lost
+ * frame only costs the retransmission of that frame.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <net.h>
+#include <net/tcp.h>
+#include <asm/unaligned.h>
+
+enum tcp_state {
+	TCP_CLOSED,
+	TCP_SYN_SENT,
+	TCP_ESTABLISHED,
+};
+
+/* Retransmission timeout; doubled on every retry */
+#define TCP_RTO_MS		1000
+#define TCP_RTO_MAX_MS		8000
+#define TCP_RETRIES		8
+/* Flush a pending delayed ACK after this long without traffic */
+#define TCP_DELACK_MS		2
+
+/* SACK blocks we report; 3 fit next to the other options */
+#define TCP_SACK_BLOCKS		3
+
+#define TCPOPT_EOL		0
+#define TCPOPT_NOP		1
+#define TCPOPT_MSS		2
+#define TCPOPT_SACK_PERM	4
+#define TCPOPT_SACK		5
+
+/* Sequence number comparisons, modulo 2^32 */
+#define seq_lt(a, b)		((s32)((a) - (b)) < 0)
+#define seq_le(a, b)		((s32)((a) - (b)) <= 0)
+
+struct tcp_sack_block {
+	u32 start;
+	u32 end;
+};
+
+static enum tcp_state tcp_state;
+static const struct tcp_ops *tcp_ops;
+static struct in_addr tcp_remote_ip;
+static uchar tcp_remote_ethaddr[ARP_HLEN];
+static int tcp_remote_port;
+static int tcp_our_port;
+
+/* Our side: first unacked byte, next byte to send */
+static u32 tcp_snd_una;
+static u32 tcp_snd_nxt;
+/* The segment in flight, kept for retransmission */
+static u8 tcp_snd_flags;
+static uchar tcp_snd_buf[TCP_MSS];
+static unsigned int tcp_snd_len;
+static unsigned int tcp_snd_mss;
+
+/* Peer side: initial sequence number, next byte expected */
+static u32 tcp_irs;
+static u32 tcp_rcv_nxt;
+/* Data segments received since our last ACK */
+static int tcp_unacked;
+static int tcp_sack_ok;
+static struct tcp_sack_block tcp_sack[TCP_SACK_BLOCKS];
+static int tcp_sack_num;
+
+static int tcp_retries;
+static ulong tcp_rto;
+
+static void tcp_timeout_handler(void);
+
+static unsigned int tcp_checksum(struct ip_tcp_hdr *ip, unsigned int len)
+{
+	struct {
+		struct in_addr src;
+		struct in_addr dst;
+		u8 zero;
+		u8 proto;
+		u16 len;
+	} ph;
+	unsigned int sum;
+
+	ph.src = ip->ip_src;
+	ph.dst = ip->ip_dst;
+	ph.zero = 0;
+	ph.proto = IPPROTO_TCP;
+	ph.len = htons(len);
+	sum = compute_ip_checksum(&ph, sizeof(ph));
+
+	return add_ip_checksums(sizeof(ph), sum,
+				compute_ip_checksum(&ip->tcp_src, len));
+}
+
+static unsigned int tcp_set_options(uchar *opt, u8 flags)
+{
+	uchar *p = opt;
+	int i;
+
+	if (flags & TCP_SYN) {
+		*p++ = TCPOPT_MSS;
+		*p++ = 4;
+		*p++ = TCP_MSS >> 8;
+		*p++ = TCP_MSS & 0xff;
+		if (IS_ENABLED(CONFIG_PROT_TCP_SACK)) {
+			*p++ = TCPOPT_NOP;
+			*p++ = TCPOPT_NOP;
+			*p++ = TCPOPT_SACK_PERM;
+			*p++ = 2;
+		}
+	} else if (tcp_sack_num) {
+		*p++ = TCPOPT_NOP;
+		*p++ = TCPOPT_NOP;
+		*p++ = TCPOPT_SACK;
+		*p++ = 2 + 8 * tcp_sack_num;
+		for (i = 0; i < tcp_sack_num; i++) {
+			put_unaligned_be32(tcp_sack[i].start, p);
+			put_unaligned_be32(tcp_sack[i].end, p + 4);
+			p += 8;
+		}
+	}
+
+	return p - opt;
+}
+
+static void tcp_xmit(u8 flags, u32 seq, const void *data, unsigned int len)
+{
+	uchar *pkt = net_tx_packet + net_eth_hdr_size();
+	struct ip_tcp_hdr *ip = (struct ip_tcp_hdr *)pkt;
+	unsigned int optlen;
+	unsigned int tcp_len;
+
+	optlen = tcp_set_options(pkt + IP_TCP_HDR_SIZE, flags);
+	if (len)
+		memcpy(pkt + IP_TCP_HDR_SIZE + optlen, data, len);
+	tcp_len = TCP_HDR_SIZE + optlen + len;
+
+	net_set_ip_header(pkt, tcp_remote_ip, net_ip);
+	ip->ip_len = htons(IP_HDR_SIZE + tcp_len);
+	ip->ip_p = IPPROTO_TCP;
+	ip->ip_sum = compute_ip_checksum(ip, IP_HDR_SIZE);
+
+	ip->tcp_src = htons(tcp_our_port);
+	ip->tcp_dst = htons(tcp_remote_port);
+	ip->tcp_seq = htonl(seq);
+	ip->tcp_ack = (flags & TCP_ACK) ? htonl(tcp_rcv_nxt) : 0;
+	ip->tcp_hlen = ((TCP_HDR_SIZE + optlen) / 4) << 4;
+	ip->tcp_flags = flags;
+	ip->tcp_win = htons(TCP_RCV_WND);
+	ip->tcp_xsum = 0;
+	ip->tcp_urg = 0;
+	ip->tcp_xsum = tcp_checksum(ip, tcp_len);
+
+	if (flags & TCP_ACK)
+		tcp_unacked = 0;
+
+	net_send_ip_packet(tcp_remote_ethaddr, tcp_remote_ip,
+			   IP_HDR_SIZE + tcp_len);
+}
+
+static void tcp_send_ack(void)
+{
+	tcp_xmit(TCP_ACK, tcp_snd_nxt, NULL, 0);
+}
+
+/* (Re)send whatever occupies the sequence space [snd_una, snd_nxt) */
+static void tcp_retransmit(void)
+{
+	tcp_xmit(tcp_snd_flags, tcp_snd_una, tcp_snd_buf, tcp_snd_len);
+}
+
+static void tcp_set_timer(void)
+{
+	net_set_timeout_handler(tcp_unacked ? TCP_DELACK_MS : tcp_rto,
+				tcp_timeout_handler);
+}
+
+static void tcp_close(int err)
+{
+	tcp_state = TCP_CLOSED;
+	net_set_timeout_handler(0, NULL);
+	if (tcp_ops && tcp_ops->closed)
+		tcp_ops->closed(err);
+}
+
+static void tcp_timeout_handler(void)
+{
+	if (tcp_state == TCP_CLOSED)
+		return;
+
+	if (tcp_unacked) {
+		/* Quiet link: the burst is over, ack what we have */
+		tcp_send_ack();
+		tcp_set_timer();
+		return;
+	}
+
+	if (++tcp_retries > TCP_RETRIES) {
+		puts("\nTCP: connection timed out\n");
+		tcp_close(-ETIMEDOUT);
+		return;
+	}
+
+	tcp_rto = min_t(ulong, tcp_rto * 2, TCP_RTO_MAX_MS);
+	if (tcp_snd_una != tcp_snd_nxt)
+		tcp_retransmit();
+	else
+		/* A duplicate ACK makes the peer resend what we miss */
+		tcp_send_ack();
+	tcp_set_timer();
+}
+
+/* Remember [start, end) as received beyond a hole */
+static void tcp_sack_add(u32 start, u32 end)
+{
+	struct tcp_sack_block blk = { start, end };
+	int i, n = 0;
+
+	/* Merge with any block it touches; the new one goes first */
+	for (i = 0; i < tcp_sack_num; i++) {
+		struct tcp_sack_block *b = &tcp_sack[i];
+
+		if (seq_le(b->start, blk.end) && seq_le(blk.start, b->end)) {
+			if (seq_lt(b->start, blk.start))
+				blk.start = b->start;
+			if (seq_lt(blk.end, b->end))
+				blk.end = b->end;
+		} else {
+			tcp_sack[n++] = *b;
+		}
+	}
+	if (n == TCP_SACK_BLOCKS)
+		n--;
+	memmove(&tcp_sack[1], &tcp_sack[0], n * sizeof(*tcp_sack));
+	tcp_sack[0] = blk;
+	tcp_sack_num = n + 1;
+}
+
+/* rcv_nxt moved: swallow the blocks it reached */
+static void tcp_sack_advance(void)
+{
+	int i, n, again;
+
+	do {
+		again = 0;
+		for (i = 0, n = 0; i < tcp_sack_num; i++) {
+			struct tcp_sack_block *b = &tcp_sack[i];
+
+			if (seq_le(b->start, tcp_rcv_nxt)) {
+				if (seq_lt(tcp_rcv_nxt, b->end)) {
+					tcp_rcv_nxt = b->end;
+					again = 1;
+				}
+			} else {
+				tcp_sack[n++] = *b;
+			}
+		}
+		tcp_sack_num = n;
+	} while (again);
+}
+
+static void tcp_parse_options(uchar *opt, int len)
+{
+	while (len > 0) {
+		int olen;
+
+		if (opt[0] == TCPOPT_EOL)
+			break;
+		if (opt[0] == TCPOPT_NOP) {
+			opt++;
+			len--;
+			continue;
+		}
+		if (len < 2)
+			break;
+		olen = opt[1];
+		if (olen < 2 || olen > len)
+			break;
+
+		if (opt[0] == TCPOPT_MSS && olen == 4) {
+			unsigned int mss = get_unaligned_be16(opt + 2);
+
+			if (mss && mss < tcp_snd_mss)
+				tcp_snd_mss = mss;
+		} else if (opt[0] == TCPOPT_SACK_PERM && olen == 2) {
+			tcp_sack_ok = IS_ENABLED(CONFIG_PROT_TCP_SACK);
+		}
+		opt += olen;
+		len -= olen;
+	}
+}
+
+/*
+ * Handle payload at @seq. Returns 1 if an ACK must go out now, i.e.
+ * the segment was out of order, filled a hole, or was a duplicate.
+ */
+static int tcp_rx_data(u32 seq, uchar *data, unsigned int len)
+{
+	u32 end = seq + len;
+
+	/* Drop what we already have */
+	if (seq_le(end, tcp_rcv_nxt))
+		return 1;
+	if (seq_lt(seq, tcp_rcv_nxt)) {
+		data += tcp_rcv_nxt - seq;
+		len -= tcp_rcv_nxt - seq;
+		seq = tcp_rcv_nxt;
+	}
+	/* Nor anything beyond the window we offered */
+	if (!seq_lt(seq, tcp_rcv_nxt + TCP_RCV_WND))
+		return 1;
+
+	if (seq != tcp_rcv_nxt) {
+		if (!tcp_sack_ok)
+			return 1;
+		if (tcp_ops->rx(seq - tcp_irs - 1, data, len) == 0)
+			tcp_sack_add(seq, end);
+		return 1;
+	}
+
+	if (tcp_ops->rx(seq - tcp_irs - 1, data, len))
+		return 1;
+	tcp_rcv_nxt = end;
+	if (tcp_sack_num) {
+		tcp_sack_advance();
+		return 1;
+	}
+
+	return 0;
+}
+
+void tcp_receive(struct ip_tcp_hdr *ip, unsigned int len,
+		 struct in_addr src)
+{
+	unsigned int hlen;
+	unsigned int dlen;
+	u32 seq, ack;
+	u8 flags;
+	int ack_now = 0;
+
+	if (tcp_state == TCP_CLOSED || len < IP_TCP_HDR_SIZE)
+		return;
+	if (src.s_addr != tcp_remote_ip.s_addr ||
+	    ntohs(ip->tcp_src) != tcp_remote_port ||
+	    ntohs(ip->tcp_dst) != tcp_our_port)
+		return;
+
+	hlen = (ip->tcp_hlen >> 4) * 4;
+	if (hlen < TCP_HDR_SIZE || IP_HDR_SIZE + hlen > len)
+		return;
+	if (tcp_checksum(ip, len - IP_HDR_SIZE)) {
+		debug("TCP: bad checksum\n");
+		return;
+	}
+
+	flags = ip->tcp_flags;
+	seq = ntohl(ip->tcp_seq);
+	ack = ntohl(ip->tcp_ack);
+	dlen = len - IP_HDR_SIZE - hlen;
+
+	if (flags & TCP_RST) {
+		if (tcp_state == TCP_SYN_SENT ? ack == tcp_snd_nxt :
+		    seq == tcp_rcv_nxt) {
+			puts("\nTCP: connection reset by peer\n");
+			tcp_close(-ECONNRESET);
+		}
+		return;
+	}
+
+	if (tcp_state == TCP_SYN_SENT) {
+		if ((flags & (TCP_SYN | TCP_ACK)) != (TCP_SYN | TCP_ACK) ||
+		    ack != tcp_snd_nxt)
+			return;
+		tcp_irs = seq;
+		tcp_rcv_nxt = seq + 1;
+		tcp_snd_una = ack;
+		tcp_snd_flags = TCP_ACK;
+		tcp_parse_options((uchar *)ip + IP_TCP_HDR_SIZE,
+				  hlen - TCP_HDR_SIZE);
+		tcp_state = TCP_ESTABLISHED;
+		tcp_retries = 0;
+		tcp_rto = TCP_RTO_MS;
+		tcp_send_ack();
+		tcp_set_timer();
+		if (tcp_ops->connected)
+			tcp_ops->connected();
+		return;
+	}
+
+	/* Our ACK of the SYN got lost */
+	if (flags & TCP_SYN) {
+		if (seq == tcp_irs)
+			tcp_send_ack();
+		return;
+	}
+	if (!(flags & TCP_ACK))
+		return;
+
+	tcp_retries = 0;
+	tcp_rto = TCP_RTO_MS;
+	if (seq_lt(tcp_snd_una, ack) && seq_le(ack, tcp_snd_nxt))
+		tcp_snd_una = ack;
+
+	if (dlen) {
+		ack_now = tcp_rx_data(seq, (uchar *)ip + IP_HDR_SIZE + hlen,
+				      dlen);
+		if (tcp_state == TCP_CLOSED)
+			return;
+		tcp_unacked++;
+		if (flags & TCP_PSH)
+			ack_now = 1;
+	}
+
+	if ((flags & TCP_FIN) && seq + dlen == tcp_rcv_nxt) {
+		/* All data is in; answer with our own FIN and be done */
+		tcp_rcv_nxt++;
+		tcp_xmit(TCP_FIN | TCP_ACK, tcp_snd_nxt, NULL, 0);
+		tcp_close(0);
+		return;
+	}
+
+	/* Ack every second full-sized segment, as RFC 1122 allows */
+	if (ack_now || tcp_unacked >= 2)
+		tcp_send_ack();
+	tcp_set_timer();
+}
+
+void tcp_connect(struct in_addr dest, int dport, const struct tcp_ops *ops)
+{
+	tcp_init();
+	tcp_ops = ops;
+	tcp_remote_ip = dest;
+	tcp_remote_port = dport;
+	/* Use a pseudo-random port and initial sequence number */
+	tcp_our_port = 1024 + (get_timer(0) % 3072);
+	tcp_snd_una = (u32)get_ticks();
+	tcp_snd_nxt = tcp_snd_una + 1;
+	tcp_snd_flags = TCP_SYN;
+	tcp_snd_len = 0;
+	tcp_snd_mss = TCP_MSS;
+	tcp_rto = TCP_RTO_MS;
+	tcp_state = TCP_SYN_SENT;
+
+	tcp_retransmit();
+	tcp_set_timer();
+}
+
+int tcp_send(const void *data, unsigned int len)
+{
+	if (tcp_state != TCP_ESTABLISHED)
+		return -ENOTCONN;
+	if (tcp_snd_una != tcp_snd_nxt)
+		return -EBUSY;
+	if (len > tcp_snd_mss)
+		return -E2BIG;
+
+	memcpy(tcp_snd_buf, data, len);
+	tcp_snd_len = len;
+	tcp_snd_flags = TCP_ACK | TCP_PSH;
+	tcp_snd_nxt += len;
+	tcp_retries = 0;
+	tcp_retransmit();
+	tcp_set_timer();
+
+	return 0;
+}
+
+void tcp_abort(void)
+{
+	if (tcp_state == TCP_CLOSED)
+		return;
+	tcp_xmit(TCP_RST | TCP_ACK, tcp_snd_nxt, NULL, 0);
+	tcp_state = TCP_CLOSED;
+	net_set_timeout_handler(0, NULL);
+}
+
+void tcp_init(void)
+{
+	tcp_state = TCP_CLOSED;
+	tcp_ops = NULL;
+	tcp_unacked = 0;
+	tcp_retries = 0;
+	tcp_sack_ok = 0;
+	tcp_sack_num = 0;
+	memset(tcp_remote_ethaddr, 0, sizeof(tcp_remote_ethaddr));
+}
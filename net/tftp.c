@@ -134,6 +134,25 @@ static char tftp_filename[MAX_LEN];
 static unsigned short tftp_block_size = TFTP_BLOCK_SIZE;
 static unsigned short tftp_block_size_option = TFTP_MTU_BLOCKSIZE;
 
+/*
+ * RFC 7440 windowsize: the server sends this many blocks back to back
+ * and we only ACK the last one, which hides the round trip per block.
+ * tftp_windowsize is what the server agreed to; it stays 1 (lock-step)
+ * unless the OACK carries the option.
+ */
+#ifdef CONFIG_TFTP_WINDOWSIZE
+#define TFTP_WINDOWSIZE CONFIG_TFTP_WINDOWSIZE
+#else
+#define TFTP_WINDOWSIZE 1
+#endif
+
+static unsigned short tftp_windowsize = 1;
+static unsigned short tftp_windowsize_option = TFTP_WINDOWSIZE;
+/* in-order blocks received since we last sent an ACK */
+static unsigned short tftp_window_pos;
+/* 1 if we already asked the server to restart the current window */
+static int tftp_window_nacked;
+
 #ifdef CONFIG_MCAST_TFTP
 #include <malloc.h>
 #define MTFTP_BITMAPSIZE	0x1000
@@ -209,6 +228,8 @@ static inline void store_block(int block, uchar *src, unsigned len)
 static void new_transfer(void)
 {
 	tftp_prev_block = 0;
+	tftp_window_pos = 0;
+	tftp_window_nacked = 0;
 	tftp_block_wrap = 0;
 	tftp_block_wrap_offset = 0;
 #ifdef CONFIG_CMD_TFTPPUT
@@ -372,6 +393,9 @@ static void tftp_send(void)
 		/* try for more effic. blk size */
 		pkt += sprintf((char *)pkt, "blksize%c%d%c",
 				0, tftp_block_size_option, 0);
+		if (tftp_windowsize_option > 1)
+			pkt += sprintf((char *)pkt, "windowsize%c%d%c",
+					0, tftp_windowsize_option, 0);
 #ifdef CONFIG_MCAST_TFTP
 		/* Check all preconditions before even trying the option */
 		if (!tftp_mcast_disabled) {
@@ -404,6 +428,7 @@ static void tftp_send(void)
 		s[0] = htons(TFTP_ACK);
 		s[1] = htons(tftp_cur_block);
 		pkt = (uchar *)(s + 2);
+		tftp_window_pos = 0;
 #ifdef CONFIG_CMD_TFTPPUT
 		if (tftp_put_active) {
 			int toload = tftp_block_size;
@@ -540,6 +565,16 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 				debug("Blocksize ack: %s, %d\n",
 				      (char *)pkt + i + 8, tftp_block_size);
 			}
+			if (strcmp((char *)pkt + i, "windowsize") == 0) {
+				tftp_windowsize = (unsigned short)
+					simple_strtoul((char *)pkt + i + 11,
+						       NULL, 10);
+				if (!tftp_windowsize ||
+				    tftp_windowsize > tftp_windowsize_option)
+					tftp_windowsize = 1;
+				debug("Windowsize ack: %s, %d\n",
+				      (char *)pkt + i + 11, tftp_windowsize);
+			}
 #ifdef CONFIG_TFTP_TSIZE
 			if (strcmp((char *)pkt+i, "tsize") == 0) {
 				tftp_tsize = simple_strtoul((char *)pkt + i + 6,
@@ -551,6 +586,9 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		}
 #ifdef CONFIG_MCAST_TFTP
 		parse_multicast_oack((char *)pkt, len - 1);
+		/* multicast has its own recovery scheme, keep lock-step */
+		if (tftp_mcast_active)
+			tftp_windowsize = 1;
 		if ((tftp_mcast_active) && (!tftp_mcast_master_client))
 			tftp_state = STATE_DATA;	/* passive.. */
 		else
@@ -568,6 +606,26 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		if (len < 2)
 			return;
 		len -= 2;
+
+		/*
+		 * With a window open, anything but the next block in
+		 * sequence means a block went missing: ACK the last good
+		 * one (once) so the server restarts the window from there.
+		 * tftp_cur_block still holds that block number.
+		 */
+		if (tftp_state == STATE_DATA && tftp_windowsize > 1 &&
+		    ntohs(*(__be16 *)pkt) !=
+		    (unsigned short)(tftp_prev_block + 1)) {
+			debug("Out of order block %d, expected %d\n",
+			      ntohs(*(__be16 *)pkt),
+			      (unsigned short)(tftp_prev_block + 1));
+			if (!tftp_window_nacked) {
+				tftp_window_nacked = 1;
+				tftp_send();
+			}
+			break;
+		}
+
 		tftp_cur_block = ntohs(*(__be16 *)pkt);
 
 		update_block_number();
@@ -603,11 +661,20 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		}
 
 		tftp_prev_block = tftp_cur_block;
+		tftp_window_nacked = 0;
 		timeout_count_max = tftp_timeout_count_max;
 		net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
 
 		store_block(tftp_cur_block - 1, pkt + 2, len);
 
+		/*
+		 * Inside a window only the last block, or the short block
+		 * that ends the file, is acknowledged.
+		 */
+		if (++tftp_window_pos < tftp_windowsize &&
+		    len == tftp_block_size)
+			break;
+
 		/*
 		 *	Acknowledge the block just received, which will prompt
 		 *	the remote for the next one.
@@ -710,6 +777,18 @@ void tftp_start(enum proto_t protocol)
 	if (ep != NULL)
 		tftp_block_size_option = simple_strtol(ep, NULL, 10);
 
+	ep = env_get("tftpwindowsize");
+	if (ep != NULL) {
+		long windowsize = simple_strtol(ep, NULL, 10);
+
+		/* RFC 7440 allows 1 to 65535 blocks */
+		if (windowsize < 1 || windowsize > 65535)
+			printf("TFTP windowsize (%ld) out of range 1..65535, ignored\n",
+			       windowsize);
+		else
+			tftp_windowsize_option = windowsize;
+	}
+
 	ep = env_get("tftptimeout");
 	if (ep != NULL)
 		timeout_ms = simple_strtol(ep, NULL, 10);
@@ -731,8 +810,8 @@ void tftp_start(enum proto_t protocol)
 	}
 #endif
 
-	debug("TFTP blocksize = %i, timeout = %ld ms\n",
-	      tftp_block_size_option, timeout_ms);
+	debug("TFTP blocksize = %i, windowsize = %i, timeout = %ld ms\n",
+	      tftp_block_size_option, tftp_windowsize_option, timeout_ms);
 
 	tftp_remote_ip = net_server_ip;
 	if (net_boot_file_name[0] == '\0') {
@@ -835,8 +914,9 @@ void tftp_start(enum proto_t protocol)
 
 	/* zero out server ether in case the server ip has changed */
 	memset(net_server_ethaddr, 0, 6);
-	/* Revert tftp_block_size to dflt */
+	/* Revert tftp_block_size and tftp_windowsize to dflt */
 	tftp_block_size = TFTP_BLOCK_SIZE;
+	tftp_windowsize = 1;
 #ifdef CONFIG_MCAST_TFTP
 	mcast_cleanup();
 #endif
@@ -864,8 +944,9 @@ void tftp_start_server(void)
 	timeout_ms = TIMEOUT;
 	net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
 
-	/* Revert tftp_block_size to dflt */
+	/* Revert tftp_block_size and tftp_windowsize to dflt */
 	tftp_block_size = TFTP_BLOCK_SIZE;
+	tftp_windowsize = 1;
 	tftp_cur_block = 0;
 	tftp_our_port = WELL_KNOWN_PORT;
 
@@ -0,0 +1,239 @@
+/*
+ * HTTP download over TCP
+ *
+ * Fetches net_boot_file_name from the server with a single HTTP/1.1 GET
+ * and writes the body to load_addr. The body is copied to its final
+ * place straight out of the receive buffer, including segments that
+ * arrive ahead of a lost one, so a drop costs one retransmission and
+ * no extra copy.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <mapmem.h>
+#include <net.h>
+#include <net/tcp.h>
+#include <net/wget.h>
+
+/* Well known HTTP port # */
+#define HTTP_PORT		80
+/* Number of "loading" hashes per line, and bytes per hash */
+#define HASHES_PER_LINE		65
+#define HASH_BYTES		(64 * 1024)
+/* Response status line and headers must fit in here */
+#define HTTP_HDR_MAX		2048
+
+static struct in_addr wget_server_ip;
+static int wget_server_port;
+static char wget_filename[256];
+static ulong time_start;
+
+static char http_hdr[HTTP_HDR_MAX + 1];
+static unsigned int http_hdr_len;
+/* Stream offset of the first body byte, 0 until the headers are in */
+static u32 http_body_start;
+/* Content-Length, or -1 if the server did not send one */
+static long http_content_len;
+static ulong wget_hashes;
+
+static void wget_fail(const char *msg)
+{
+	printf("\nHTTP error: %s\n", msg);
+	tcp_abort();
+	eth_halt();
+	net_set_state(NETLOOP_FAIL);
+}
+
+static void wget_connected(void)
+{
+	char req[sizeof(wget_filename) + 128];
+	int len;
+
+	len = snprintf(req, sizeof(req),
+		       "GET %s HTTP/1.1\r\n"
+		       "Host: %pI4\r\n"
+		       "User-Agent: U-Boot\r\n"
+		       "Connection: close\r\n"
+		       "\r\n", wget_filename, &wget_server_ip);
+	if (tcp_send(req, len))
+		wget_fail("cannot send request");
+}
+
+/* Returns the value of header @name, or NULL */
+static char *http_header(const char *name)
+{
+	size_t len = strlen(name);
+	char *p = strstr(http_hdr, "\r\n");
+
+	while (p && p[2] != '\r') {
+		p += 2;
+		if (!strncasecmp(p, name, len) && p[len] == ':') {
+			p += len + 1;
+			while (*p == ' ' || *p == '\t')
+				p++;
+			return p;
+		}
+		p = strstr(p, "\r\n");
+	}
+
+	return NULL;
+}
+
+static int http_parse_headers(void)
+{
+	char *p;
+
+	/* "HTTP/1.x 200 OK" */
+	if (strncmp(http_hdr, "HTTP/1.", 7) || !(p = strchr(http_hdr, ' '))) {
+		wget_fail("bad response");
+		return -EINVAL;
+	}
+	if (simple_strtoul(p + 1, NULL, 10) != 200) {
+		*strstr(p, "\r\n") = '\0';
+		wget_fail(p + 1);
+		return -ENOENT;
+	}
+
+	p = http_header("Transfer-Encoding");
+	if (p && strncasecmp(p, "identity", 8)) {
+		wget_fail("unsupported transfer encoding");
+		return -EINVAL;
+	}
+
+	p = http_header("Content-Length");
+	http_content_len = p ? simple_strtol(p, NULL, 10) : -1;
+
+	return 0;
+}
+
+static void wget_store(u32 offset, uchar *src, unsigned int len)
+{
+	ulong newsize = offset + len;
+	void *ptr = map_sysmem(load_addr + offset, len);
+
+	memcpy(ptr, src, len);
+	unmap_sysmem(ptr);
+
+	if (net_boot_file_size < newsize) {
+		net_boot_file_size = newsize;
+		while (wget_hashes < newsize / HASH_BYTES) {
+			putc('#');
+			if (!(++wget_hashes % HASHES_PER_LINE))
+				puts("\n\t ");
+		}
+	}
+}
+
+static int wget_rx(u32 offset, uchar *data, unsigned int len)
+{
+	if (!http_body_start) {
+		unsigned int from, n;
+		char *end;
+
+		/* Headers are parsed in order; have the rest resent */
+		if (offset != http_hdr_len)
+			return -EAGAIN;
+
+		n = min_t(unsigned int, len, HTTP_HDR_MAX - http_hdr_len);
+		memcpy(http_hdr + http_hdr_len, data, n);
+		from = http_hdr_len > 3 ? http_hdr_len - 3 : 0;
+		http_hdr_len += n;
+		http_hdr[http_hdr_len] = '\0';
+
+		end = strstr(http_hdr + from, "\r\n\r\n");
+		if (!end) {
+			if (http_hdr_len == HTTP_HDR_MAX) {
+				wget_fail("response headers too large");
+				return -E2BIG;
+			}
+			return 0;
+		}
+		end[2] = '\0';
+		http_body_start = end + 4 - http_hdr;
+		if (http_parse_headers())
+			return -EINVAL;
+	}
+
+	if (offset + len <= http_body_start)
+		return 0;
+	if (offset < http_body_start) {
+		data += http_body_start - offset;
+		len -= http_body_start - offset;
+		offset = http_body_start;
+	}
+	wget_store(offset - http_body_start, data, len);
+
+	return 0;
+}
+
+static void wget_closed(int err)
+{
+	if (err) {
+		puts("Starting again\n\n");
+		net_start_again();
+		return;
+	}
+	if (!http_body_start) {
+		wget_fail("connection closed before response");
+		return;
+	}
+	if (http_content_len >= 0 && net_boot_file_size != http_content_len) {
+		wget_fail("connection closed before end of file");
+		return;
+	}
+
+	time_start = get_timer(time_start);
+	if (time_start > 0) {
+		puts("\n\t ");	/* Line up with "Loading: " */
+		print_size(net_boot_file_size / time_start * 1000, "/s");
+	}
+	puts("\ndone\n");
+	net_set_state(NETLOOP_SUCCESS);
+}
+
+static const struct tcp_ops wget_ops = {
+	.connected	= wget_connected,
+	.rx		= wget_rx,
+	.closed		= wget_closed,
+};
+
+void wget_start(void)
+{
+	char *p;
+
+	wget_server_ip = net_server_ip;
+	p = strchr(net_boot_file_name, ':');
+	if (p) {
+		wget_server_ip = string_to_ip(net_boot_file_name);
+		p++;
+	} else {
+		p = net_boot_file_name;
+	}
+	if (*p == '/')
+		strncpy(wget_filename, p, sizeof(wget_filename));
+	else
+		snprintf(wget_filename, sizeof(wget_filename), "/%s", p);
+	wget_filename[sizeof(wget_filename) - 1] = 0;
+
+	wget_server_port = HTTP_PORT;
+	p = env_get("httpdstp");
+	if (p)
+		wget_server_port = simple_strtol(p, NULL, 10);
+
+	printf("Using %s device\n", eth_get_name());
+	printf("HTTP from server %pI4:%d; our IP address is %pI4\n",
+	       &wget_server_ip, wget_server_port, &net_ip);
+	printf("Filename '%s'.\n", wget_filename);
+	printf("Load address: 0x%lx\n", load_addr);
+	puts("Loading: *\b");
+
+	http_hdr_len = 0;
+	http_body_start = 0;
+	http_content_len = -1;
+	wget_hashes = 0;
+	time_start = get_timer(0);
+
+	tcp_connect(wget_server_ip, wget_server_port, &wget_ops);
+}
@@ -13,6 +13,11 @@
 # clusters. Since this patch needed to correctly handle non-contiguous files,
 # this test was written to validate that.
 #
+# The file is also read in two pieces at an offset that is not cluster
+# aligned, which goes through the cluster chain map cached by the first
+# read, and once more after binding a second image with other contents,
+# which must not be served from that map.
+#
 # To execute the test, simply run it from the U-Boot source root directory:
 #
 #    cd u-boot
@@ -43,6 +48,7 @@
 #    crc32 for 00001000 ... 02008743 ==> 6a080523
 #    => if itest.l *0 != 2305086a; then echo FAILURE; else echo PASS; fi
 #    PASS
+#    ...
 #    => reset
 #
 # All temporary files used by this script are created in ./sandbox to avoid
@@ -55,12 +61,16 @@
 
 odir=sandbox
 img=${odir}/fat-noncontig.img
+img2=${odir}/fat-noncontig-2.img
 mnt=${odir}/mnt
 fill=/dev/urandom
 testfn=noncontig.img
 mnttestfn=${mnt}/${testfn}
 crcaddr=0
 loadaddr=1000
+# Not a multiple of the cluster size
+half=1000001
+loadaddr2=`printf %x $((0x${loadaddr} + 0x${half}))`
 
 for prereq in fallocate mkfs.fat dd crc32; do
     if [ ! -x "`which $prereq`" ]; then
@@ -72,23 +82,29 @@ done
 make O=${odir} -s sandbox_defconfig && make O=${odir} -s -j8
 
 mkdir -p ${mnt}
-if [ ! -f ${img} ]; then
-    fallocate -l 40M ${img}
+
+# Create FAT image $1 holding a non-contiguous test file
+mkimg() {
+    if [ -f $1 ]; then
+        return
+    fi
+
+    fallocate -l 40M $1
     if [ $? -ne 0 ]; then
         echo fallocate failed - using dd instead
-        dd if=/dev/zero of=${img} bs=1024 count=$((40 * 1024))
+        dd if=/dev/zero of=$1 bs=1024 count=$((40 * 1024))
         if [ $? -ne 0 ]; then
             echo Could not create empty disk image
             exit $?
         fi
     fi
-    mkfs.fat ${img}
+    mkfs.fat $1
     if [ $? -ne 0 ]; then
         echo Could not create FAT filesystem
         exit $?
     fi
 
-    sudo mount -o loop,uid=$(id -u) ${img} ${mnt}
+    sudo mount -o loop,uid=$(id -u) $1 ${mnt}
     if [ $? -ne 0 ]; then
         echo Could not mount test filesystem
         exit $?
@@ -112,31 +128,50 @@ if [ ! -f ${img} ]; then
         echo Could not unmount test filesystem
         exit $?
     fi
-fi
+}
 
-sudo mount -o ro,loop,uid=$(id -u) ${img} ${mnt}
-if [ $? -ne 0 ]; then
-    echo Could not mount test filesystem
-    exit $?
-fi
-crc=0x`crc32 ${mnttestfn}`
-sudo umount ${mnt}
-if [ $? -ne 0 ]; then
-    echo Could not unmount test filesystem
-    exit $?
-fi
+# Print the CRC of the test file in image $1, as stored by crc32 in memory
+imgcrc() {
+    sudo mount -o ro,loop,uid=$(id -u) $1 ${mnt}
+    if [ $? -ne 0 ]; then
+        echo Could not mount test filesystem >&2
+        exit $?
+    fi
+    crc=0x`crc32 ${mnttestfn}`
+    sudo umount ${mnt}
+    if [ $? -ne 0 ]; then
+        echo Could not unmount test filesystem >&2
+        exit $?
+    fi
+
+    printf %02x%02x%02x%02x \
+        $((${crc} & 0xff)) \
+        $(((${crc} >> 8) & 0xff)) \
+        $(((${crc} >> 16) & 0xff)) \
+        $((${crc} >> 24))
+}
 
-crc=`printf %02x%02x%02x%02x \
-    $((${crc} & 0xff)) \
-    $(((${crc} >> 8) & 0xff)) \
-    $(((${crc} >> 16) & 0xff)) \
-    $((${crc} >> 24))`
+mkimg ${img}
+mkimg ${img2}
+crc=`imgcrc ${img}` || exit $?
+crc2=`imgcrc ${img2}` || exit $?
 
 ./sandbox/u-boot << EOF
 host bind 0 ${img}
 load host 0:0 ${loadaddr} ${testfn}
 crc32 ${loadaddr} \$filesize ${crcaddr}
 if itest.l *${crcaddr} != ${crc}; then echo FAILURE; else echo PASS; fi
+size host 0:0 ${testfn}
+setenv size \$filesize
+mw.b ${loadaddr} 0 \$size
+load host 0:0 ${loadaddr} ${testfn} ${half} 0
+load host 0:0 ${loadaddr2} ${testfn} 0 ${half}
+crc32 ${loadaddr} \$size ${crcaddr}
+if itest.l *${crcaddr} != ${crc}; then echo FAILURE; else echo PASS; fi
+host bind 0 ${img2}
+load host 0:0 ${loadaddr} ${testfn}
+crc32 ${loadaddr} \$filesize ${crcaddr}
+if itest.l *${crcaddr} != ${crc2}; then echo FAILURE; else echo PASS; fi
 reset
 EOF
 if [ $? -ne 0 ]; then